@@ -0,0 +1,155 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#include "actionscanner.h"
+
+namespace {
+
+class Cursor
+{
+public:
+    explicit Cursor(std::string_view text) : m_text(text) {}
+
+    bool consume(char c)
+    {
+        skipSpace();
+        if (m_pos < m_text.size() and m_text[m_pos] == c)
+        {
+            ++m_pos;
+            return true;
+        }
+        return false;
+    }
+
+    // A string that needs no unescaping, out points into the text
+    bool plainString(std::string_view& out)
+    {
+        if (not consume('"'))
+        {
+            return false;
+        }
+        const size_t start = m_pos;
+        for (; m_pos < m_text.size(); ++m_pos)
+        {
+            const unsigned char c = static_cast<unsigned char>(m_text[m_pos]);
+            if (c == '"')
+            {
+                out = m_text.substr(start, m_pos - start);
+                ++m_pos;
+                return true;
+            }
+            if (c == '\\' or c < 0x20)
+            {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    // Digits only, no leading zero, at most 19 of them so the value never overflows
+    bool unsignedNumber(uint64_t& value)
+    {
+        skipSpace();
+        const size_t start = m_pos;
+        value = 0;
+        while (m_pos < m_text.size() and m_text[m_pos] >= '0' and m_text[m_pos] <= '9')
+        {
+            value = value * 10 + static_cast<uint64_t>(m_text[m_pos] - '0');
+            ++m_pos;
+        }
+        const size_t digits = m_pos - start;
+        return digits > 0 and digits <= 19 and (digits == 1 or m_text[start] != '0');
+    }
+
+    bool atEnd()
+    {
+        skipSpace();
+        return m_pos == m_text.size();
+    }
+
+private:
+    std::string_view m_text;
+    size_t m_pos = 0;
+
+    // The whitespace crow::json skips
+    void skipSpace()
+    {
+        while (m_pos < m_text.size() and (m_text[m_pos] == ' ' or m_text[m_pos] == '\t' or
+                                          m_text[m_pos] == '\r' or m_text[m_pos] == '\n'))
+        {
+            ++m_pos;
+        }
+    }
+};
+
+} // namespace
+
+bool ActionScanner::scan(std::string_view text, BinaryProtocol::Action &action)
+{
+    Cursor cursor(text);
+    std::string_view name;
+    std::string_view dataKey;
+    uint64_t value = 0;
+    bool hasAction = false;
+    bool hasData = false;
+
+    if (not cursor.consume('{'))
+    {
+        return false;
+    }
+    for (int member = 0; member < 2; ++member)
+    {
+        std::string_view key;
+        if ((member == 1 and not cursor.consume(',')) or not cursor.plainString(key) or not cursor.consume(':'))
+        {
+            return false;
+        }
+
+        if (key == "action" and not hasAction)
+        {
+            if (not cursor.plainString(name))
+            {
+                return false;
+            }
+            hasAction = true;
+        }
+        else if (key == "data" and not hasData)
+        {
+            if (not cursor.consume('{') or not cursor.plainString(dataKey) or not cursor.consume(':') or
+                not cursor.unsignedNumber(value) or not cursor.consume('}'))
+            {
+                return false;
+            }
+            hasData = true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    if (not cursor.consume('}') or not cursor.atEnd())
+    {
+        return false;
+    }
+
+    if (name == "confirm_chunk" and dataKey == "index")
+    {
+        action.type = BinaryProtocol::ActionType::confirmChunk;
+    }
+    else if (name == "get_chunk" and dataKey == "index")
+    {
+        action.type = BinaryProtocol::ActionType::getChunk;
+    }
+    else if (name == "ack" and dataKey == "id")
+    {
+        action.type = BinaryProtocol::ActionType::ack;
+    }
+    else
+    {
+        return false;
+    }
+    action.value = value;
+    action.payload = {};
+    return true;
+}
@@ -0,0 +1,26 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#pragma once
+
+#include "binaryprotocol.h"
+
+#include <string_view>
+
+/*
+ * Recognizes the frequent JSON actions without building a crow::json tree:
+ *   {"action": "confirm_chunk", "data": {"index": N}}
+ *   {"action": "get_chunk", "data": {"index": N}}
+ *   {"action": "ack", "data": {"id": N}}
+ * The keys may come in any order and with any JSON whitespace. Anything
+ * else (escapes, extra or repeated keys, N not a plain unsigned integer
+ * of up to 19 digits...) is left to the generic parser, so an accepted
+ * message always means what crow::json would make of it.
+ */
+namespace ActionScanner {
+
+// The action as BinaryProtocol decodes it: confirmChunk, getChunk or ack with its value
+bool scan(std::string_view text, BinaryProtocol::Action& action);
+
+} // namespace ActionScanner
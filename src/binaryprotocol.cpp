@@ -0,0 +1,74 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#include "binaryprotocol.h"
+
+bool BinaryProtocol::parseAction(std::string_view frame, Action &action)
+{
+    if (frame.empty())
+    {
+        return false;
+    }
+
+    action.type = static_cast<ActionType>(frame.front());
+    frame.remove_prefix(1);
+    action.value = 0;
+    action.payload = {};
+
+    switch (action.type)
+    {
+    case ActionType::chunk:
+        return frame.empty();
+    case ActionType::json:
+        action.payload = frame;
+        return true;
+    case ActionType::confirmChunk:
+    case ActionType::getChunk:
+    case ActionType::ack:
+        return readVarint(frame, action.value) and frame.empty();
+    }
+    return false;
+}
+
+std::string BinaryProtocol::header(EventType type)
+{
+    return std::string(1, static_cast<char>(type));
+}
+
+void BinaryProtocol::appendVarint(std::string &out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void BinaryProtocol::appendString(std::string &out, std::string_view text)
+{
+    appendVarint(out, text.size());
+    out.append(text);
+}
+
+bool BinaryProtocol::readVarint(std::string_view &in, uint64_t &value)
+{
+    value = 0;
+    for (size_t i = 0; i < in.size() and i < 10; ++i)
+    {
+        const auto byte = static_cast<uint8_t>(in[i]);
+        // the 10th byte holds the last bit of a 64-bit value
+        if (i == 9 and byte > 1)
+        {
+            return false;
+        }
+        value |= uint64_t(byte & 0x7f) << (7 * i);
+        if ((byte & 0x80) == 0)
+        {
+            in.remove_prefix(i + 1);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,66 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*
+ * Compact binary framing of the WebSocket messages, for native clients.
+ * A client asks for it with "Sec-WebSocket-Protocol: pip.binary.v1",
+ * JSON text frames stay the default.
+ *
+ * Every message is then a binary frame: a type byte and the fields,
+ * integers as unsigned LEB128 varints, strings as a varint length and
+ * the bytes, flags as one byte. The messages without a binary form keep
+ * their JSON text after the "json" type byte. An uploaded chunk is not
+ * tagged: a "chunk" action announces it and the next binary frame is the
+ * chunk as is, so it goes into the session buffer without being moved.
+ */
+namespace BinaryProtocol {
+
+inline constexpr char SUBPROTOCOL[] = "pip.binary.v1";
+
+// Client -> server
+enum class ActionType : uint8_t
+{
+    chunk        = 0x00, // no fields, the next binary frame is the chunk (sender only)
+    confirmChunk = 0x01, // varint index
+    getChunk     = 0x02, // varint index
+    ack          = 0x03, // varint event id
+    json         = 0x7f  // any other action: {"action": ..., "data": ...}
+};
+
+// Server -> client
+enum class EventType : uint8_t
+{
+    chunk            = 0x00, // chunk data (get_chunk reply)
+    newChunk         = 0x01, // varint index, varint size
+    chunkDownload    = 0x02, // string id, varint index, flag started
+    bytesCount       = 0x03, // varint value, flag from_sender
+    personalReceived = 0x04, // varint bytes
+    chunksRemoved    = 0x05, // varint count, varint index...
+    newChunkAllowed  = 0x06, // flag status, flag memory_budget
+    json             = 0x7f  // any other event, as JSON text
+};
+
+struct Action
+{
+    ActionType type = ActionType::json;
+    uint64_t value = 0;        // index or event id
+    std::string_view payload;  // JSON text, points into the frame
+};
+
+// false on an unknown type, a truncated field or bytes after the last field
+bool parseAction(std::string_view frame, Action& action);
+
+std::string header(EventType type);
+void appendVarint(std::string& out, uint64_t value);
+void appendString(std::string& out, std::string_view text);
+// Consumes the varint from the front of in; false if it is truncated or too long
+bool readVarint(std::string_view& in, uint64_t& value);
+
+} // namespace BinaryProtocol
@@ -5,22 +5,55 @@
 #include "buffer.h"
 #include "config/config.h"
 #include "chunk.h"
+#include "chunkmemorypool.h"
 
 #include "log.h"
 
 #include <mutex>
 #include <shared_mutex>
+#include <algorithm>
+#include <bit>
+#include <utility>
 
 
 namespace TransferSessionDetails {
 
-Buffer::Buffer() : m_expectedConsumers(new AtomicSet<std::string>())
+Buffer::Buffer(bool locked)
+    : m_sharedMtx(locked)
 {
 
 }
 
-size_t Buffer::addChunk(const std::string &binaryData)
+size_t Buffer::addChunk(std::string binaryData)
 {
+    State state;
+    return addChunk(std::move(binaryData), state);
+}
+
+size_t Buffer::addChunk(std::string binaryData, State &state)
+{
+    std::unique_lock lock(m_sharedMtx);
+
+    const size_t size = binaryData.size();
+    const size_t index = insertChunk(binaryData);
+    fillState(state, index == 0 ? 0 : size);
+
+    return index;
+}
+
+Buffer::State Buffer::snapshot()
+{
+    std::unique_lock lock(m_sharedMtx);
+
+    State state;
+    fillState(state, 0);
+    return state;
+}
+
+size_t Buffer::insertChunk(std::string &binaryData)
+{
+    // no mutex here - called privately with upstream block
+
     if (m_EOF)
     {
         PLOG_WARNING << "Buffer::addChunk() anomaly: EOF is true";
@@ -32,60 +65,96 @@ size_t Buffer::addChunk(const std::string &binaryData)
         return 0;
     }
 
-    std::unique_lock lock(m_sharedMtx);
-
-    if (Config::instance().transferSessionChunkQueueMaxSize() <= m_chunks.size())
+    if (queueIsFull())
     {
         return 0;
     }
 
-    auto [iterator, inserted] = m_chunks.try_emplace(++m_chunksMaxIndex,
-                                                     new Chunk(m_expectedConsumers,
-                                                               reinterpret_cast<const uint8_t*>(binaryData.data()),
-                                                               binaryData.size()));
+    const size_t size = binaryData.size();
 
-    if (inserted)
-    {
-        m_bytesInTotal += binaryData.size();
-    }
-    else
+    // The server-wide memory budget is charged here
+    auto payload = ChunkMemoryPool::instance().admit(binaryData);
+    if (payload == nullptr)
     {
-        --m_chunksMaxIndex;
+        PLOG_WARNING << "Buffer::addChunk() refused: chunk memory budget is exhausted";
+        return 0;
     }
 
-    return m_chunksMaxIndex;
+    const size_t index = m_chunksMaxIndex + 1;
+    reserveSlotFor(index);
+
+    Slot& slot = m_ring[index & (m_ring.size() - 1)];
+    slot.chunk.emplace(std::move(payload));
+    slot.index = index;
+
+    ++m_chunkCount;
+    m_queuedBytes += size;
+    m_bytesInTotal += size;
+    m_chunksMaxIndex = index;
+
+    return index;
 }
 
-const std::shared_ptr<const std::vector<uint8_t>> Buffer::operator[](size_t index) const
+const std::shared_ptr<const std::string> Buffer::operator[](size_t index) const
 {
     std::shared_lock lock(m_sharedMtx);
 
-    auto iter = m_chunks.find(index);
-    if (iter == m_chunks.end())
+    const Slot* slot = findSlot(index);
+    if (slot == nullptr)
     {
         return nullptr;
     }
 
-    const auto data = iter->second->data();
+    const auto data = slot->chunk->data();
 
     m_bytesOutTotal += data->size();
 
     return data;
 }
 
-bool Buffer::setChunkAsReceived(size_t index, std::list<size_t>& removedChunks)
+bool Buffer::setChunkAsReceived(size_t index, const std::string& publicId, std::list<size_t>& removedChunks)
+{
+    State state;
+    return setChunkAsReceived(index, publicId, removedChunks, state);
+}
+
+bool Buffer::setChunkAsReceived(size_t index, const std::string &publicId, std::list<size_t> &removedChunks, State &state)
 {
     std::unique_lock lock(m_sharedMtx);
 
-    auto iter = m_chunks.find(index);
-    if (iter == m_chunks.end())
+    size_t chunkSize = 0;
+    const bool confirmed = confirmChunk(index, publicId, removedChunks, chunkSize);
+    fillState(state, chunkSize);
+
+    return confirmed;
+}
+
+bool Buffer::confirmChunk(size_t index, const std::string &publicId, std::list<size_t> &removedChunks, size_t &chunkSize)
+{
+    // no mutex here - called privately with upstream block
+
+    Slot* slot = findSlot(index);
+    if (slot == nullptr)
     {
         return false;
     }
 
-    (*iter->second).incrementUses();
+    const auto consumer = m_consumerSlots.find(publicId);
+    if (consumer == m_consumerSlots.end())
+    {
+        return false;
+    }
 
-    sanitize(removedChunks);
+    if (not slot->chunk->confirm(consumer->second))
+    {
+        // Repeated confirmation is not counted twice
+        return false;
+    }
+
+    chunkSize = slot->chunk->dataSize();
+
+    // Only this chunk may have become consumed, the rest of the window is not rescanned
+    releaseIfConsumed(*slot, removedChunks);
 
     return true;
 }
@@ -107,14 +176,17 @@ size_t Buffer::currentMaxChunkIndex() const
 
 size_t Buffer::chunkCount() const
 {
-    std::shared_lock lock(m_sharedMtx);
+    return m_chunkCount;
+}
 
-    return m_chunks.size();
+size_t Buffer::queuedBytes() const
+{
+    return m_queuedBytes;
 }
 
 bool Buffer::newChunkIsAllowed() const
 {
-    return Config::instance().transferSessionChunkQueueMaxSize() > chunkCount();
+    return not queueIsFull() and ChunkMemoryPool::instance().budgetAvailable();
 }
 
 std::list<size_t> Buffer::chunksIndex() const
@@ -123,9 +195,12 @@ std::list<size_t> Buffer::chunksIndex() const
 
     std::list<size_t> list;
 
-    for (const auto& c: m_chunks)
+    for (size_t index = m_firstIndex; index <= m_chunksMaxIndex; ++index)
     {
-        list.push_back(c.first);
+        if (findSlot(index))
+        {
+            list.push_back(index);
+        }
     }
 
     return list;
@@ -137,25 +212,37 @@ std::list<Event::Data::ChunkInfo> Buffer::chunksInfo() const
 
     std::list<Event::Data::ChunkInfo> list;
 
-    for (const auto& c: m_chunks)
+    for (size_t index = m_firstIndex; index <= m_chunksMaxIndex; ++index)
     {
-        list.push_back({c.first, c.second->dataSize()});
+        if (const Slot* slot = findSlot(index))
+        {
+            list.push_back({index, slot->chunk->dataSize()});
+        }
     }
 
     return list;
 }
 
 void Buffer::setEndOfFile()
+{
+    State state;
+    setEndOfFile(state);
+}
+
+bool Buffer::setEndOfFile(State &state)
 {
     std::unique_lock lock(m_sharedMtx);
 
-    if (m_EOF)
+    const bool wasSet = m_EOF;
+    if (wasSet)
     {
         PLOG_WARNING << "Buffer::setEndOfFile() anomaly: EOF already is true";
-        return;
     }
 
     m_EOF = true;
+    fillState(state, 0);
+
+    return not wasSet;
 }
 
 bool Buffer::someChunksWasRemoved() const
@@ -171,49 +258,94 @@ bool Buffer::addNewToExpectedConsumers(const std::string &publicId)
 
     // If the new number is greater than the previous one, checks are required.
     if (m_someChunkWasRemoved or
-        m_expectedConsumers->size()+1 > Config::instance().transferSessionMaxConsumerCount())
+        m_consumerSlots.size()+1 > Config::instance().transferSessionMaxConsumerCount() or
+        m_consumerSlots.size()+1 > Chunk::MAX_CONSUMERS)
     {
         return false;
     }
 
-    if (not m_expectedConsumers->add(publicId))
+    if (m_consumerSlots.contains(publicId))
     {
         return false;
     }
 
+    // The lowest free slot
+    const size_t slot = std::countr_one(m_expectedConsumers);
+    m_consumerSlots.emplace(publicId, slot);
+    m_expectedConsumers |= ConsumerMask(1) << slot;
+
     return true;
 }
 
 void Buffer::removeOneFromExpectedConsumers(const std::string &publicId, std::list<size_t>& removedChunks)
 {
-    if (m_expectedConsumers->remove(publicId))
+    State state;
+    removeOneFromExpectedConsumers(publicId, removedChunks, state);
+}
+
+void Buffer::removeOneFromExpectedConsumers(const std::string &publicId, std::list<size_t> &removedChunks, State &state)
+{
+    std::unique_lock lock(m_sharedMtx);
+
+    removeConsumer(publicId, removedChunks);
+    fillState(state, 0);
+}
+
+void Buffer::removeConsumer(const std::string &publicId, std::list<size_t> &removedChunks)
+{
+    // no mutex here - called privately with upstream block
+
+    const auto consumer = m_consumerSlots.find(publicId);
+    if (consumer == m_consumerSlots.end())
     {
-        sanitize(removedChunks);
+        return;
     }
+
+    const size_t slot = consumer->second;
+    m_consumerSlots.erase(consumer);
+    m_expectedConsumers &= ~(ConsumerMask(1) << slot);
+
+    // The slot may be given to a new consumer, which has not received these chunks
+    for (size_t index = m_firstIndex; index <= m_chunksMaxIndex; ++index)
+    {
+        if (Slot* chunkSlot = findSlot(index))
+        {
+            chunkSlot->chunk->forget(slot);
+        }
+    }
+
+    sanitize(removedChunks);
 }
 
 size_t Buffer::expectedConsumerCount() const
 {
     std::shared_lock lock(m_sharedMtx);
 
-    return m_expectedConsumers->size();
+    return m_consumerSlots.size();
 }
 
 bool Buffer::setInitialChunksFreezingDropped(std::list<size_t>& removedChunks)
 {
-    std::unique_lock lock(m_sharedMtx);
+    State state;
+    return setInitialChunksFreezingDropped(removedChunks, state);
+}
 
-    if (not m_initialChunksFreezing)
-    {
-        return false;
-    }
+bool Buffer::setInitialChunksFreezingDropped(std::list<size_t> &removedChunks, State &state)
+{
+    std::unique_lock lock(m_sharedMtx);
 
+    const bool wasFreezing = m_initialChunksFreezing;
     m_initialChunksFreezing = false;
 
     // Clean up chunks that were confirmed during freeze
-    sanitize(removedChunks);
+    if (wasFreezing)
+    {
+        sanitize(removedChunks);
+    }
 
-    return true;
+    fillState(state, 0);
+
+    return wasFreezing;
 }
 
 bool Buffer::initialChunksFreezing() const
@@ -223,7 +355,111 @@ bool Buffer::initialChunksFreezing() const
     return m_initialChunksFreezing;
 }
 
-void Buffer::sanitize(std::list<size_t>& removed)
+void Buffer::fillState(State &state, size_t chunkSize)
+{
+    // no mutex here - called privately with upstream block
+
+    state.chunkCount = m_chunkCount;
+    state.bytesIn = m_bytesInTotal;
+    state.bytesOut = m_bytesOutTotal;
+    state.chunkSize = chunkSize;
+    state.eof = m_EOF;
+    state.newChunkIsAllowed = not queueIsFull() and ChunkMemoryPool::instance().budgetAvailable();
+    state.newChunkIsAllowedChanged = state.newChunkIsAllowed != m_newChunkIsAllowedReported;
+    m_newChunkIsAllowedReported = state.newChunkIsAllowed;
+}
+
+bool Buffer::queueIsFull() const
+{
+    if (windowIsFull())
+    {
+        return true;
+    }
+
+    const size_t maxBytes = Config::instance().transferSessionChunkQueueMaxBytes();
+    if (maxBytes > 0)
+    {
+        return m_queuedBytes >= maxBytes;
+    }
+
+    return m_chunkCount >= Config::instance().transferSessionChunkQueueMaxSize();
+}
+
+bool Buffer::windowIsFull() const
+{
+    // The next chunk would widen [m_firstIndex, m_chunksMaxIndex] past maxWindow().
+    // The head is read first: it never passes the newer maximum, so there is no underflow unlocked.
+    const size_t first = m_firstIndex;
+    return m_chunksMaxIndex + 1 - first >= maxWindow();
+}
+
+size_t Buffer::maxWindow()
+{
+    return std::bit_ceil(std::max(MIN_WINDOW, Config::instance().transferSessionChunkQueueMaxSize()));
+}
+
+Buffer::Slot *Buffer::findSlot(size_t index)
+{
+    return const_cast<Slot*>(std::as_const(*this).findSlot(index));
+}
+
+const Buffer::Slot *Buffer::findSlot(size_t index) const
+{
+    // no mutex here - called privately with upstream block
+
+    if (m_ring.empty() or index < m_firstIndex or index > m_chunksMaxIndex)
+    {
+        return nullptr;
+    }
+
+    const Slot& slot = m_ring[index & (m_ring.size() - 1)];
+    return slot.index == index ? &slot : nullptr;
+}
+
+void Buffer::reserveSlotFor(size_t index)
+{
+    // no mutex here - called privately with upstream block
+
+    const size_t window = index - m_firstIndex + 1;
+    if (window <= m_ring.size())
+    {
+        return;
+    }
+
+    // insertChunk() keeps the window within maxWindow(), so neither is the ring
+    const size_t capacity = std::bit_ceil(std::max(window, Config::instance().transferSessionChunkQueueMaxSize()));
+
+    std::vector<Slot> ring(capacity);
+    for (size_t i = m_firstIndex; i < index; ++i)
+    {
+        if (Slot* old = findSlot(i))
+        {
+            Slot& slot = ring[i & (capacity - 1)];
+            slot.chunk.emplace(std::move(*old->chunk));
+            slot.index = i;
+        }
+    }
+
+    m_ring.swap(ring);
+}
+
+void Buffer::releaseSlot(Slot &slot)
+{
+    // no mutex here - called privately with upstream block
+
+    m_queuedBytes -= slot.chunk->dataSize();
+    slot.chunk.reset();
+    slot.index = 0;
+    --m_chunkCount;
+
+    // Advance the head of the window past freed slots
+    while (m_firstIndex <= m_chunksMaxIndex and findSlot(m_firstIndex) == nullptr)
+    {
+        ++m_firstIndex;
+    }
+}
+
+void Buffer::releaseIfConsumed(Slot &slot, std::list<size_t> &removed)
 {
     // no mutex here - called privately with upstream block
 
@@ -233,21 +469,29 @@ void Buffer::sanitize(std::list<size_t>& removed)
      */
     if (m_initialChunksFreezing) return;
 
-    for (auto iter = m_chunks.begin(), end = m_chunks.end(); iter != end; )
+    if (slot.chunk->howMuchIsLeft(m_expectedConsumers) == 0)
     {
-        if (iter->second->howMuchIsLeft() == 0)
+        if (not m_someChunkWasRemoved)
         {
-            if (not m_someChunkWasRemoved)
-            {
-                m_someChunkWasRemoved = true;
-            }
-
-            removed.push_back(iter->first);
-            iter = m_chunks.erase(iter);
+            m_someChunkWasRemoved = true;
         }
-        else
+
+        removed.push_back(slot.index);
+        releaseSlot(slot);
+    }
+}
+
+void Buffer::sanitize(std::list<size_t>& removed)
+{
+    // no mutex here - called privately with upstream block
+
+    if (m_initialChunksFreezing) return;
+
+    for (size_t index = m_firstIndex, last = m_chunksMaxIndex; index <= last; ++index)
+    {
+        if (Slot* slot = findSlot(index))
         {
-            ++iter;
+            releaseIfConsumed(*slot, removed);
         }
     }
 }
@@ -4,11 +4,12 @@
 
 #pragma once
 
-#include "atomicset.h"
+#include "chunk.h"
+#include "optionalsharedmutex.h"
 
-#include <map>
 #include <atomic>
-#include <shared_mutex>
+#include <map>
+#include <optional>
 #include <memory>
 #include <vector>
 #include <list>
@@ -25,48 +26,105 @@ struct ChunkInfo
 
 namespace TransferSessionDetails {
 
-class Chunk;
-
 class Buffer
 {
 public:
-    Buffer();
-
-    // return index of new chunk or 0
-    size_t addChunk(const std::string& binaryData);
-    const std::shared_ptr<const std::vector<uint8_t>> operator[](size_t index) const;
-    bool setChunkAsReceived(size_t index, std::list<size_t>& removedChunks);
+    /*
+     * State of the buffer taken in the same critical section as the operation
+     * that returns it, so the caller can publish events without locking again.
+     */
+    struct State
+    {
+        size_t chunkCount = 0;
+        size_t bytesIn = 0;
+        size_t bytesOut = 0;
+        size_t chunkSize = 0; // of the chunk added or confirmed by the operation
+        bool eof = false;
+        bool newChunkIsAllowed = false;
+        // newChunkIsAllowed differs from the value in the previously taken State
+        bool newChunkIsAllowedChanged = false;
+    };
+
+    // Unlocked, the buffer must only be used from one strand
+    explicit Buffer(bool locked = true);
+
+    // return index of new chunk or 0; the data is moved into the chunk on success
+    size_t addChunk(std::string binaryData);
+    size_t addChunk(std::string binaryData, State& state);
+    const std::shared_ptr<const std::string> operator[](size_t index) const;
+    // false if the index or the consumer is unknown, or the consumer has already confirmed the chunk
+    bool setChunkAsReceived(size_t index, const std::string& publicId, std::list<size_t>& removedChunks);
+    bool setChunkAsReceived(size_t index, const std::string& publicId, std::list<size_t>& removedChunks, State& state);
+    State snapshot();
 
     size_t bytesIn() const;
     size_t bytesOut() const;
 
     size_t currentMaxChunkIndex() const;
     size_t chunkCount() const;
+    // Total size of the chunks currently held
+    size_t queuedBytes() const;
     bool newChunkIsAllowed() const;
     std::list<size_t> chunksIndex() const;
     std::list<Event::Data::ChunkInfo> chunksInfo() const;
 
     void setEndOfFile();
+    // false if EOF was already set
+    bool setEndOfFile(State& state);
     bool eof() const;
 
     bool setInitialChunksFreezingDropped(std::list<size_t>& removedChunks);
+    bool setInitialChunksFreezingDropped(std::list<size_t>& removedChunks, State& state);
     bool initialChunksFreezing() const;
 
     bool someChunksWasRemoved() const;
     bool addNewToExpectedConsumers(const std::string& publicId);
     void removeOneFromExpectedConsumers(const std::string& publicId, std::list<size_t>& removedChunks);
+    void removeOneFromExpectedConsumers(const std::string& publicId, std::list<size_t>& removedChunks, State& state);
     size_t expectedConsumerCount() const;
 
-private:
-    mutable std::shared_mutex m_sharedMtx;
+    /*
+     * How far apart the oldest live chunk and the next one may be. A chunk
+     * stuck at the head (a receiver that never confirms it) stops new chunks
+     * once the window is this wide, so the ring and its scans stay bounded.
+     */
+    static size_t maxWindow();
 
-    std::shared_ptr<AtomicSet<std::string/*user's public id*/>> m_expectedConsumers;
-    std::map<size_t, std::shared_ptr<Chunk>> m_chunks;
-    size_t m_chunksMaxIndex = 0;
-    size_t m_bytesInTotal = 0;
+private:
+    static constexpr size_t MIN_WINDOW = 1024;
+
+    /*
+     * Chunk indices are monotonic, so the live chunks always fit into the window
+     * [m_firstIndex, m_chunksMaxIndex] and are stored in a ring of slots addressed
+     * by (index & mask). The ring keeps chunks in place (no node per chunk) and
+     * only grows when a chunk stuck at the head makes the window wider than the
+     * ring, up to maxWindow().
+     */
+    struct Slot
+    {
+        size_t index = 0; // 0 - the slot is free
+        std::optional<Chunk> chunk;
+    };
+
+    mutable OptionalSharedMutex m_sharedMtx;
+
+    /*
+     * Every expected consumer holds a slot (a bit of ConsumerMask) for as long
+     * as it stays in the session. A chunk is consumed once all the bits of
+     * m_expectedConsumers are confirmed in it.
+     */
+    std::map<std::string/*user's public id*/, size_t/*slot*/> m_consumerSlots;
+    ConsumerMask m_expectedConsumers = 0;
+    std::vector<Slot> m_ring;
+    std::atomic<size_t> m_firstIndex = 1;
+    std::atomic<size_t> m_chunkCount = 0;
+    std::atomic<size_t> m_queuedBytes = 0;
+    std::atomic<size_t> m_chunksMaxIndex = 0;
+    std::atomic<size_t> m_bytesInTotal = 0;
     mutable std::atomic<size_t> m_bytesOutTotal = 0;
     bool m_someChunkWasRemoved = false;
     bool m_EOF = false;
+    bool m_newChunkIsAllowedReported = true;
 
     /* The freeze is necessary so that new users can connect.
      * If the freeze is lifted, the downloaded chunks
@@ -75,6 +133,25 @@ private:
      */
     bool m_initialChunksFreezing = true;
 
+    /*
+     * Flow control works in one of two modes. By default the queue is limited
+     * to chunk_queue_max_size chunks. If chunk_queue_max_bytes is set, the
+     * queue is a byte window instead: a new chunk is accepted while less than
+     * the window is buffered, so small chunks keep the pipe full.
+     */
+    bool queueIsFull() const;
+    bool windowIsFull() const;
+    void fillState(State& state, size_t chunkSize);
+    size_t insertChunk(std::string& binaryData);
+    bool confirmChunk(size_t index, const std::string& publicId, std::list<size_t>& removedChunks, size_t& chunkSize);
+    void removeConsumer(const std::string& publicId, std::list<size_t>& removedChunks);
+    Slot* findSlot(size_t index);
+    const Slot* findSlot(size_t index) const;
+    void reserveSlotFor(size_t index);
+    void releaseSlot(Slot& slot);
+    // Frees the chunk if every expected consumer has confirmed it
+    void releaseIfConsumed(Slot& slot, std::list<size_t>& removed);
+    // Full scan of the window, only needed when the expected consumers or the freeze change
     void sanitize(std::list<size_t>& removed);
 };
 
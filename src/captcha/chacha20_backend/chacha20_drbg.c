@@ -0,0 +1,173 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#include "chacha20_drbg.h"
+#include "chacha20_simd.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#   include <sys/random.h>
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__)
+#   include <sys/random.h>
+#   include <unistd.h>
+#   define CHACHA20_DRBG_GETENTROPY 1
+#endif
+
+#define CHACHA20_BLOCK (64)
+#define DRBG_KEY_SIZE (32)
+/* Eight blocks fill one AVX2 batch or two SSE2/NEON batches */
+#define DRBG_BATCH_BLOCKS (8)
+#define DRBG_BATCH_SIZE (DRBG_BATCH_BLOCKS * CHACHA20_BLOCK)
+
+typedef struct {
+    uint32_t state[16];
+    uint8_t batch[DRBG_BATCH_SIZE];
+    size_t available; /* unserved bytes at the end of the batch */
+    size_t since_seed;
+    int seeded;
+} drbg_context;
+
+static _Thread_local drbg_context drbg;
+
+static int read_urandom(uint8_t *out, size_t size) {
+    FILE *file = fopen("/dev/urandom", "rb");
+    size_t got;
+    if (!file) {
+        return 0;
+    }
+    got = fread(out, 1, size, file);
+    fclose(file);
+    return got == size;
+}
+
+static int system_entropy(uint8_t *out, size_t size) {
+#if defined(__linux__)
+    size_t done = 0;
+    while (done < size) {
+        ssize_t got = getrandom(out + done, size - done, 0);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return read_urandom(out, size); /* kernel older than 3.17 */
+        }
+        done += (size_t)got;
+    }
+    return 1;
+#elif defined(CHACHA20_DRBG_GETENTROPY)
+    return getentropy(out, size) == 0 || read_urandom(out, size);
+#else
+    return read_urandom(out, size);
+#endif
+}
+
+static uint32_t load32_le(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* A fresh key with the counter and the nonce at zero */
+static void set_key(const uint8_t key[DRBG_KEY_SIZE]) {
+    static const uint32_t sigma[4] = { 0x61707865, 0x3320646e, 0x79622d32, 0x6b206574 };
+    memcpy(drbg.state, sigma, sizeof(sigma));
+    for (int i = 0; i < 8; i++) {
+        drbg.state[4 + i] = load32_le(key + i * 4);
+    }
+    memset(drbg.state + 12, 0, 4 * sizeof(uint32_t));
+}
+
+static void seed(void) {
+    uint8_t key[DRBG_KEY_SIZE];
+    if (!system_entropy(key, sizeof(key))) {
+        fputs("chacha20_drbg: no entropy is available from the system\n", stderr);
+        abort();
+    }
+    set_key(key);
+    memset(key, 0, sizeof(key));
+    drbg.since_seed = 0;
+    drbg.seeded = 1;
+}
+
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#define QUARTER_ROUND(a, b, c, d) \
+    a += b; d ^= a; d = ROTL32(d, 16); \
+    c += d; b ^= c; b = ROTL32(b, 12); \
+    a += b; d ^= a; d = ROTL32(d, 8);  \
+    c += d; b ^= c; b = ROTL32(b, 7);
+
+/* For targets without vector code */
+static void scalar_keystream(const uint32_t state[16], uint8_t *out, size_t blocks) {
+    for (size_t b = 0; b < blocks; b++) {
+        uint32_t x[16];
+        memcpy(x, state, sizeof(x));
+        x[12] += (uint32_t)b;
+        for (int i = 0; i < 10; i++) {
+            QUARTER_ROUND(x[0], x[4], x[8],  x[12])
+            QUARTER_ROUND(x[1], x[5], x[9],  x[13])
+            QUARTER_ROUND(x[2], x[6], x[10], x[14])
+            QUARTER_ROUND(x[3], x[7], x[11], x[15])
+            QUARTER_ROUND(x[0], x[5], x[10], x[15])
+            QUARTER_ROUND(x[1], x[6], x[11], x[12])
+            QUARTER_ROUND(x[2], x[7], x[8],  x[13])
+            QUARTER_ROUND(x[3], x[4], x[9],  x[14])
+        }
+        for (int i = 0; i < 16; i++) {
+            uint32_t word = x[i] + state[i] + (i == 12 ? (uint32_t)b : 0);
+            uint8_t *dest = out + b * CHACHA20_BLOCK + i * 4;
+            dest[0] = (uint8_t)word;
+            dest[1] = (uint8_t)(word >> 8);
+            dest[2] = (uint8_t)(word >> 16);
+            dest[3] = (uint8_t)(word >> 24);
+        }
+    }
+}
+
+/* Fast key erasure: the head of the batch replaces the key that made it */
+static void refill(void) {
+    if (!drbg.seeded || drbg.since_seed >= CHACHA20_DRBG_RESEED_BYTES) {
+        seed();
+    }
+    if (chacha20_simd_keystream(drbg.state, drbg.batch, DRBG_BATCH_BLOCKS) == 0) {
+        scalar_keystream(drbg.state, drbg.batch, DRBG_BATCH_BLOCKS);
+    }
+    set_key(drbg.batch);
+    memset(drbg.batch, 0, DRBG_KEY_SIZE);
+    drbg.available = DRBG_BATCH_SIZE - DRBG_KEY_SIZE;
+}
+
+void chacha20_drbg_fill(void *out, size_t size) {
+    uint8_t *dest = (uint8_t *)out;
+    while (size > 0) {
+        uint8_t *source;
+        size_t take;
+        if (drbg.available == 0) {
+            refill();
+        }
+        take = size < drbg.available ? size : drbg.available;
+        source = drbg.batch + DRBG_BATCH_SIZE - drbg.available;
+        memcpy(dest, source, take);
+        memset(source, 0, take);
+        drbg.available -= take;
+        drbg.since_seed += take;
+        dest += take;
+        size -= take;
+    }
+}
+
+uint32_t chacha20_drbg_uniform(uint32_t bound) {
+    /* values below 2^32 mod bound would make the low results more likely */
+    const uint32_t threshold = (uint32_t)(-bound) % bound;
+    uint32_t value;
+    do {
+        chacha20_drbg_fill(&value, sizeof(value));
+    } while (value < threshold);
+    return value % bound;
+}
+
+void chacha20_drbg_reseed(void) {
+    memset(&drbg, 0, sizeof(drbg));
+}
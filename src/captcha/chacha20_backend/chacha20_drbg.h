@@ -0,0 +1,38 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#ifndef CHACHA20_DRBG_H
+#define CHACHA20_DRBG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+   Cryptographically secure random bytes from a ChaCha20 generator kept
+   per thread, so no locking is needed. The keystream is produced in
+   batches of several blocks; the first 32 bytes of every batch become the
+   next key and served bytes are wiped, so an exposed state does not
+   reveal earlier output. The key is taken from the system (getrandom()
+   or getentropy()) on first use and after every CHACHA20_DRBG_RESEED_BYTES
+   of output. If the system has no entropy to give, the process aborts.
+*/
+#define CHACHA20_DRBG_RESEED_BYTES (1024 * 1024)
+
+void chacha20_drbg_fill(void *out, size_t size);
+
+/* Uniformly distributed in [0, bound), bound must not be 0 */
+uint32_t chacha20_drbg_uniform(uint32_t bound);
+
+/* The calling thread takes a new key from the system on the next call */
+void chacha20_drbg_reseed(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
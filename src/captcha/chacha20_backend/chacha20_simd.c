@@ -0,0 +1,221 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#include "chacha20_simd.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#   define CHACHA20_SIMD_X86 1
+#   include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#   define CHACHA20_SIMD_NEON 1
+#   include <arm_neon.h>
+#endif
+
+#define CHACHA20_BLOCK (64)
+
+// Each lane of a vector belongs to its own block: vector i holds
+// word i of 4 (or 8) blocks with consecutive counters, so the rounds
+// are the scalar ones with every operation done on all blocks at once.
+#define DOUBLE_ROUND(QR, x) \
+    QR(x[0], x[4],  x[8], x[12]) \
+    QR(x[1], x[5],  x[9], x[13]) \
+    QR(x[2], x[6], x[10], x[14]) \
+    QR(x[3], x[7], x[11], x[15]) \
+    QR(x[0], x[5], x[10], x[15]) \
+    QR(x[1], x[6], x[11], x[12]) \
+    QR(x[2], x[7],  x[8], x[13]) \
+    QR(x[3], x[4],  x[9], x[14])
+
+#ifdef CHACHA20_SIMD_X86
+
+// SSE2 is a part of x86-64, no check is needed
+#define ROTL_SSE2(v, n) _mm_or_si128(_mm_slli_epi32(v, n), _mm_srli_epi32(v, 32 - (n)))
+
+#define QR_SSE2(a, b, c, d) \
+    a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = ROTL_SSE2(d, 16); \
+    c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = ROTL_SSE2(b, 12); \
+    a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = ROTL_SSE2(d, 8);  \
+    c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = ROTL_SSE2(b, 7);
+
+static void blocks4_sse2(const uint32_t state[16], uint8_t *out) {
+    __m128i s[16], x[16];
+    for (int i = 0; i < 16; i++) {
+        s[i] = _mm_set1_epi32((int)state[i]);
+    }
+    s[12] = _mm_add_epi32(s[12], _mm_set_epi32(3, 2, 1, 0));
+    memcpy(x, s, sizeof(x));
+
+    for (int i = 0; i < 10; i++) {
+        DOUBLE_ROUND(QR_SSE2, x)
+    }
+
+    for (int i = 0; i < 16; i++) {
+        x[i] = _mm_add_epi32(x[i], s[i]);
+    }
+
+    // transpose every 4 words back into the byte order of the blocks
+    for (int i = 0; i < 16; i += 4) {
+        __m128i t0 = _mm_unpacklo_epi32(x[i], x[i + 1]);
+        __m128i t1 = _mm_unpacklo_epi32(x[i + 2], x[i + 3]);
+        __m128i t2 = _mm_unpackhi_epi32(x[i], x[i + 1]);
+        __m128i t3 = _mm_unpackhi_epi32(x[i + 2], x[i + 3]);
+        uint8_t *dest = out + i * sizeof(uint32_t);
+        _mm_storeu_si128((__m128i *)(dest + 0 * CHACHA20_BLOCK), _mm_unpacklo_epi64(t0, t1));
+        _mm_storeu_si128((__m128i *)(dest + 1 * CHACHA20_BLOCK), _mm_unpackhi_epi64(t0, t1));
+        _mm_storeu_si128((__m128i *)(dest + 2 * CHACHA20_BLOCK), _mm_unpacklo_epi64(t2, t3));
+        _mm_storeu_si128((__m128i *)(dest + 3 * CHACHA20_BLOCK), _mm_unpackhi_epi64(t2, t3));
+    }
+}
+
+#define ROTL_AVX2(v, n) _mm256_or_si256(_mm256_slli_epi32(v, n), _mm256_srli_epi32(v, 32 - (n)))
+
+// rotations by whole bytes are a single shuffle
+#define QR_AVX2(a, b, c, d) \
+    a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = _mm256_shuffle_epi8(d, rot16); \
+    c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = ROTL_AVX2(b, 12);              \
+    a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = _mm256_shuffle_epi8(d, rot8);  \
+    c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = ROTL_AVX2(b, 7);
+
+__attribute__((target("avx2")))
+static void blocks8_avx2(const uint32_t state[16], uint8_t *out) {
+    const __m256i rot16 = _mm256_set_epi8(
+        13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+        13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+    const __m256i rot8 = _mm256_set_epi8(
+        14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3,
+        14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3);
+
+    __m256i s[16], x[16];
+    for (int i = 0; i < 16; i++) {
+        s[i] = _mm256_set1_epi32((int)state[i]);
+    }
+    s[12] = _mm256_add_epi32(s[12], _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    memcpy(x, s, sizeof(x));
+
+    for (int i = 0; i < 10; i++) {
+        DOUBLE_ROUND(QR_AVX2, x)
+    }
+
+    for (int i = 0; i < 16; i++) {
+        x[i] = _mm256_add_epi32(x[i], s[i]);
+    }
+
+    // the unpacks work inside 128-bit halves: the low half
+    // ends up with blocks 0-3, the high half with blocks 4-7
+    for (int i = 0; i < 16; i += 4) {
+        __m256i t0 = _mm256_unpacklo_epi32(x[i], x[i + 1]);
+        __m256i t1 = _mm256_unpacklo_epi32(x[i + 2], x[i + 3]);
+        __m256i t2 = _mm256_unpackhi_epi32(x[i], x[i + 1]);
+        __m256i t3 = _mm256_unpackhi_epi32(x[i + 2], x[i + 3]);
+        __m256i b[4];
+        b[0] = _mm256_unpacklo_epi64(t0, t1);
+        b[1] = _mm256_unpackhi_epi64(t0, t1);
+        b[2] = _mm256_unpacklo_epi64(t2, t3);
+        b[3] = _mm256_unpackhi_epi64(t2, t3);
+
+        uint8_t *dest = out + i * sizeof(uint32_t);
+        for (int j = 0; j < 4; j++) {
+            _mm_storeu_si128((__m128i *)(dest + j * CHACHA20_BLOCK), _mm256_castsi256_si128(b[j]));
+            _mm_storeu_si128((__m128i *)(dest + (j + 4) * CHACHA20_BLOCK), _mm256_extracti128_si256(b[j], 1));
+        }
+    }
+}
+
+static int have_avx2(void) {
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif // CHACHA20_SIMD_X86
+
+#ifdef CHACHA20_SIMD_NEON
+
+#define ROTL_NEON(v, n) vsriq_n_u32(vshlq_n_u32(v, n), v, 32 - (n))
+
+#define QR_NEON(a, b, c, d) \
+    a = vaddq_u32(a, b); d = veorq_u32(d, a); \
+    d = vreinterpretq_u32_u16(vrev32q_u16(vreinterpretq_u16_u32(d))); \
+    c = vaddq_u32(c, d); b = veorq_u32(b, c); b = ROTL_NEON(b, 12); \
+    a = vaddq_u32(a, b); d = veorq_u32(d, a); d = ROTL_NEON(d, 8);  \
+    c = vaddq_u32(c, d); b = veorq_u32(b, c); b = ROTL_NEON(b, 7);
+
+static void blocks4_neon(const uint32_t state[16], uint8_t *out) {
+    static const uint32_t lanes[4] = { 0, 1, 2, 3 };
+    uint32x4_t s[16], x[16];
+    for (int i = 0; i < 16; i++) {
+        s[i] = vdupq_n_u32(state[i]);
+    }
+    s[12] = vaddq_u32(s[12], vld1q_u32(lanes));
+    memcpy(x, s, sizeof(x));
+
+    for (int i = 0; i < 10; i++) {
+        DOUBLE_ROUND(QR_NEON, x)
+    }
+
+    for (int i = 0; i < 16; i++) {
+        x[i] = vaddq_u32(x[i], s[i]);
+    }
+
+    for (int i = 0; i < 16; i += 4) {
+        uint32x4x2_t a = vtrnq_u32(x[i], x[i + 1]);
+        uint32x4x2_t b = vtrnq_u32(x[i + 2], x[i + 3]);
+        uint8_t *dest = out + i * sizeof(uint32_t);
+        vst1q_u8(dest + 0 * CHACHA20_BLOCK, vreinterpretq_u8_u32(vcombine_u32(vget_low_u32(a.val[0]), vget_low_u32(b.val[0]))));
+        vst1q_u8(dest + 1 * CHACHA20_BLOCK, vreinterpretq_u8_u32(vcombine_u32(vget_low_u32(a.val[1]), vget_low_u32(b.val[1]))));
+        vst1q_u8(dest + 2 * CHACHA20_BLOCK, vreinterpretq_u8_u32(vcombine_u32(vget_high_u32(a.val[0]), vget_high_u32(b.val[0]))));
+        vst1q_u8(dest + 3 * CHACHA20_BLOCK, vreinterpretq_u8_u32(vcombine_u32(vget_high_u32(a.val[1]), vget_high_u32(b.val[1]))));
+    }
+}
+
+#endif // CHACHA20_SIMD_NEON
+
+size_t chacha20_simd_keystream(const uint32_t state[16], uint8_t *out, size_t blocks) {
+#if defined(CHACHA20_SIMD_X86) || defined(CHACHA20_SIMD_NEON)
+    uint32_t current[16];
+    uint8_t tail[8 * CHACHA20_BLOCK];
+    size_t done = 0;
+    memcpy(current, state, sizeof(current));
+
+    while (done < blocks) {
+        size_t remaining = blocks - done;
+        size_t width = 4;
+        uint8_t *dest = remaining >= 4 ? out + done * CHACHA20_BLOCK : tail;
+#ifdef CHACHA20_SIMD_X86
+        if (remaining > 4 && have_avx2()) {
+            width = 8;
+            dest = remaining >= 8 ? out + done * CHACHA20_BLOCK : tail;
+            blocks8_avx2(current, dest);
+        } else {
+            blocks4_sse2(current, dest);
+        }
+#else
+        blocks4_neon(current, dest);
+#endif
+        if (dest == tail) {
+            // the unneeded blocks of the last group are dropped
+            memcpy(out + done * CHACHA20_BLOCK, tail, remaining * CHACHA20_BLOCK);
+            break;
+        }
+        current[12] += (uint32_t)width;
+        done += width;
+    }
+    return blocks;
+#else
+    (void)state;
+    (void)out;
+    (void)blocks;
+    return 0;
+#endif
+}
+
+const char *chacha20_simd_name(void) {
+#if defined(CHACHA20_SIMD_X86)
+    return have_avx2() ? "avx2" : "sse2";
+#elif defined(CHACHA20_SIMD_NEON)
+    return "neon";
+#else
+    return "none";
+#endif
+}
@@ -0,0 +1,33 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#ifndef CHACHA20_SIMD_H
+#define CHACHA20_SIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+   Writes `blocks` consecutive ChaCha20 keystream blocks (64 bytes each) to
+   `out`, the first one for the block counter in state[12]. Several blocks
+   are computed in parallel: 8 with AVX2 (chosen at run time), 4 with SSE2
+   or NEON. The state is not modified.
+
+   Returns the number of blocks written: `blocks`, or 0 if there is no
+   vector code for this target and the caller has to use the scalar one.
+*/
+size_t chacha20_simd_keystream(const uint32_t state[16], uint8_t *out, size_t blocks);
+
+/* "avx2", "sse2", "neon" or "none" */
+const char *chacha20_simd_name(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -32,20 +32,30 @@
 #    endif
 #endif
 
-// xor data with a ChaCha20 keystream as per RFC8439
-static PORTABLE_8439_DECL void chacha20_xor_stream(
-        uint8_t *restrict dest, 
-        const uint8_t *restrict source, 
-        size_t length,
+// Keystream blocks are produced in batches, so the vector code can compute
+// several of them at once (see chacha20_simd.h)
+#define CHACHA20_BATCH_BLOCKS (8)
+
+// start a keystream as per RFC8439: the Poly1305 key comes from block 0,
+// the blocks after it are left in `stream` for encryption, returns their size
+static PORTABLE_8439_DECL size_t rfc8439_keystream_start(
+        uint32_t state[16],
+        uint8_t stream[CHACHA20_BATCH_BLOCKS * 64],
+        uint8_t poly_key[32],
         const uint8_t key[CHACHA20_KEY_SIZE],
         const uint8_t nonce[CHACHA20_NONCE_SIZE],
-        uint32_t counter
+        size_t length
 );
 
-static PORTABLE_8439_DECL void rfc8439_keygen(
-        uint8_t poly_key[32],
-        const uint8_t key[CHACHA20_KEY_SIZE],
-        const uint8_t nonce[CHACHA20_NONCE_SIZE]
+// xor data with the rest of `stream`, then with new keystream blocks
+static PORTABLE_8439_DECL void chacha20_xor_keystream(
+        uint8_t *restrict dest,
+        const uint8_t *restrict source,
+        size_t length,
+        uint32_t state[16],
+        uint8_t stream[CHACHA20_BATCH_BLOCKS * 64],
+        size_t offset,
+        size_t available
 );
 
 // ******* END:   chacha-portable/chacha-portable.h ********
@@ -72,6 +82,8 @@ static PORTABLE_8439_DECL int poly1305_power_on_self_test(void);
 #include <string.h>
 #include <assert.h>
 
+#include "chacha20_simd.h"
+
 // this is a fresh implementation of chacha20, based on the description in rfc8349
 // it's such a nice compact algorithm that it is easy to do.
 // In relationship to other c implementation this implementation:
@@ -187,103 +199,96 @@ static void core_block(const uint32_t *restrict start, uint32_t *restrict output
 #define U8(x) ((uint8_t)((x) & 0xFF))
 
 #ifdef FAST_PATH
-#   define xor32_le(dst, src, pad) \
-    uint32_t __value; \
-    memcpy(&__value, src, sizeof(uint32_t)); \
-    __value ^= *(pad); \
-    memcpy(dst, &__value, sizeof(uint32_t));
+#define serialize_block(target, result) memcpy(target, result, CHACHA20_BLOCK_SIZE)
 #else
-#   define xor32_le(dst, src, pad) \
-    (dst)[0] = (src)[0] ^ U8(*(pad)); \
-    (dst)[1] = (src)[1] ^ U8(*(pad) >> 8); \
-    (dst)[2] = (src)[2] ^ U8(*(pad) >> 16); \
-    (dst)[3] = (src)[3] ^ U8(*(pad) >> 24);
-#endif
-
-#define index8_32(a, ix) ((a) + ((ix) * sizeof(uint32_t)))
-
-#define xor32_blocks(dest, source, pad, words) \
-    for (unsigned int __i = 0; __i < words; __i++) { \
-        xor32_le(index8_32(dest, __i), index8_32(source, __i), (pad) + __i) \
-    }
+#define store32_le(target, source) \
+    (target)[0] = U8(*(source)); \
+    (target)[1] = U8(*(source) >> 8); \
+    (target)[2] = U8(*(source) >> 16); \
+    (target)[3] = U8(*(source) >> 24);
 
-static void xor_block(uint8_t *restrict dest, const uint8_t *restrict source, const uint32_t *restrict pad, unsigned int chunk_size) {
-    unsigned int full_blocks = chunk_size / sizeof(uint32_t);
-    // have to be carefull, we are going back from uint32 to uint8, so endianess matters again
-    xor32_blocks(dest, source, pad, full_blocks)
-
-    dest += full_blocks * sizeof(uint32_t);
-    source += full_blocks * sizeof(uint32_t);
-    pad += full_blocks;
-
-    switch(chunk_size % sizeof(uint32_t)) {
-        case 1:
-            dest[0] = source[0] ^ U8(*pad);
-            break;
-        case 2:
-            dest[0] = source[0] ^ U8(*pad);
-            dest[1] = source[1] ^ U8(*pad >> 8);
-            break;
-        case 3:
-            dest[0] = source[0] ^ U8(*pad);
-            dest[1] = source[1] ^ U8(*pad >> 8);
-            dest[2] = source[2] ^ U8(*pad >> 16);
-            break;
+#define serialize_block(target, result) \
+    for (unsigned int __i = 0; __i < CHACHA20_STATE_WORDS; __i++) { \
+        store32_le((target) + __i * sizeof(uint32_t), (result) + __i); \
     }
-}
+#endif
 
-static void chacha20_xor_stream(
-        uint8_t *restrict dest, 
-        const uint8_t *restrict source, 
-        size_t length,
-        const uint8_t key[CHACHA20_KEY_SIZE],
-        const uint8_t nonce[CHACHA20_NONCE_SIZE],
-        uint32_t counter
-) {
-    uint32_t state[CHACHA20_STATE_WORDS];
-    initialize_state(state, key, nonce, counter);
+// fills `blocks` keystream blocks and advances the counter
+static void chacha20_keystream(uint32_t state[CHACHA20_STATE_WORDS], uint8_t *out, size_t blocks) {
+    // one or two blocks are cheaper with the scalar code than a whole vector batch
+    size_t done = blocks > 2 ? chacha20_simd_keystream(state, out, blocks) : 0;
+    state[12] += (uint32_t)done;
 
     uint32_t pad[CHACHA20_STATE_WORDS];
-    size_t full_blocks = length / CHACHA20_BLOCK_SIZE;
-    for (size_t b = 0; b < full_blocks; b++) {
+    for (; done < blocks; done++) {
         core_block(state, pad);
         increment_counter(state);
-        xor32_blocks(dest, source, pad, CHACHA20_STATE_WORDS)
-        dest += CHACHA20_BLOCK_SIZE;
-        source += CHACHA20_BLOCK_SIZE;
-    }
-    unsigned int last_block = (unsigned int)(length % CHACHA20_BLOCK_SIZE);
-    if (last_block > 0 ) {
-        core_block(state, pad);
-        xor_block(dest, source, pad, last_block);
+        serialize_block(out + done * CHACHA20_BLOCK_SIZE, pad);
     }
 }
 
-#ifdef FAST_PATH
-#define serialize(poly_key, result) memcpy(poly_key, result, 32)
-#else
-#define store32_le(target, source) \
-    (target)[0] = U8(*(source)); \
-    (target)[1] = U8(*(source) >> 8); \
-    (target)[2] = U8(*(source) >> 16); \
-    (target)[3] = U8(*(source) >> 24);
-
-#define serialize(poly_key, result) \
-    for (unsigned int i = 0; i < 32 / sizeof(uint32_t); i++) { \
-        store32_le(index8_32(poly_key, i), result + i); \
+static void xor_bytes(uint8_t *restrict dest, const uint8_t *restrict source, const uint8_t *restrict pad, size_t length) {
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+        uint64_t a, b;
+        memcpy(&a, source + i, sizeof(a));
+        memcpy(&b, pad + i, sizeof(b));
+        a ^= b;
+        memcpy(dest + i, &a, sizeof(a));
     }
-#endif
+    for (; i < length; i++) {
+        dest[i] = source[i] ^ pad[i];
+    }
+}
 
-static void rfc8439_keygen(
+static size_t rfc8439_keystream_start(
+        uint32_t state[CHACHA20_STATE_WORDS],
+        uint8_t stream[CHACHA20_BATCH_BLOCKS * CHACHA20_BLOCK_SIZE],
         uint8_t poly_key[32],
         const uint8_t key[CHACHA20_KEY_SIZE],
-        const uint8_t nonce[CHACHA20_NONCE_SIZE]
+        const uint8_t nonce[CHACHA20_NONCE_SIZE],
+        size_t length
 ) {
-    uint32_t state[CHACHA20_STATE_WORDS];
-    uint32_t result[CHACHA20_STATE_WORDS];
+    // block 0 for the key and as many data blocks as fit into the batch
+    size_t blocks = 1 + (length + CHACHA20_BLOCK_SIZE - 1) / CHACHA20_BLOCK_SIZE;
+    if (blocks > CHACHA20_BATCH_BLOCKS) {
+        blocks = CHACHA20_BATCH_BLOCKS;
+    }
+
     initialize_state(state, key, nonce, 0);
-    core_block(state, result);
-    serialize(poly_key, result);
+    chacha20_keystream(state, stream, blocks);
+    memcpy(poly_key, stream, 32);
+    return (blocks - 1) * CHACHA20_BLOCK_SIZE;
+}
+
+static void chacha20_xor_keystream(
+        uint8_t *restrict dest,
+        const uint8_t *restrict source,
+        size_t length,
+        uint32_t state[CHACHA20_STATE_WORDS],
+        uint8_t stream[CHACHA20_BATCH_BLOCKS * CHACHA20_BLOCK_SIZE],
+        size_t offset,
+        size_t available
+) {
+    while (length > 0) {
+        if (available == 0) {
+            size_t blocks = (length + CHACHA20_BLOCK_SIZE - 1) / CHACHA20_BLOCK_SIZE;
+            if (blocks > CHACHA20_BATCH_BLOCKS) {
+                blocks = CHACHA20_BATCH_BLOCKS;
+            }
+            chacha20_keystream(state, stream, blocks);
+            offset = 0;
+            available = blocks * CHACHA20_BLOCK_SIZE;
+        }
+
+        size_t chunk = length < available ? length : available;
+        xor_bytes(dest, source, stream + offset, chunk);
+        dest += chunk;
+        source += chunk;
+        length -= chunk;
+        offset += chunk;
+        available -= chunk;
+    }
 }
 // ******* END: chacha-portable.c ********
 // ******* BEGIN: poly1305-donna.c ********
@@ -1200,14 +1205,10 @@ static PORTABLE_8439_DECL void poly1305_calculate_mac(
     uint8_t *mac,
     const uint8_t *cipher_text,
     size_t cipher_text_size,
-    const uint8_t key[RFC_8439_KEY_SIZE],
-    const uint8_t nonce[RFC_8439_NONCE_SIZE],
+    const uint8_t poly_key[__POLY1305_KEY_SIZE],
     const uint8_t *ad,
     size_t ad_size
 ) {
-    // init poly key (section 2.6)
-    uint8_t poly_key[__POLY1305_KEY_SIZE] = {0}; 
-    rfc8439_keygen(poly_key, key, nonce);
     // start poly1305 mac
     poly1305_context poly_ctx;
     poly1305_init(&poly_ctx, poly_key);
@@ -1253,8 +1254,14 @@ PORTABLE_8439_DECL size_t portable_chacha20_poly1305_encrypt(
     if (OVERLAPPING(plain_text, plain_text_size, cipher_text, new_size)) {
         return -1;
     }
-    chacha20_xor_stream(cipher_text, plain_text, plain_text_size, key, nonce, 1);
-    poly1305_calculate_mac(cipher_text + plain_text_size, cipher_text, plain_text_size, key, nonce, ad, ad_size);
+    // the poly key (section 2.6) and the first data blocks are computed together
+    uint32_t state[CHACHA20_STATE_WORDS];
+    uint8_t stream[CHACHA20_BATCH_BLOCKS * CHACHA20_BLOCK_SIZE];
+    uint8_t poly_key[__POLY1305_KEY_SIZE];
+    size_t available = rfc8439_keystream_start(state, stream, poly_key, key, nonce, plain_text_size);
+
+    chacha20_xor_keystream(cipher_text, plain_text, plain_text_size, state, stream, CHACHA20_BLOCK_SIZE, available);
+    poly1305_calculate_mac(cipher_text + plain_text_size, cipher_text, plain_text_size, poly_key, ad, ad_size);
     return new_size;
 }
 
@@ -1274,11 +1281,16 @@ PORTABLE_8439_DECL size_t portable_chacha20_poly1305_decrypt(
         return -1;
     }
 
-    poly1305_calculate_mac(actual_mac, cipher_text, actual_size, key, nonce, ad, ad_size);
+    uint32_t state[CHACHA20_STATE_WORDS];
+    uint8_t stream[CHACHA20_BATCH_BLOCKS * CHACHA20_BLOCK_SIZE];
+    uint8_t poly_key[__POLY1305_KEY_SIZE];
+    size_t available = rfc8439_keystream_start(state, stream, poly_key, key, nonce, actual_size);
+
+    poly1305_calculate_mac(actual_mac, cipher_text, actual_size, poly_key, ad, ad_size);
 
     if (poly1305_verify(cipher_text + actual_size, actual_mac)) {
         // valid mac, so decrypt cipher_text
-        chacha20_xor_stream(plain_text, cipher_text, actual_size, key, nonce, 1);
+        chacha20_xor_keystream(plain_text, cipher_text, actual_size, state, stream, CHACHA20_BLOCK_SIZE, available);
         return actual_size;
     }
     return -1;
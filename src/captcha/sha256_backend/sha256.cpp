@@ -1,15 +1,19 @@
 // Source: https://github.com/System-Glitch/SHA256
 
 #include "sha256.h"
+#include "sha256_accel.h"
 #include <cstring>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
 namespace tools {
 
 constexpr std::array<uint32_t, 64> SHA256::K;
 
-SHA256::SHA256(): m_blocklen(0), m_bitlen(0) {
+SHA256::SHA256(): SHA256(bestImplementation()) {}
+
+SHA256::SHA256(Implementation implementation): m_blocklen(0), m_bitlen(0), m_compress(compressFor(implementation)) {
     m_state[0] = 0x6a09e667;
     m_state[1] = 0xbb67ae85;
     m_state[2] = 0x3c6ef372;
@@ -21,16 +25,31 @@ SHA256::SHA256(): m_blocklen(0), m_bitlen(0) {
 }
 
 void SHA256::update(const uint8_t * data, size_t length) {
-    for (size_t i = 0 ; i < length ; i++) {
-        m_data[m_blocklen++] = data[i];
-        if (m_blocklen == 64) {
-            transform();
-
-            // End of the block
-            m_bitlen += 512;
-            m_blocklen = 0;
+    if (m_blocklen > 0) { // Complete the buffered block first
+        const size_t take = std::min<size_t>(64 - m_blocklen, length);
+        memcpy(m_data + m_blocklen, data, take);
+        m_blocklen += take;
+        data += take;
+        length -= take;
+        if (m_blocklen < 64) {
+            return;
         }
+        transform();
+        m_bitlen += 512;
+        m_blocklen = 0;
+    }
+
+    // Whole blocks are compressed in place, without copying them
+    const size_t blocks = length / 64;
+    if (blocks > 0) {
+        m_compress(m_state, data, blocks);
+        m_bitlen += 512 * static_cast<uint64_t>(blocks);
+        data += blocks * 64;
+        length -= blocks * 64;
     }
+
+    memcpy(m_data, data, length);
+    m_blocklen = length;
 }
 
 void SHA256::update(const std::string &data) {
@@ -72,46 +91,88 @@ uint32_t SHA256::sig1(uint32_t x) {
 }
 
 void SHA256::transform() {
+    m_compress(m_state, m_data, 1);
+}
+
+void SHA256::compressPortable(uint32_t * hash, const uint8_t * data, size_t blocks) {
     uint32_t maj, xorA, ch, xorE, sum, newA, newE, m[64];
     uint32_t state[8];
 
-    for (uint8_t i = 0, j = 0; i < 16; i++, j += 4) { // Split data in 32 bit blocks for the 16 first words
-        m[i] = (m_data[j] << 24) | (m_data[j + 1] << 16) | (m_data[j + 2] << 8) | (m_data[j + 3]);
-    }
+    for (; blocks > 0; blocks--, data += 64) {
+        for (uint8_t i = 0, j = 0; i < 16; i++, j += 4) { // Split data in 32 bit blocks for the 16 first words
+            m[i] = (data[j] << 24) | (data[j + 1] << 16) | (data[j + 2] << 8) | (data[j + 3]);
+        }
 
-    for (uint8_t k = 16 ; k < 64; k++) { // Remaining 48 blocks
-        m[k] = SHA256::sig1(m[k - 2]) + m[k - 7] + SHA256::sig0(m[k - 15]) + m[k - 16];
-    }
+        for (uint8_t k = 16 ; k < 64; k++) { // Remaining 48 blocks
+            m[k] = SHA256::sig1(m[k - 2]) + m[k - 7] + SHA256::sig0(m[k - 15]) + m[k - 16];
+        }
 
-    for(uint8_t i = 0 ; i < 8 ; i++) {
-        state[i] = m_state[i];
-    }
+        for(uint8_t i = 0 ; i < 8 ; i++) {
+            state[i] = hash[i];
+        }
 
-    for (uint8_t i = 0; i < 64; i++) {
-        maj   = SHA256::majority(state[0], state[1], state[2]);
-        xorA  = SHA256::rotr(state[0], 2) ^ SHA256::rotr(state[0], 13) ^ SHA256::rotr(state[0], 22);
+        for (uint8_t i = 0; i < 64; i++) {
+            maj   = SHA256::majority(state[0], state[1], state[2]);
+            xorA  = SHA256::rotr(state[0], 2) ^ SHA256::rotr(state[0], 13) ^ SHA256::rotr(state[0], 22);
 
-        ch = choose(state[4], state[5], state[6]);
+            ch = choose(state[4], state[5], state[6]);
 
-        xorE  = SHA256::rotr(state[4], 6) ^ SHA256::rotr(state[4], 11) ^ SHA256::rotr(state[4], 25);
+            xorE  = SHA256::rotr(state[4], 6) ^ SHA256::rotr(state[4], 11) ^ SHA256::rotr(state[4], 25);
 
-        sum  = m[i] + K[i] + state[7] + ch + xorE;
-        newA = xorA + maj + sum;
-        newE = state[3] + sum;
+            sum  = m[i] + K[i] + state[7] + ch + xorE;
+            newA = xorA + maj + sum;
+            newE = state[3] + sum;
 
-        state[7] = state[6];
-        state[6] = state[5];
-        state[5] = state[4];
-        state[4] = newE;
-        state[3] = state[2];
-        state[2] = state[1];
-        state[1] = state[0];
-        state[0] = newA;
+            state[7] = state[6];
+            state[6] = state[5];
+            state[5] = state[4];
+            state[4] = newE;
+            state[3] = state[2];
+            state[2] = state[1];
+            state[1] = state[0];
+            state[0] = newA;
+        }
+
+        for(uint8_t i = 0 ; i < 8 ; i++) {
+            hash[i] += state[i];
+        }
+    }
+}
+
+SHA256::Compress SHA256::compressFor(Implementation implementation) {
+    Compress compress = nullptr;
+    switch (implementation) {
+    case Implementation::shaNi: compress = sha256_accel::shaNi(); break;
+    case Implementation::armv8: compress = sha256_accel::armv8(); break;
+    case Implementation::portable: break;
     }
+    return compress ? compress : &SHA256::compressPortable;
+}
+
+SHA256::Implementation SHA256::bestImplementation() {
+    // Resolved once, the CPU does not change while running
+    static const Implementation best = isSupported(Implementation::shaNi) ? Implementation::shaNi
+                                     : isSupported(Implementation::armv8) ? Implementation::armv8
+                                                                          : Implementation::portable;
+    return best;
+}
+
+bool SHA256::isSupported(Implementation implementation) {
+    switch (implementation) {
+    case Implementation::shaNi: return sha256_accel::shaNi() != nullptr;
+    case Implementation::armv8: return sha256_accel::armv8() != nullptr;
+    case Implementation::portable: return true;
+    }
+    return false;
+}
 
-    for(uint8_t i = 0 ; i < 8 ; i++) {
-        m_state[i] += state[i];
+const char* SHA256::implementationName(Implementation implementation) {
+    switch (implementation) {
+    case Implementation::shaNi: return "sha-ni";
+    case Implementation::armv8: return "armv8-sha2";
+    case Implementation::portable: return "portable";
     }
+    return "unknown";
 }
 
 void SHA256::pad() {
@@ -12,7 +12,16 @@ namespace tools {
 class SHA256 {
 
 public:
+    // Block compression code, the fastest one supported by the CPU is used by default
+    enum class Implementation {
+        portable,
+        shaNi,   // x86 SHA extensions
+        armv8    // ARMv8 cryptography extensions
+    };
+
     SHA256();
+    // For cross-checks, an unsupported implementation falls back to the portable one
+    explicit SHA256(Implementation implementation);
     void update(const uint8_t * data, size_t length);
     void update(const std::string &data);
     void update(const std::vector<uint8_t> &data);
@@ -20,12 +29,21 @@ public:
 
     static std::string toString(const std::array<uint8_t, 32> & digest);
 
+    static Implementation bestImplementation();
+    static bool isSupported(Implementation implementation);
+    static const char* implementationName(Implementation implementation);
+
+    // Processes whole 64-byte blocks
+    using Compress = void (*)(uint32_t state[8], const uint8_t * data, size_t blocks);
+
 private:
     uint8_t  m_data[64];
     uint32_t m_blocklen;
     uint64_t m_bitlen;
     uint32_t m_state[8]; //A, B, C, D, E, F, G, H
+    Compress m_compress;
 
+public:
     static constexpr std::array<uint32_t, 64> K = {
         0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,
         0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
@@ -45,11 +63,14 @@ private:
         0x90befffa,0xa4506ceb,0xbef9a3f7,0xc67178f2
     };
 
+private:
     static uint32_t rotr(uint32_t x, uint32_t n);
     static uint32_t choose(uint32_t e, uint32_t f, uint32_t g);
     static uint32_t majority(uint32_t a, uint32_t b, uint32_t c);
     static uint32_t sig0(uint32_t x);
     static uint32_t sig1(uint32_t x);
+    static void compressPortable(uint32_t state[8], const uint8_t * data, size_t blocks);
+    static Compress compressFor(Implementation implementation);
     void transform();
     void pad();
     void revert(std::array<uint8_t, 32> & hash);
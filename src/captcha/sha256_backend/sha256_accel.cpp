@@ -0,0 +1,213 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+// The round structure follows the public domain SHA-Intrinsics by Jeffrey Walton
+
+#include "sha256_accel.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#   define SHA256_HAVE_SHA_NI 1
+#   include <cpuid.h>
+#   include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && (defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO))
+#   define SHA256_HAVE_ARMV8 1
+#   include <arm_neon.h>
+#endif
+
+namespace tools {
+namespace sha256_accel {
+
+#ifdef SHA256_HAVE_SHA_NI
+
+namespace {
+
+bool cpuHasShaNi()
+{
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0 or (ecx & bit_SSE4_1) == 0)
+    {
+        return false;
+    }
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) == 0)
+    {
+        return false;
+    }
+    return (ebx & (1u << 29)) != 0; // SHA
+}
+
+// Four rounds; the message schedule of later rounds is interleaved with them
+#define SHA_NI_ROUNDS(g, cur, prev, next, old)                                 \
+    msg = _mm_add_epi32(cur, _mm_loadu_si128(                                  \
+              reinterpret_cast<const __m128i*>(&SHA256::K[4 * (g)])));         \
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);                       \
+    if ((g) >= 3 and (g) <= 14)                                                \
+    {                                                                          \
+        tmp = _mm_alignr_epi8(cur, prev, 4);                                   \
+        next = _mm_add_epi32(next, tmp);                                       \
+        next = _mm_sha256msg2_epu32(next, cur);                                \
+    }                                                                          \
+    msg = _mm_shuffle_epi32(msg, 0x0E);                                        \
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);                       \
+    if ((g) >= 1 and (g) <= 12)                                                \
+    {                                                                          \
+        old = _mm_sha256msg1_epu32(old, cur);                                  \
+    }
+
+__attribute__((target("sha,sse4.1")))
+void compressShaNi(uint32_t state[8], const uint8_t* data, size_t blocks)
+{
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // The instructions want the state as ABEF and CDGH
+    __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0]));
+    __m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4]));
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);
+    state1 = _mm_shuffle_epi32(state1, 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    for (; blocks > 0; blocks--, data += 64)
+    {
+        const __m128i abefSaved = state0;
+        const __m128i cdghSaved = state1;
+        __m128i msg;
+
+        __m128i m0 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), byteSwap);
+        __m128i m1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16)), byteSwap);
+        __m128i m2 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32)), byteSwap);
+        __m128i m3 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 48)), byteSwap);
+
+        SHA_NI_ROUNDS(0,  m0, m3, m1, m3)
+        SHA_NI_ROUNDS(1,  m1, m0, m2, m0)
+        SHA_NI_ROUNDS(2,  m2, m1, m3, m1)
+        SHA_NI_ROUNDS(3,  m3, m2, m0, m2)
+        SHA_NI_ROUNDS(4,  m0, m3, m1, m3)
+        SHA_NI_ROUNDS(5,  m1, m0, m2, m0)
+        SHA_NI_ROUNDS(6,  m2, m1, m3, m1)
+        SHA_NI_ROUNDS(7,  m3, m2, m0, m2)
+        SHA_NI_ROUNDS(8,  m0, m3, m1, m3)
+        SHA_NI_ROUNDS(9,  m1, m0, m2, m0)
+        SHA_NI_ROUNDS(10, m2, m1, m3, m1)
+        SHA_NI_ROUNDS(11, m3, m2, m0, m2)
+        SHA_NI_ROUNDS(12, m0, m3, m1, m3)
+        SHA_NI_ROUNDS(13, m1, m0, m2, m0)
+        SHA_NI_ROUNDS(14, m2, m1, m3, m1)
+        SHA_NI_ROUNDS(15, m3, m2, m0, m2)
+
+        state0 = _mm_add_epi32(state0, abefSaved);
+        state1 = _mm_add_epi32(state1, cdghSaved);
+    }
+
+    // Back to ABCD and EFGH
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), state1);
+}
+
+#undef SHA_NI_ROUNDS
+
+} // namespace
+
+SHA256::Compress shaNi()
+{
+    static const bool supported = cpuHasShaNi();
+    return supported ? &compressShaNi : nullptr;
+}
+
+#else
+
+SHA256::Compress shaNi()
+{
+    return nullptr;
+}
+
+#endif // SHA256_HAVE_SHA_NI
+
+#ifdef SHA256_HAVE_ARMV8
+
+namespace {
+
+// Four rounds, then the next schedule words are derived in place of the used ones
+#define ARMV8_ROUNDS(g, cur, next, next2, next3)                               \
+    tmp = vaddq_u32(cur, vld1q_u32(&SHA256::K[4 * (g)]));                      \
+    if ((g) < 12)                                                              \
+    {                                                                          \
+        cur = vsha256su0q_u32(cur, next);                                      \
+    }                                                                          \
+    abcd = state0;                                                             \
+    state0 = vsha256hq_u32(state0, state1, tmp);                               \
+    state1 = vsha256h2q_u32(state1, abcd, tmp);                                \
+    if ((g) < 12)                                                              \
+    {                                                                          \
+        cur = vsha256su1q_u32(cur, next2, next3);                              \
+    }
+
+void compressArmv8(uint32_t state[8], const uint8_t* data, size_t blocks)
+{
+    uint32x4_t state0 = vld1q_u32(&state[0]);
+    uint32x4_t state1 = vld1q_u32(&state[4]);
+
+    for (; blocks > 0; blocks--, data += 64)
+    {
+        const uint32x4_t abcdSaved = state0;
+        const uint32x4_t efghSaved = state1;
+        uint32x4_t tmp, abcd;
+
+        uint32x4_t m0 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data)));
+        uint32x4_t m1 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16)));
+        uint32x4_t m2 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 32)));
+        uint32x4_t m3 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 48)));
+
+        ARMV8_ROUNDS(0,  m0, m1, m2, m3)
+        ARMV8_ROUNDS(1,  m1, m2, m3, m0)
+        ARMV8_ROUNDS(2,  m2, m3, m0, m1)
+        ARMV8_ROUNDS(3,  m3, m0, m1, m2)
+        ARMV8_ROUNDS(4,  m0, m1, m2, m3)
+        ARMV8_ROUNDS(5,  m1, m2, m3, m0)
+        ARMV8_ROUNDS(6,  m2, m3, m0, m1)
+        ARMV8_ROUNDS(7,  m3, m0, m1, m2)
+        ARMV8_ROUNDS(8,  m0, m1, m2, m3)
+        ARMV8_ROUNDS(9,  m1, m2, m3, m0)
+        ARMV8_ROUNDS(10, m2, m3, m0, m1)
+        ARMV8_ROUNDS(11, m3, m0, m1, m2)
+        ARMV8_ROUNDS(12, m0, m1, m2, m3)
+        ARMV8_ROUNDS(13, m1, m2, m3, m0)
+        ARMV8_ROUNDS(14, m2, m3, m0, m1)
+        ARMV8_ROUNDS(15, m3, m0, m1, m2)
+
+        state0 = vaddq_u32(state0, abcdSaved);
+        state1 = vaddq_u32(state1, efghSaved);
+    }
+
+    vst1q_u32(&state[0], state0);
+    vst1q_u32(&state[4], state1);
+}
+
+#undef ARMV8_ROUNDS
+
+} // namespace
+
+SHA256::Compress armv8()
+{
+    // The build targets a CPU with the extensions, so every CPU it runs on has them
+    return &compressArmv8;
+}
+
+#else
+
+SHA256::Compress armv8()
+{
+    return nullptr;
+}
+
+#endif // SHA256_HAVE_ARMV8
+
+} // namespace sha256_accel
+} // namespace tools
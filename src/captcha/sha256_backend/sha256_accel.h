@@ -0,0 +1,20 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#pragma once
+
+#include "sha256.h"
+
+namespace tools {
+namespace sha256_accel {
+
+// Hardware block compression, nullptr if it is not built in or the CPU lacks it
+
+// x86 SHA extensions, detected at run time
+SHA256::Compress shaNi();
+// ARMv8 cryptography extensions, built when the target enables them
+SHA256::Compress armv8();
+
+} // namespace sha256_accel
+} // namespace tools
@@ -2,6 +2,8 @@
 #include "skaptcha_backend/captcha.h"
 #include "skaptcha_tools.h"
 #include "token.h"
+#include "log.h"
+#include "config/config.h"
 
 const char TOKENDELIMITER = '|';
 
@@ -18,25 +20,18 @@ unsigned int Skaptcha::answerLength()
 
 std::shared_ptr<Skaptcha::View> Skaptcha::generate(const std::string &context, std::chrono::seconds lifetime)
 {
-    auto viewPtr = std::make_shared<View>();
+    startWorker();
 
-    char *img = nullptr;
-    int imgsize = 0;
-    std::string answer(CAPTCHA_STRING_LENGTH+1, 0);
-
-    generate_captcha(&img, &imgsize, answer.data());
-    answer.pop_back(); // termination zero
-
-    auto& viewPng = viewPtr->png;
-    viewPng.resize(imgsize);
-    for (int i = 0; i < imgsize; ++i)
+    Rendered rendered;
+    if (not takeFromPool(rendered) and not render(rendered))
     {
-        viewPng[i] = img[i];
+        return nullptr;
     }
 
-    delete[] img;
+    auto viewPtr = std::make_shared<View>();
+    viewPtr->png = std::move(rendered.png);
 
-    auto token = skaptcha_tools::ExpiringToken::generate(answer + TOKENDELIMITER + skaptcha_tools::base64::encode(context), lifetime);
+    auto token = skaptcha_tools::ExpiringToken::generate(rendered.answer + TOKENDELIMITER + skaptcha_tools::base64::encode(context), lifetime);
 
     viewPtr->token = token->dump();
 
@@ -84,8 +79,103 @@ bool Skaptcha::validate(const std::string &context, const std::string &token, co
     return vector[0] == userAnswerUpper;
 }
 
+size_t Skaptcha::pooledCount() const
+{
+    std::lock_guard lock (m_poolMutex);
+    return m_pool.size();
+}
+
+bool Skaptcha::render(Rendered &rendered)
+{
+    char *img = nullptr;
+    int imgsize = 0;
+    std::string answer(CAPTCHA_STRING_LENGTH+1, 0);
+
+    generate_captcha(&img, &imgsize, answer.data());
+    answer.pop_back(); // termination zero
+
+    if (img == nullptr)
+    {
+        return false;
+    }
+
+    rendered.png.assign(img, img + imgsize);
+    rendered.answer = std::move(answer);
+    free(img); // malloc'ed by the backend
+
+    return true;
+}
+
+bool Skaptcha::takeFromPool(Rendered &rendered)
+{
+    std::lock_guard lock (m_poolMutex);
+    // The worker is woken up even on a miss: the pool size may have been raised
+    m_poolChanged.notify_one();
+    if (m_pool.empty())
+    {
+        return false;
+    }
+
+    rendered = std::move(m_pool.front());
+    m_pool.pop_front();
+    return true;
+}
+
+void Skaptcha::startWorker()
+{
+    // Started on first use, so processes that never show a captcha do not render any
+    std::call_once(m_workerStarted, [this]() {
+        m_workerThreadPtr = std::make_unique<std::thread>([this]() { workerLoop(); });
+    });
+}
+
+void Skaptcha::workerLoop()
+{
+    while (true)
+    {
+        {
+            std::unique_lock lock (m_poolMutex);
+            m_poolChanged.wait(lock, [this]() {
+                return m_stopping or m_pool.size() < Config::instance().apiCaptchaPoolSize();
+            });
+            if (m_stopping)
+            {
+                return;
+            }
+        }
+
+        Rendered rendered;
+        if (not render(rendered))
+        {
+            PLOG_ERROR << "Skaptcha: pre-generation is stopped, the image can not be rendered";
+            return;
+        }
+
+        std::lock_guard lock (m_poolMutex);
+        m_pool.push_back(std::move(rendered));
+    }
+}
+
 Skaptcha::Skaptcha()
 {
-    srand(time(NULL));
+    // The glyphs are decoded here once, not for every generated captcha
+    if (captcha_init() != 0)
+    {
+        PLOG_ERROR << "Skaptcha: letter images can not be decoded";
+    }
+}
+
+Skaptcha::~Skaptcha()
+{
+    {
+        std::lock_guard lock (m_poolMutex);
+        m_stopping = true;
+    }
+    m_poolChanged.notify_all();
+
+    if (m_workerThreadPtr && m_workerThreadPtr->joinable())
+    {
+        m_workerThreadPtr->join();
+    }
 }
 
@@ -11,6 +11,10 @@
 #include <string>
 #include <memory>
 #include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 
 class Skaptcha
 {
@@ -22,8 +26,8 @@ public:
     };
 
     /*
-     * The singleton is used for guaranteed initialization of srand(time(NULL)),
-     * this is the need for a backend written in C.
+     * The singleton is used for guaranteed initialization
+     * of the backend glyph atlas, this is the need for a backend written in C.
      */
     static Skaptcha& instance();
     static unsigned answerLength();
@@ -33,12 +37,42 @@ public:
      * For example, the IP address to which the captcha was issued,
      * or the unique user ID that will be assigned to it after completing the captcha.
      */
+    // Returns nullptr if the backend has failed to initialize
     std::shared_ptr<View> generate(const std::string& context, std::chrono::seconds lifetime = std::chrono::seconds(60*3));
     bool validate(const std::string& context, const std::string& token, const std::string& answer);
 
+    // Number of pre-rendered images waiting in the pool
+    size_t pooledCount() const;
+
 private:
+    /*
+     * Pre-rendered image and its answer. A background worker keeps up to
+     * captcha_pool_size of them, so generate() only has to bind a pooled
+     * image to the context and sign the token. When the pool is empty
+     * (a burst or a disabled pool) the image is rendered in place.
+     */
+    struct Rendered
+    {
+        std::vector<uint8_t> png;
+        std::string answer;
+    };
+
     Skaptcha();
+    ~Skaptcha();
     Skaptcha(const Skaptcha&) = delete;
     Skaptcha(Skaptcha&&) = delete;
     Skaptcha& operator=(const Skaptcha&) = delete;
+
+    // Thread-safe: the backend keeps its random and encoder state per thread
+    bool render(Rendered& rendered);
+    bool takeFromPool(Rendered& rendered);
+    void startWorker();
+    void workerLoop();
+
+    mutable std::mutex m_poolMutex;
+    std::condition_variable m_poolChanged;
+    std::deque<Rendered> m_pool;
+    std::unique_ptr<std::thread> m_workerThreadPtr;
+    std::once_flag m_workerStarted;
+    bool m_stopping = false;
 };
@@ -10,6 +10,11 @@ Copyright (c) Kopikova Sofia, 2020
    -- Segment shuffle logic replaced by Y. Kotov
    -- Portions copyright (c) Y. Kotov, 2024
 
+   -- Letter images are decoded once into a glyph atlas, the PNG
+   -- is written by a specialized encoder (captcha_png.c) and rand()
+   -- is replaced with a per-thread ChaCha20 generator by Roman Lyubimov
+   -- Portions copyright (c) Roman Lyubimov, 2026
+
 This software is provided 'as-is', without any express or implied
 warranty. In no event will the authors be held liable for any damages
 arising from the use of this software.
@@ -39,7 +44,10 @@ freely, subject to the following restrictions:
 #include <time.h>
 #include <string.h>
 #include <math.h>
+#include <pthread.h>
 #include "lodepng.h"
+#include "captcha_png.h"
+#include "../chacha20_backend/chacha20_drbg.h"
 #include "pictures.cpp"
 
 #include "captcha.h"
@@ -138,6 +146,15 @@ static const int letter_sizes[] = {
 
 const char used_letters[] = "ABCDEFGHIJKLMNPQRSTUVWXYZ23456789";
 
+/* Decoded letter images, read-only after captcha_init().
+ * Only the top HEIGHT_ONE rows of a letter are kept: generate_captcha()
+ * clears everything below them anyway (the Q image is taller).
+ * They are decoded exactly once, whichever thread gets there first; a
+ * failure is final, it is not retried by every rendering thread. */
+static unsigned char glyph_atlas[NUM][HEIGHT_ONE][WIDTH_ONE];
+static pthread_once_t glyph_atlas_once = PTHREAD_ONCE_INIT;
+static int glyph_atlas_status = 1; /* 0 - decoded */
+
 #define NUM_OF_USED_LETTERS (sizeof(used_letters)-1)
 
 static unsigned* generate()
@@ -149,7 +166,7 @@ static unsigned* generate()
 	int i;
 	for(i = 0; i < LENGTH; i++)
 	{
-		x = rand() % NUM_OF_USED_LETTERS;
+		x = chacha20_drbg_uniform(NUM_OF_USED_LETTERS);
 		s[i] = x;
 	}
 	s[LENGTH] = '\0';
@@ -174,7 +191,7 @@ static void mix(char *ans, unsigned* s, xpair coords[])
 	int i;
 	for(i = 0; i < SEGS - 1; i++)
 	{
-		len_segs[i] = rand() % (LENGTH - (SEGS - i - 1)
+		len_segs[i] = chacha20_drbg_uniform(LENGTH - (SEGS - i - 1)
 							- asum(len_segs, i))
 					  + 1;
 		coords[i].sz = len_segs[i];
@@ -188,7 +205,7 @@ static void mix(char *ans, unsigned* s, xpair coords[])
 		max_order *= i;
 
 	/* Calculate order of segments excluding the trivial one. */
-	unsigned order = 1 + rand() % (max_order - 1);
+	unsigned order = 1 + chacha20_drbg_uniform(max_order - 1);
 
 	/* Prepare the list of no processed segments.
 	 * The formula is a bit weird just to make order=0 match 0,1,2,3. */
@@ -308,72 +325,73 @@ static void rect(unsigned char** in, unsigned x1, unsigned x2,
 		}
 }
 
-static unsigned char* reunis(const unsigned* str, unsigned* w, unsigned* h)
+static void decode_glyph_atlas(void)
 {
-	unsigned err;
-
-	unsigned char** images2 =
-			(unsigned char**)malloc(LENGTH * sizeof(size_t));
+	unsigned n;
 
-	unsigned width1 = 0, height1 = 0;
+	captcha_png_init();
 
-	unsigned i;
-	for(i = 0; i < LENGTH; i++)
+	for(n = 0; n < NUM; n++)
 	{
-		size_t nn = str[i];
+		unsigned char* glyph = NULL;
+		unsigned width1 = 0, height1 = 0;
+		unsigned err;
 
 		LodePNGState state;
 		lodepng_state_init(&state);
 		state.info_raw.colortype = LCT_GREY;
 		state.info_raw.bitdepth = 8;
 
-		err = lodepng_decode(images2 + i, &width1, &height1,
-				&state, letters[nn], letter_sizes[nn]);
+		err = lodepng_decode(&glyph, &width1, &height1,
+				&state, letters[n], letter_sizes[n]);
 
 		lodepng_state_cleanup(&state);
 
-#if 0  /* error handling removed by avst */
-		if(err)
+		if(err || width1 != WIDTH_ONE || height1 < HEIGHT_ONE)
 		{
-			printf("decoder error %u : %s\n", err,
-						lodepng_error_text(err));
-			exit(1);
+			free(glyph);
+			return;
 		}
-#endif
-		if(err)
-			return NULL;
+
+		memcpy(glyph_atlas[n], glyph, WIDTH_ONE * HEIGHT_ONE);
+		free(glyph);
 	}
 
-	*w = width1 * LENGTH;
+	glyph_atlas_status = 0;
+}
+
+int captcha_init(void)
+{
+	pthread_once(&glyph_atlas_once, decode_glyph_atlas);
+	return glyph_atlas_status;
+}
+
+static unsigned char* reunis(const unsigned* str, unsigned* w, unsigned* h)
+{
+	if(captcha_init())
+		return NULL;
+
+	*w = WIDTH_ONE * LENGTH;
 	*h = HEIGHT;
 
 	unsigned char* image = (unsigned char*)malloc((*w) * (*h) * LENGTH + 7);
 
-	unsigned y;
-	for(y = 0; y < height1; y++)
+	unsigned y, i;
+	for(y = 0; y < HEIGHT_ONE; y++)
 	{
 		for(i = 0; i < LENGTH; i++)
 		{
-			memcpy(image + y * (*w) + i * width1, *(images2 + i)
-						 + (y * width1), width1);
+			memcpy(image + y * (*w) + i * WIDTH_ONE,
+				   glyph_atlas[str[i]][y], WIDTH_ONE);
 		}
 	}
 
-	for(i = 0; i < LENGTH; i++)
-	{
-		free(images2[i]);
-	}
-	free(images2);
-
 	return image;
 }
 
 void generate_captcha(char** img, int* imgsize, char* answer)
 {
 	size_t outsize;
-#if 0
-	unsigned error;
-#endif
 	unsigned char** out = (unsigned char**)img;
 	unsigned* s1 = generate();
 
@@ -390,6 +408,12 @@ void generate_captcha(char** img, int* imgsize, char* answer)
 	unsigned width = 0, height = 0;
 	fin = reunis(s1, &width, &height);
 	free(s1);
+	if(!fin)
+	{
+		*out = NULL;
+		*imgsize = 0;
+		return;
+	}
 	/*printf("Width: %d\nHeight: %d\n", width, height);*/
 
     unsigned char color = 0;
@@ -418,28 +442,7 @@ void generate_captcha(char** img, int* imgsize, char* answer)
 				x2 + sz * WIDTH_ONE / 2 - 2, width, height);
 	}
 
-	LodePNGState state;
-	lodepng_state_init(&state);
-	state.info_png.color.colortype = LCT_GREY;
-	state.info_png.color.bitdepth = 8;
-	state.info_raw.colortype = LCT_GREY;
-	state.info_raw.bitdepth = 8;
-	state.encoder.auto_convert = 0;
-
-#if 0  /* error handling removed by avst */
-	error =
-#endif
-	lodepng_encode(out, &outsize, fin, width, height, &state);
+	*out = captcha_png_encode(fin, width, height, &outsize);
 	*imgsize = outsize;
 	free(fin);
-
-#if 0  /* error handling removed by avst */
-	if(error)
-	{
-		printf("encoder error %u : %s\n", error,
-						lodepng_error_text(error));
-		exit(2);
-	}
-#endif
-	lodepng_state_cleanup(&state);
 }
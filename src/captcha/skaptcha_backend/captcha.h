@@ -36,10 +36,18 @@ enum {
 extern "C" {
 #endif
 
+/*
+   Decodes the letter images into a glyph atlas, returns 0 on success.
+   The decoding runs once (generate_captcha() calls it too), later calls
+   return its result; it is safe to call from several threads.
+*/
+int captcha_init(void);
+
 /*
    *img will contain the captcha PNG as bytes (it is quite small
         -- several KB); it is malloc'ed and must be free'd by
-        the caller once the image is no longer needed;
+        the caller once the image is no longer needed (NULL if
+        captcha_init() has failed);
    *imgsize will be filled with count of bytes in img;
    answer must point to a char buffer of at least CAPTCHA_STRING_LENGTH+1
         cells, it will be filled with the captcha answer
@@ -0,0 +1,378 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#include "captcha_png.h"
+#include "lodepng.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+	MIN_MATCH = 3,
+	MAX_MATCH = 258,
+	MAX_INSERT = 16,
+	MAX_DISTANCE = 32768, /* the deflate window */
+	HASH_BITS = 12,
+	HASH_SIZE = 1 << HASH_BITS,
+	END_OF_BLOCK = 256
+};
+
+static const unsigned short length_base[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const unsigned char length_extra[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const unsigned short dist_base[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+	8193, 12289, 16385, 24577
+};
+static const unsigned char dist_extra[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+/* Fixed Huffman codes (RFC 1951, 3.2.6), bit-reversed for an LSB-first writer */
+static unsigned short lit_code[288];
+static unsigned char lit_bits[288];
+static unsigned char dist_code[30];
+/* Length 3..258 to its index in length_base */
+static unsigned char length_symbol[MAX_MATCH + 1];
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+/* Frees the scratch space of a thread when it exits */
+static pthread_key_t scratch_key;
+
+static unsigned reverse_bits(unsigned code, unsigned bits)
+{
+	unsigned result = 0, i;
+	for(i = 0; i < bits; i++)
+	{
+		result = (result << 1) | ((code >> i) & 1u);
+	}
+	return result;
+}
+
+static void free_scratch(void* block)
+{
+	free(block);
+}
+
+static void build_tables(void)
+{
+	unsigned s, len;
+
+	for(s = 0; s < 288; s++)
+	{
+		unsigned code, bits;
+		if(s < 144)      { code = 0x30 + s;          bits = 8; }
+		else if(s < 256) { code = 0x190 + (s - 144); bits = 9; }
+		else if(s < 280) { code = s - 256;           bits = 7; }
+		else             { code = 0xC0 + (s - 280);  bits = 8; }
+		lit_code[s] = (unsigned short)reverse_bits(code, bits);
+		lit_bits[s] = (unsigned char)bits;
+	}
+
+	for(s = 0; s < 30; s++)
+		dist_code[s] = (unsigned char)reverse_bits(s, 5);
+
+	for(s = 0, len = MIN_MATCH; len <= MAX_MATCH; len++)
+	{
+		while(s < 28 && len >= length_base[s + 1])
+			s++;
+		length_symbol[len] = (unsigned char)s;
+	}
+
+	pthread_key_create(&scratch_key, free_scratch);
+}
+
+void captcha_png_init(void)
+{
+	pthread_once(&tables_once, build_tables);
+}
+
+typedef struct {
+	unsigned char* out;
+	uint64_t bitbuf;
+	unsigned bitcount;
+} bit_writer;
+
+static void put_bits(bit_writer* bw, unsigned value, unsigned bits)
+{
+	bw->bitbuf |= (uint64_t)value << bw->bitcount;
+	bw->bitcount += bits;
+	while(bw->bitcount >= 8)
+	{
+		*bw->out++ = (unsigned char)bw->bitbuf;
+		bw->bitbuf >>= 8;
+		bw->bitcount -= 8;
+	}
+}
+
+static void put_literal(bit_writer* bw, unsigned symbol)
+{
+	put_bits(bw, lit_code[symbol], lit_bits[symbol]);
+}
+
+static void put_match(bit_writer* bw, unsigned len, unsigned dist)
+{
+	unsigned ls = length_symbol[len];
+	unsigned ds = 29;
+
+	put_literal(bw, 257 + ls);
+	if(length_extra[ls])
+		put_bits(bw, len - length_base[ls], length_extra[ls]);
+
+	while(dist_base[ds] > dist)
+		ds--;
+	put_bits(bw, dist_code[ds], 5);
+	if(dist_extra[ds])
+		put_bits(bw, dist - dist_base[ds], dist_extra[ds]);
+}
+
+static unsigned match_length(const unsigned char* data, size_t pos,
+                             size_t candidate, size_t limit)
+{
+	unsigned len = 0;
+
+	/* eight bytes at a time, the runs of background pixels are long */
+	while(len + 8 <= limit)
+	{
+		uint64_t a, b;
+		memcpy(&a, data + candidate + len, 8);
+		memcpy(&b, data + pos + len, 8);
+		if(a != b)
+			break;
+		len += 8;
+	}
+	while(len < limit && data[candidate + len] == data[pos + len])
+		len++;
+	return len;
+}
+
+static unsigned hash3(const unsigned char* p)
+{
+	return ((p[0] << 8) ^ (p[1] << 4) ^ p[2]) & (HASH_SIZE - 1);
+}
+
+/* Greedy LZ77 over the filtered scanlines into a single fixed Huffman block */
+static unsigned char* deflate_fixed(unsigned char* out, const unsigned char* data,
+                                    size_t size, size_t stride, size_t* head)
+{
+	bit_writer bw = { out, 0, 0 };
+	size_t pos = 0;
+
+	memset(head, 0, HASH_SIZE * sizeof(*head));
+
+	put_bits(&bw, 1, 1); /* BFINAL */
+	put_bits(&bw, 1, 2); /* BTYPE = fixed Huffman */
+
+	while(pos < size)
+	{
+		size_t limit = size - pos;
+		unsigned best = 0, best_dist = 0;
+
+		if(limit > MAX_MATCH)
+			limit = MAX_MATCH;
+
+		if(limit >= MIN_MATCH)
+		{
+			/* the pixel to the left, the pixel above, the last same 3 bytes */
+			size_t candidates[3];
+			unsigned n = 0, i;
+			unsigned h = hash3(data + pos);
+
+			if(pos >= 1)
+				candidates[n++] = pos - 1;
+			if(pos >= stride && stride <= MAX_DISTANCE)
+				candidates[n++] = pos - stride;
+			if(head[h] && pos - (head[h] - 1) <= MAX_DISTANCE)
+				candidates[n++] = head[h] - 1;
+
+			for(i = 0; i < n && best < limit; i++)
+			{
+				unsigned len = match_length(data, pos, candidates[i], limit);
+				if(len > best)
+				{
+					best = len;
+					best_dist = (unsigned)(pos - candidates[i]);
+				}
+			}
+		}
+
+		if(best >= MIN_MATCH)
+		{
+			size_t end = pos + best;
+			put_match(&bw, best, best_dist);
+			/* only the tail of a long match is worth remembering */
+			if(best > MAX_INSERT)
+				pos = end - MAX_INSERT;
+			for(; pos < end; pos++)
+			{
+				if(pos + MIN_MATCH <= size)
+					head[hash3(data + pos)] = pos + 1;
+			}
+		}
+		else
+		{
+			if(pos + MIN_MATCH <= size)
+				head[hash3(data + pos)] = pos + 1;
+			put_literal(&bw, data[pos]);
+			pos++;
+		}
+	}
+
+	put_literal(&bw, END_OF_BLOCK);
+	if(bw.bitcount)
+		put_bits(&bw, 0, 8 - bw.bitcount);
+
+	return bw.out;
+}
+
+static unsigned adler32(const unsigned char* data, size_t size)
+{
+	unsigned s1 = 1, s2 = 0;
+	while(size > 0)
+	{
+		/* 5552 is the largest block before s2 may overflow */
+		size_t block = size > 5552 ? 5552 : size;
+		size -= block;
+		for(; block >= 8; block -= 8, data += 8)
+		{
+			s1 += data[0]; s2 += s1;
+			s1 += data[1]; s2 += s1;
+			s1 += data[2]; s2 += s1;
+			s1 += data[3]; s2 += s1;
+			s1 += data[4]; s2 += s1;
+			s1 += data[5]; s2 += s1;
+			s1 += data[6]; s2 += s1;
+			s1 += data[7]; s2 += s1;
+		}
+		while(block--)
+		{
+			s1 += *data++;
+			s2 += s1;
+		}
+		s1 %= 65521;
+		s2 %= 65521;
+	}
+	return (s2 << 16) | s1;
+}
+
+static unsigned char* put_u32(unsigned char* p, unsigned value)
+{
+	p[0] = (unsigned char)(value >> 24);
+	p[1] = (unsigned char)(value >> 16);
+	p[2] = (unsigned char)(value >> 8);
+	p[3] = (unsigned char)value;
+	return p + 4;
+}
+
+/* Fills in the length and the CRC of a chunk whose type starts at chunk + 4 */
+static unsigned char* finish_chunk(unsigned char* chunk, unsigned char* end)
+{
+	unsigned length = (unsigned)(end - chunk - 8);
+	put_u32(chunk, length);
+	return put_u32(end, lodepng_crc32(chunk + 4, length + 4));
+}
+
+/*
+   Scratch space of the calling thread: the match hash, the filtered
+   scanlines and the PNG being written. It is kept between calls, so
+   encoding a captcha costs one allocation, the returned image itself,
+   and freed by scratch_key when the thread exits.
+*/
+static _Thread_local unsigned char* scratch = NULL;
+static _Thread_local size_t scratch_size = 0;
+
+static unsigned char* reserve_scratch(size_t size)
+{
+	if(scratch_size < size)
+	{
+		unsigned char* grown = (unsigned char*)realloc(scratch, size);
+		if(!grown)
+			return NULL;
+		scratch = grown;
+		scratch_size = size;
+		pthread_setspecific(scratch_key, grown);
+	}
+	return scratch;
+}
+
+unsigned char* captcha_png_encode(const unsigned char* grey,
+                                  unsigned width, unsigned height,
+                                  size_t* outsize)
+{
+	static const unsigned char signature[8] =
+		{ 137, 80, 78, 71, 13, 10, 26, 10 };
+
+	const size_t stride = (size_t)width + 1;
+	const size_t raw_size = stride * height;
+	/* 9 bits per literal at most, plus the PNG and zlib framing */
+	const size_t png_bound = raw_size * 9 / 8 + 128;
+
+	unsigned char *buffer, *png, *p, *chunk, *result;
+	unsigned char* raw;
+	size_t* head;
+	unsigned y;
+
+	captcha_png_init();
+
+	buffer = reserve_scratch(HASH_SIZE * sizeof(size_t) + raw_size + png_bound);
+	if(!buffer)
+	{
+		*outsize = 0;
+		return NULL;
+	}
+	head = (size_t*)(void*)buffer;
+	raw = buffer + HASH_SIZE * sizeof(size_t);
+	png = raw + raw_size;
+
+	for(y = 0; y < height; y++)
+	{
+		raw[y * stride] = 0; /* filter type None */
+		memcpy(raw + y * stride + 1, grey + (size_t)y * width, width);
+	}
+
+	p = png;
+	memcpy(p, signature, sizeof(signature));
+	p += sizeof(signature);
+
+	chunk = p;
+	p = put_u32(p + 4, 0x49484452); /* IHDR */
+	p = put_u32(p, width);
+	p = put_u32(p, height);
+	*p++ = 8; /* bit depth */
+	*p++ = 0; /* greyscale */
+	*p++ = 0; /* deflate */
+	*p++ = 0; /* adaptive filtering */
+	*p++ = 0; /* no interlace */
+	p = finish_chunk(chunk, p);
+
+	chunk = p;
+	p = put_u32(p + 4, 0x49444154); /* IDAT */
+	*p++ = 0x78; /* deflate, 32K window */
+	*p++ = 0x01; /* fastest, FCHECK */
+	p = deflate_fixed(p, raw, raw_size, stride, head);
+	p = put_u32(p, adler32(raw, raw_size));
+	p = finish_chunk(chunk, p);
+
+	chunk = p;
+	p = put_u32(p + 4, 0x49454E44); /* IEND */
+	p = finish_chunk(chunk, p);
+
+	*outsize = (size_t)(p - png);
+	result = (unsigned char*)malloc(*outsize);
+	if(!result)
+	{
+		*outsize = 0;
+		return NULL;
+	}
+	memcpy(result, png, *outsize);
+	return result;
+}
@@ -0,0 +1,39 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#ifndef CAPTCHA_PNG_INCLUDED
+#define CAPTCHA_PNG_INCLUDED
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+   Builds the Huffman code tables, once; captcha_png_encode() calls it
+   too. Safe to call from several threads.
+*/
+void captcha_png_init(void);
+
+/*
+   PNG encoder specialized for the captcha bitmap: 8-bit greyscale,
+   no filter and a single fixed-Huffman deflate block. Matches are only
+   looked for at the previous pixel, the pixel above and the last
+   occurrence of the same three bytes, so encoding is one pass over the
+   image. The working memory is kept per thread between calls and freed
+   when the thread exits.
+
+   Returns a malloc'ed PNG (to be free'd by the caller) and stores its
+   size into *outsize, or NULL if the allocation has failed.
+*/
+unsigned char* captcha_png_encode(const unsigned char* grey,
+                                  unsigned width, unsigned height,
+                                  size_t* outsize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -4,11 +4,10 @@
 
 #include "skaptcha_tools.h"
 #include "chacha20_backend/portable8439.h"
+#include "chacha20_backend/chacha20_drbg.h"
 #include "sha256_backend/sha256.h"
 #include "../crowlib/crow/utility.h" // for base64: you can use another
 
-#include <random>
-
 std::string skaptcha_tools::base64::encode(const std::string &data)
 {
     return crow::utility::base64encode(data, data.size());
@@ -133,16 +132,7 @@ std::string skaptcha_tools::string::simpleRandom(size_t length)
 {
     std::string result;
     result.resize( length );
-
-    std::random_device rd;
-    std::mt19937 generator(rd());
-    std::uniform_int_distribution<> distribution(0, 255);
-
-    for (int8_t i = 0; i < length; ++i)
-    {
-        result[i] = distribution(generator);
-    }
-
+    chacha20_drbg_fill(result.data(), length);
     return result;
 }
 
@@ -3,49 +3,55 @@
 // For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
 
 #include "chunk.h"
+#include "chunkmemorypool.h"
 
-#include <mutex>
+#include <bit>
 
 namespace TransferSessionDetails {
 
-Chunk::Chunk(AtomicSetSizeAccess consumerCount, const uint8_t *data, size_t size) :
-    m_data(new std::vector<uint8_t>(data, data+size)),
-    m_consumerExpected(consumerCount)
+Chunk::Chunk(std::string &&data) :
+    m_data(ChunkMemoryPool::instance().share(std::move(data)))
 {
 
 }
 
-size_t Chunk::howMuchIsLeft() const
+Chunk::Chunk(std::shared_ptr<const std::string> data) :
+    m_data(std::move(data))
 {
-    std::shared_lock guard(m_usesMutex);
 
-    const size_t expected = m_consumerExpected.value();
-    if (m_uses >= expected)
-    {
-        return 0;
-    }
+}
+
+Chunk::Chunk(Chunk &&another) noexcept :
+    m_data(another.m_data),
+    m_confirmed(another.m_confirmed.load())
+{
 
-    return expected - m_uses;
 }
 
-size_t Chunk::usesCount() const
+bool Chunk::confirm(size_t consumerSlot)
 {
-    return m_uses;
+    const ConsumerMask bit = ConsumerMask(1) << consumerSlot;
+    return (m_confirmed.fetch_or(bit) & bit) == 0;
 }
 
-const std::shared_ptr<const std::vector<uint8_t>> Chunk::data() const
+void Chunk::forget(size_t consumerSlot)
 {
-    return m_data;
+    m_confirmed.fetch_and(~(ConsumerMask(1) << consumerSlot));
+}
+
+size_t Chunk::howMuchIsLeft(ConsumerMask expected) const
+{
+    return std::popcount(expected & ~m_confirmed.load());
 }
 
-void Chunk::incrementUses()
+size_t Chunk::usesCount() const
 {
-    std::unique_lock guard(m_usesMutex);
+    return std::popcount(m_confirmed.load());
+}
 
-    if (m_consumerExpected.value() > m_uses)
-    {
-        ++m_uses;
-    }
+const std::shared_ptr<const std::string> Chunk::data() const
+{
+    return m_data;
 }
 
 size_t Chunk::dataSize() const
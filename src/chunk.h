@@ -4,42 +4,41 @@
 
 #pragma once
 
-#include "atomicset.h"
-
 #include <atomic>
+#include <cstdint>
 #include <memory>
-#include <shared_mutex>
-#include <vector>
+#include <string>
 
 namespace TransferSessionDetails {
 
-class AtomicSetSizeAccess
-{
-public:
-    AtomicSetSizeAccess(std::shared_ptr<AtomicSet<std::string>> set)
-        : m_set(set) {}
-    size_t value() const { return m_set->size(); }
-
-private:
-    std::shared_ptr<AtomicSet<std::string>> m_set;
-};
+// One bit per consumer slot of a session
+using ConsumerMask = uint64_t;
 
 class Chunk
 {
 public:
-    Chunk(AtomicSetSizeAccess consumerCount, const uint8_t* data, size_t size);
-
-    size_t howMuchIsLeft() const;
+    static constexpr size_t MAX_CONSUMERS = sizeof(ConsumerMask) * 8;
+
+    // The data is taken over by the chunk without copying
+    Chunk(std::string&& data);
+    // The data is already owned by the chunk memory pool
+    Chunk(std::shared_ptr<const std::string> data);
+    // Used by the Buffer ring when it relocates its slots
+    Chunk(Chunk&& another) noexcept;
+
+    // Marks the chunk as received by the consumer; false if it was already marked
+    bool confirm(size_t consumerSlot);
+    // Drops the mark of a consumer that has left, so its slot can be reused
+    void forget(size_t consumerSlot);
+    // Number of expected consumers that have not confirmed the chunk yet
+    size_t howMuchIsLeft(ConsumerMask expected) const;
     size_t usesCount() const;
-    const std::shared_ptr<const std::vector<uint8_t>> data() const;
-    void incrementUses();
+    const std::shared_ptr<const std::string> data() const;
     size_t dataSize() const;
 
 private:
-    const std::shared_ptr<const std::vector<uint8_t>> m_data;
-    const AtomicSetSizeAccess m_consumerExpected;
-    mutable std::shared_mutex m_usesMutex;
-    mutable std::atomic<size_t> m_uses = 0;
+    const std::shared_ptr<const std::string> m_data;
+    std::atomic<ConsumerMask> m_confirmed = 0;
 };
 
 } // namespace TransferSessionDetails
@@ -0,0 +1,255 @@
+// Copyright (C) 2025-2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#include "chunkmemorypool.h"
+#include "config/config.h"
+#include "log.h"
+
+#include <algorithm>
+
+ChunkMemoryPool &ChunkMemoryPool::instance()
+{
+    /*
+     * Never destroyed: chunk data owned by other singletons may be released
+     * during static destruction and still has to find the pool.
+     */
+    static ChunkMemoryPool* pool = new ChunkMemoryPool;
+    return *pool;
+}
+
+std::string ChunkMemoryPool::acquire()
+{
+    const size_t slab = slabSize();
+    {
+        std::lock_guard lock (m_mutex);
+        while (not m_free.empty())
+        {
+            std::string buffer = std::move(m_free.back());
+            m_free.pop_back();
+            // Slabs left over from a different max_chunk_size are dropped
+            if (isSlab(buffer, slab))
+            {
+                return buffer;
+            }
+        }
+    }
+
+    std::string buffer;
+    buffer.reserve(slab);
+    return buffer;
+}
+
+std::shared_ptr<const std::string> ChunkMemoryPool::share(std::string &&data)
+{
+    shrinkToFit(data);
+
+    bool stateChanged = false;
+    {
+        std::lock_guard lock (m_mutex);
+        m_bytesInUse += data.capacity();
+        stateChanged = updateBudgetState();
+    }
+
+    if (stateChanged)
+    {
+        notifyBudgetState();
+    }
+
+    return wrap(std::move(data));
+}
+
+std::shared_ptr<const std::string> ChunkMemoryPool::admit(std::string &data)
+{
+    shrinkToFit(data);
+
+    const size_t budget = Config::instance().transferSessionMemoryBudget();
+    bool admitted = true;
+    bool stateChanged = false;
+    {
+        std::lock_guard lock (m_mutex);
+        if (budget > 0 and m_bytesInUse + data.capacity() > budget)
+        {
+            admitted = false;
+            stateChanged = not m_budgetExhausted.exchange(true);
+        }
+        else
+        {
+            m_bytesInUse += data.capacity();
+            stateChanged = updateBudgetState();
+        }
+    }
+
+    if (stateChanged)
+    {
+        notifyBudgetState();
+    }
+
+    return admitted ? wrap(std::move(data)) : nullptr;
+}
+
+ChunkMemoryPool::Statistics ChunkMemoryPool::statistics() const
+{
+    Statistics stats;
+    stats.slabSize = slabSize();
+    stats.budget = Config::instance().transferSessionMemoryBudget();
+
+    std::lock_guard lock (m_mutex);
+    stats.inUse = m_inUse;
+    stats.free = m_free.size();
+    stats.freeHolders = m_freeHolders.size();
+    stats.highWater = m_highWater;
+    stats.bytesInUse = m_bytesInUse;
+    return stats;
+}
+
+size_t ChunkMemoryPool::slabSize() const
+{
+    return Config::instance().transferSessionMaxChunkSize();
+}
+
+bool ChunkMemoryPool::isSlab(const std::string &buffer, size_t slabSize) const
+{
+    return slabSize > 0 and buffer.capacity() >= slabSize and buffer.capacity() <= slabSize * 2;
+}
+
+void ChunkMemoryPool::shrinkToFit(std::string &data)
+{
+    /*
+     * A tiny chunk must not pin a whole slab. The copy is at most an eighth
+     * of a slab; a bigger chunk keeps its slab, charged in full to the budget.
+     */
+    if (isSlab(data, slabSize()) and data.size() <= data.capacity() / 8)
+    {
+        std::string exact(data.data(), data.size());
+        recycle(std::move(data));
+        data = std::move(exact);
+    }
+}
+
+std::shared_ptr<const std::string> ChunkMemoryPool::wrap(std::string &&data)
+{
+    {
+        std::lock_guard lock (m_mutex);
+        ++m_inUse;
+        if (m_inUse > m_highWater)
+        {
+            m_highWater = m_inUse;
+            PLOG_DEBUG << "ChunkMemoryPool: high-water mark is " << m_highWater << " chunks";
+        }
+    }
+
+    auto payload = std::allocate_shared<Payload>(HolderAllocator<Payload>(), std::move(data));
+    const std::string* shared = &payload->data;
+    return std::shared_ptr<const std::string>(std::move(payload), shared);
+}
+
+ChunkMemoryPool::Payload::~Payload()
+{
+    ChunkMemoryPool::instance().release(data);
+}
+
+void ChunkMemoryPool::release(std::string &data)
+{
+    bool stateChanged = false;
+    {
+        std::lock_guard lock (m_mutex);
+        --m_inUse;
+        m_bytesInUse -= std::min(m_bytesInUse, data.capacity());
+        stateChanged = updateBudgetState();
+    }
+
+    recycle(std::move(data));
+
+    if (stateChanged)
+    {
+        notifyBudgetState();
+    }
+}
+
+void* ChunkMemoryPool::allocateHolder(size_t bytes)
+{
+    {
+        std::lock_guard lock (m_mutex);
+        if (m_holderSize == 0)
+        {
+            m_holderSize = bytes;
+        }
+        if (bytes == m_holderSize and not m_freeHolders.empty())
+        {
+            void* block = m_freeHolders.back();
+            m_freeHolders.pop_back();
+            return block;
+        }
+    }
+
+    return ::operator new(bytes);
+}
+
+void ChunkMemoryPool::deallocateHolder(void *block, size_t bytes)
+{
+    {
+        std::lock_guard lock (m_mutex);
+        if (bytes == m_holderSize and m_freeHolders.size() < MAX_FREE_HOLDERS)
+        {
+            m_freeHolders.push_back(block);
+            return;
+        }
+    }
+
+    ::operator delete(block);
+}
+
+void ChunkMemoryPool::recycle(std::string &&buffer)
+{
+    if (not isSlab(buffer, slabSize()))
+    {
+        return;
+    }
+
+    const size_t maxFree = Config::instance().transferSessionChunkPoolSize();
+    std::string slab = std::move(buffer);
+    slab.clear();
+
+    std::lock_guard lock (m_mutex);
+    if (m_free.size() < maxFree)
+    {
+        m_free.push_back(std::move(slab));
+    }
+}
+
+bool ChunkMemoryPool::updateBudgetState()
+{
+    // no mutex here - called privately with upstream block
+
+    const size_t budget = Config::instance().transferSessionMemoryBudget();
+    bool exhausted = false;
+    if (budget > 0)
+    {
+        const size_t slab = slabSize();
+        const size_t free = budget > m_bytesInUse ? budget - m_bytesInUse : 0;
+
+        // Hysteresis, so the senders are not toggled on every chunk at the boundary
+        exhausted = m_budgetExhausted ? free < std::min(slab * 2, budget)
+                                      : free < slab;
+    }
+
+    return m_budgetExhausted.exchange(exhausted) != exhausted;
+}
+
+void ChunkMemoryPool::notifyBudgetState()
+{
+    const bool exhausted = m_budgetExhausted;
+    if (exhausted)
+    {
+        PLOG_WARNING << "Chunk memory budget is exhausted, senders are paused";
+    }
+    else
+    {
+        PLOG_INFO << "Chunk memory budget is available again, senders are resumed";
+    }
+
+    notifySubscribers(exhausted ? Event::ChunkMemoryPool::budgetExhausted
+                                : Event::ChunkMemoryPool::budgetAvailable,
+                      std::monostate{});
+}
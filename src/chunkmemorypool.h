@@ -0,0 +1,128 @@
+// Copyright (C) 2025-2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#pragma once
+
+#include "observerpattern.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Event {
+
+enum class ChunkMemoryPool {
+//  Event                Data
+    budgetExhausted,  // none
+    budgetAvailable   // none
+};
+
+} // namespace Event
+
+template<> struct EventPayload<Event::ChunkMemoryPool> { using Type = std::monostate; };
+
+/*
+ * Process-wide pool of chunk payload buffers.
+ *
+ * Every buffer is a slab whose capacity is at least transferSessionMaxChunkSize.
+ * Chunk data is wrapped by share(): once the last reference to the chunk data
+ * is gone, its slab goes back to the free list instead of the heap, so the
+ * same few multi-megabyte blocks are reused across sessions. Receiving code
+ * takes an empty slab with acquire() to assemble the next chunk into it.
+ * The string holding the slab and the shared_ptr control block are allocated
+ * together, from a free list of such blocks, so wrapping a chunk normally
+ * takes no heap allocation at all.
+ *
+ * The pool also enforces the server-wide memory budget: the capacity of every
+ * live payload is charged against it. Once less than one max-sized chunk fits,
+ * budgetExhausted is published; budgetAvailable follows when two chunks fit
+ * again. Notifications are sent without the pool lock held.
+ */
+class ChunkMemoryPool : public Publisher<Event::ChunkMemoryPool>
+{
+public:
+    struct Statistics
+    {
+        size_t slabSize = 0;
+        size_t inUse = 0;      // Chunk payloads currently alive
+        size_t free = 0;       // Slabs waiting in the free list
+        size_t freeHolders = 0; // Recycled string + control blocks
+        size_t highWater = 0;  // Maximum of inUse since start
+        size_t bytesInUse = 0; // Charged against the budget
+        size_t budget = 0;     // 0 - unlimited
+    };
+
+    static ChunkMemoryPool& instance();
+
+    // An empty buffer with at least one slab of capacity
+    std::string acquire();
+    // Takes over the data; its buffer returns to the pool when the last reference is gone
+    std::shared_ptr<const std::string> share(std::string&& data);
+    // Same as share(), but returns nullptr and leaves the data untouched if the budget cannot take it
+    std::shared_ptr<const std::string> admit(std::string& data);
+
+    bool budgetAvailable() const { return not m_budgetExhausted; }
+
+    Statistics statistics() const;
+    size_t slabSize() const;
+
+private:
+    // The chunk data, it gives its buffer back to the pool when destroyed
+    struct Payload
+    {
+        explicit Payload(std::string&& buffer) : data(std::move(buffer)) {}
+        ~Payload();
+
+        std::string data;
+    };
+
+    // Hands out the blocks of std::allocate_shared<Payload> from the pool
+    template<typename T>
+    struct HolderAllocator
+    {
+        using value_type = T;
+
+        HolderAllocator() = default;
+        template<typename U>
+        HolderAllocator(const HolderAllocator<U>&) {}
+
+        T* allocate(size_t n) { return static_cast<T*>(ChunkMemoryPool::instance().allocateHolder(n * sizeof(T))); }
+        void deallocate(T* p, size_t n) { ChunkMemoryPool::instance().deallocateHolder(p, n * sizeof(T)); }
+
+        template<typename U>
+        bool operator==(const HolderAllocator<U>&) const { return true; }
+    };
+
+    // The holders are small, a few thousand cover the chunks of many sessions
+    static constexpr size_t MAX_FREE_HOLDERS = 4096;
+
+    ChunkMemoryPool() = default;
+    ChunkMemoryPool(const ChunkMemoryPool&) = delete;
+    ChunkMemoryPool(ChunkMemoryPool&&) = delete;
+    ChunkMemoryPool& operator=(const ChunkMemoryPool&) = delete;
+
+    bool isSlab(const std::string& buffer, size_t slabSize) const;
+    // A tiny chunk in a slab is replaced by an exact copy, the slab is recycled
+    void shrinkToFit(std::string& data);
+    std::shared_ptr<const std::string> wrap(std::string&& data);
+    void release(std::string& data);
+    void* allocateHolder(size_t bytes);
+    void deallocateHolder(void* block, size_t bytes);
+    // Puts a slab into the free list unless the list is full, other buffers are freed
+    void recycle(std::string&& buffer);
+    // Returns true when the exhausted state has changed, called with the lock held
+    bool updateBudgetState();
+    void notifyBudgetState();
+
+    mutable std::mutex m_mutex;
+    std::vector<std::string> m_free;
+    std::vector<void*> m_freeHolders;
+    size_t m_holderSize = 0; // allocate_shared<Payload> asks for one size only
+    size_t m_inUse = 0;
+    size_t m_highWater = 0;
+    size_t m_bytesInUse = 0;
+    std::atomic<bool> m_budgetExhausted = false;
+};
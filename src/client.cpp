@@ -16,10 +16,24 @@ Client::Client(const std::string &id, asio::io_context& ioContext, std::function
     m_id(id),
     m_publicId(skaptcha_tools::crypto::HashSignature::instance().sign(m_id)),
     m_wsTimeoutTimer(ioContext, onTimeout, TimerCallback::Duration(Config::instance().clientTimeout())),
-    m_ioContext(ioContext)
+    m_ioContext(ioContext),
+    m_timerWheel(TimerWheel::of(ioContext))
 {
     PLOG_DEBUG << "Client " << m_id << " created";
     m_wsTimeoutTimer.start();
+
+    const auto progressInterval = Config::instance().transferSessionProgressInterval();
+    if (progressInterval > 0)
+    {
+        // The timed emit finds the client via ClientList, as the ACK timers do
+        m_receivedProgress = std::make_unique<ProgressCoalescer>(ioContext,
+                                ProgressCoalescer::Duration(progressInterval),
+                                [id]() {
+                                    if (auto client = ClientList::instanse().get(id)) {
+                                        client->sendReceivedProgress();
+                                    }
+                                });
+    }
 }
 
 void Client::sendTextWithAck(const std::string& eventJson,
@@ -45,24 +59,20 @@ void Client::sendTextWithAck(const std::string& eventJson,
         withId.append(eventJson, 1, std::string::npos);
     }
 
-    auto timer = std::make_unique<asio::steady_timer>(m_ioContext);
-    timer->expires_after(fallback);
-
     // Timer handler looks the client up via ClientList (which owns the
     // shared_ptr). This avoids enable_shared_from_this, which is
     // ambiguous under Client's multiple Subscriber<T> inheritance.
     const std::string myInternalId = m_id;
+    auto timer = TimerWheel::makeEntry([myInternalId, id]() {
+        auto client = ClientList::instanse().get(myInternalId);
+        if (!client) return; // client already removed
+        client->resolveAck(id);
+    });
 
     {
         std::lock_guard lock(m_pendingAcksMutex);
-        m_pendingAcks.emplace(id, PendingAck{std::move(onAck), std::move(timer)});
-        auto it = m_pendingAcks.find(id);
-        it->second.fallback->async_wait([myInternalId, id](const asio::error_code& ec) {
-            if (ec) return; // cancelled — ACK arrived first or client destroyed
-            auto client = ClientList::instanse().get(myInternalId);
-            if (!client) return; // client already removed
-            client->resolveAck(id);
-        });
+        m_pendingAcks.emplace(id, PendingAck{std::move(onAck), timer});
+        m_timerWheel->arm(timer, fallback);
     }
 
     if (auto sp = m_webSocketConnection.lock())
@@ -89,11 +99,10 @@ void Client::resolveAck(uint64_t id)
         auto it = m_pendingAcks.find(id);
         if (it == m_pendingAcks.end()) return;
         cb = std::move(it->second.callback);
-        // Cancel timer if still pending; ignore errors (it may have fired already).
+        // Cancel timer if still pending (it may have fired already).
         if (it->second.fallback)
         {
-            asio::error_code ignore;
-            it->second.fallback->cancel(ignore);
+            m_timerWheel->cancel(it->second.fallback);
         }
         m_pendingAcks.erase(it);
     }
@@ -151,246 +160,72 @@ void Client::resetWsTimeoutTimerIfItActive()
     }
 }
 
-void Client::update(Event::ClientsDirect event, std::any data)
+void Client::update(Event::ClientsDirect event, const Subscriber<Event::ClientsDirect>::Payload& data)
 {
-    if (event == Event::ClientsDirect::connected)
+    auto sp = m_webSocketConnection.lock();
+    if (sp == nullptr)
     {
-        try {
-            const std::string publicId = std::any_cast<std::string>(data);
-            if (auto sp = m_webSocketConnection.lock())
-            {
-                sp->sendText( SerializableEvent::Online{publicId, true}.json() );
-            }
-        } catch (const std::bad_any_cast& e) {
-            PLOG_ERROR << "Client::update - Event::ClientsDirect::connected "
-                         "- expected std::string: " << e.what();
-        }
         return;
     }
-    else if (event == Event::ClientsDirect::disconnected)
+
+    switch (event)
     {
-        try {
-            const std::string publicId = std::any_cast<std::string>(data);
-            if (auto sp = m_webSocketConnection.lock())
-            {
-                sp->sendText( SerializableEvent::Online{publicId, false}.json() );
-            }
-        } catch (const std::bad_any_cast& e) {
-            PLOG_ERROR << "Client::update - Event::ClientsDirect::disconnected "
-                         "- expected std::string: " << e.what();
+    case Event::ClientsDirect::connected:
+    case Event::ClientsDirect::disconnected:
+        if (const auto* publicId = std::get_if<std::string>(&data))
+        {
+            sp->sendText( SerializableEvent::Online{*publicId, event == Event::ClientsDirect::connected}.json() );
         }
-        return;
-    }
-    else if (event == Event::ClientsDirect::nameChanged)
-    {
-        try {
-            const Event::Data::NameInfo nameInfo = std::any_cast<Event::Data::NameInfo>(data);
-            if (auto sp = m_webSocketConnection.lock())
-            {
-                sp->sendText( SerializableEvent::NameChanged{nameInfo.publicId, nameInfo.name}.json() );
-            }
-        } catch (const std::bad_any_cast& e) {
-            PLOG_ERROR << "Client::update - Event::ClientsDirect::nameChanged "
-                         "- expected Event::Data::NameInfo: " << e.what();
+        break;
+    case Event::ClientsDirect::nameChanged:
+        if (const auto* nameInfo = std::get_if<Event::Data::NameInfo>(&data))
+        {
+            sp->sendText( SerializableEvent::NameChanged{nameInfo->publicId, nameInfo->name}.json() );
         }
-        return;
-    }
-    else
-    {
-        PLOG_WARNING << "Client::update(Event::ClientsDirect) unknown event";
+        break;
     }
 }
 
-void Client::update(Event::TransferSession event, std::any data)
+void Client::update(Event::TransferSession event, const Subscriber<Event::TransferSession>::Payload& data)
 {
-    if (event == Event::TransferSession::newReceiver)
-    {
-        PLOG_DEBUG << "New receiver event for " << m_id;
-        try {
-            std::shared_ptr<Client> client = std::any_cast<std::shared_ptr<Client>>(data);
-            if (client == nullptr)
-            {
-                PLOG_WARNING << "Client::update - Event::TransferSession::newReceiver - data nullptr";
-                return;
-            }
-            if (auto sp = m_webSocketConnection.lock())
-            {
-                sp->sendText( SerializableEvent::NewReceiver{client->publicId(), client->name()}.json() );
-            }
-        } catch (const std::bad_any_cast& e) {
-            PLOG_ERROR << "Client::update - Event::TransferSession::newReceiver "
-                         "- expected std::shared_ptr<Client>: " << e.what();
-        }
-        return;
-    }
-    else if (event == Event::TransferSession::receiverRemoved)
-    {
-        try {
-            const std::string publicId = std::any_cast<std::string>(data);
-            if (auto sp = m_webSocketConnection.lock())
-            {
-                sp->sendText( SerializableEvent::ReceiverRemoved{publicId}.json() );
-            }
-        } catch (const std::bad_any_cast& e) {
-            PLOG_ERROR << "Client::update - Event::TransferSession::receiverRemoved "
-                         "- expected std::string: " << e.what();
-        }
-        return;
-    }
-    else if (event == Event::TransferSession::fileInfoUpdated)
-    {
-        try {
-            TransferSession::FileInfo fileInfo = std::any_cast<TransferSession::FileInfo>(data);
-            if (auto sp = m_webSocketConnection.lock())
-            {
-                sp->sendText( SerializableEvent::FileInfoUpdated{fileInfo.name, fileInfo.size}.json() );
-            }
-        } catch (const std::bad_any_cast& e) {
-            PLOG_ERROR << "Client::update - Event::TransferSession::fileInfoUpdated "
-                         "- expected FileInfo: " << e.what();
-        }
-        return;
-    }
-    else if (event == Event::TransferSession::chunkDownloadStarted)
-    {
-        try {
-            const auto info = std::any_cast<Event::Data::TransferSessionDownloadInfo>(data);
-            if (auto sp = m_webSocketConnection.lock())
-            {
-                sp->sendText( SerializableEvent::ChunkDownload{info.publicId, info.chunkId, true}.json() );
-            }
-        } catch (const std::bad_any_cast& e) {
-            PLOG_ERROR << "Client::update - Event::TransferSession::chunkDownloadStarted "
-                         "- expected TransferSessionDownloadInfo: " << e.what();
-        }
-        return;
-    }
-    else if (event == Event::TransferSession::chunkDownloadFinished)
-    {
-        try {
-            const auto info = std::any_cast<Event::Data::TransferSessionDownloadInfo>(data);
-            if (auto sp = m_webSocketConnection.lock())
-            {
-                sp->sendText( SerializableEvent::ChunkDownload{info.publicId, info.chunkId, false}.json() );
-            }
-        } catch (const std::bad_any_cast& e) {
-            PLOG_ERROR << "Client::update - Event::TransferSession::chunkDownloadFinished "
-                         "- expected TransferSessionDownloadInfo: " << e.what();
-        }
-        return;
-    }
-    else if (event == Event::TransferSession::newChunkIsAvailable)
+    if (const auto* type = std::get_if<Event::Data::TransferSessionCompleteType>(&data))
     {
-        try {
-            const auto info = std::any_cast<Event::Data::ChunkInfo>(data);
-            if (auto sp = m_webSocketConnection.lock())
-            {
-                sp->sendText( SerializableEvent::NewChunkAvailable{info.index, info.size}.json() );
-            }
-        } catch (const std::bad_any_cast& e) {
-            PLOG_ERROR << "Client::update - Event::TransferSession::newChunkIsAvailable "
-                         "- expected ChunkInfo: " << e.what();
-        }
-        return;
-    }
-    else if (event == Event::TransferSession::chunksWasRemoved)
-    {
-        try {
-            const auto list = std::any_cast<std::list<size_t>>(data);
-            if (auto sp = m_webSocketConnection.lock())
-            {
-                sp->sendText( SerializableEvent::ChunksRemoved{list}.json() );
-            }
-        } catch (const std::bad_any_cast& e) {
-            PLOG_ERROR << "Client::update - Event::TransferSession::chunksWasRemoved "
-                         "- expected std::list<size_t>: " << e.what();
-        }
-        return;
-    }
-    else if (event == Event::TransferSession::fileUploadFinished)
-    {
-        if (auto sp = m_webSocketConnection.lock())
+        if (m_receivedProgress)
         {
-            sp->sendText( SerializableEvent::UploadFinished().json() );
+            m_receivedProgress->flush();
         }
+        const std::string myInternalId = m_id;
+        sendTextWithAck(
+            SerializableEvent::SessionComplete{*type}.json(),
+            [myInternalId]() { ClientList::instanse().remove(myInternalId); }
+        );
         return;
     }
-    else if (event == Event::TransferSession::complete)
-    {
-         try {
-            const auto type = std::any_cast<Event::Data::TransferSessionCompleteType>(data);
-            const std::string myInternalId = m_id;
-            sendTextWithAck(
-                SerializableEvent::SessionComplete{type}.json(),
-                [myInternalId]() { ClientList::instanse().remove(myInternalId); }
-            );
-        } catch (const std::bad_any_cast& e) {
-            PLOG_ERROR << "Client::update - Event::TransferSession::complete "
-                         "- expected TransferSessionCompleteType: " << e.what();
-        }
-        return;
-    }
-    else if (event == Event::TransferSession::bytesInUpdated)
-    {
-        try {
-            const auto value = std::any_cast<size_t>(data);
-            if (auto sp = m_webSocketConnection.lock())
-            {
-                sp->sendText( SerializableEvent::TotalBytesCount{value, true}.json() );
-            }
-        } catch (const std::bad_any_cast& e) {
-            PLOG_ERROR << "Client::update - Event::TransferSession::bytesInUpdated "
-                         "- expected size_t: " << e.what();
-        }
-        return;
-    }
-    else if (event == Event::TransferSession::bytesOutUpdated)
-    {
-        try {
-            const auto value = std::any_cast<size_t>(data);
-            if (auto sp = m_webSocketConnection.lock())
-            {
-                sp->sendText( SerializableEvent::TotalBytesCount{value, false}.json() );
-            }
-        } catch (const std::bad_any_cast& e) {
-            PLOG_ERROR << "Client::update - Event::TransferSession::bytesOutUpdated "
-                         "- expected size_t: " << e.what();
-        }
-        return;
-    }
-    else if (event == Event::TransferSession::chunksAreUnfrozen)
+
+    // Any other event comes serialized by the session, once for all its members
+    const auto* frames = std::get_if<SerializableEvent::Frames>(&data);
+    if (frames == nullptr or frames->json == nullptr)
     {
-        if (auto sp = m_webSocketConnection.lock())
-        {
-            sp->sendText( SerializableEvent::ChunksAreUnfrozen{}.json() );
-        }
+        PLOG_WARNING << "Client::update(Event::TransferSession) - frame nullptr, event " << static_cast<int>(event);
         return;
     }
-    else
+    if (auto sp = m_webSocketConnection.lock())
     {
-        PLOG_WARNING << "Client::update(Event::TransferSession) unknown event";
+        sp->sendEvent(*frames);
     }
 }
 
-void Client::update(Event::TransferSessionForSender event, std::any data)
+void Client::update(Event::TransferSessionForSender event, const Event::Data::NewChunkAllowance& allowance)
 {
-    if (event == Event::TransferSessionForSender::newChunkIsAllowed)
+    switch (event)
     {
-        try {
-            const auto status = std::any_cast<bool>(data);
-            if (auto sp = m_webSocketConnection.lock())
-            {
-                sp->sendText( SerializableEvent::NewChunkIsAllowed{status}.json() );
-            }
-        } catch (const std::bad_any_cast& e) {
-            PLOG_ERROR << "Client::update - Event::TransferSessionForSender::newChunkIsAllowed "
-                         "- expected bool: " << e.what();
+    case Event::TransferSessionForSender::newChunkIsAllowed:
+        if (auto sp = m_webSocketConnection.lock())
+        {
+            sp->sendEvent( SerializableEvent::NewChunkIsAllowed{allowance.allowed,
+                                                               allowance.memoryBudgetExhausted} );
         }
-        return;
-    }
-    else
-    {
-        PLOG_WARNING << "Client::update(Event::TransferSessionForSender) unknown event";
+        break;
     }
 }
 
@@ -409,8 +244,7 @@ Client::~Client()
     {
         if (entry.fallback)
         {
-            asio::error_code ignore;
-            entry.fallback->cancel(ignore);
+            m_timerWheel->cancel(entry.fallback);
         }
         if (entry.callback) entry.callback();
     }
@@ -446,10 +280,14 @@ void Client::dropCurrentWsConnection()
 void Client::incrementReceived(size_t bytes)
 {
     m_bytesReceived += bytes;
+    m_receivedProgress ? m_receivedProgress->touch() : sendReceivedProgress();
+}
 
+void Client::sendReceivedProgress()
+{
     if (auto ws = m_webSocketConnection.lock())
     {
-        ws->sendText( SerializableEvent::PersonalReceivedUpdated{m_bytesReceived}.json() );
+        ws->sendEvent( SerializableEvent::PersonalReceivedUpdated{m_bytesReceived} );
     }
 }
 
@@ -12,14 +12,12 @@
 #include <asio.hpp>
 
 #include "observerpattern.h"
+#include "transfersessionevents.h"
 #include "websocketconnection.h"
 #include "timercallback.h"
+#include "progresscoalescer.h"
 
 namespace Event {
-enum class TransferSession;
-enum class TransferSessionSender;
-enum class TransferSessionForSender;
-
 enum class ClientsDirect { // direct communication between users
 //  Event            Data
     connected,    // publicId
@@ -43,6 +41,9 @@ struct NameInfo
 } // namespace Data
 } // namespace Event
 
+template<> struct EventPayload<Event::ClientsDirect> { using Type = std::variant<std::string, Event::Data::NameInfo>; };
+template<> struct EventPayload<Event::ClientInternal> { using Type = std::string; };
+
 class Client : public Publisher<Event::ClientsDirect>,
                public Publisher<Event::ClientInternal>,
                public Subscriber<Event::ClientsDirect>,
@@ -96,9 +97,9 @@ public:
     void resetWsTimeoutTimerIfItActive();
 
     // Subscriber interface
-    void update(Event::ClientsDirect event, std::any data) override;
-    void update(Event::TransferSession event, std::any data) override;
-    void update(Event::TransferSessionForSender event, std::any data) override;
+    void update(Event::ClientsDirect event, const Subscriber<Event::ClientsDirect>::Payload& data) override;
+    void update(Event::TransferSession event, const Subscriber<Event::TransferSession>::Payload& data) override;
+    void update(Event::TransferSessionForSender event, const Event::Data::NewChunkAllowance& allowance) override;
 
 protected:
     // we explicit use shared_ptr only (Subscriber)
@@ -116,15 +117,20 @@ private:
     TimerCallback m_wsTimeoutTimer;
 
     asio::io_context& m_ioContext;
+    std::shared_ptr<TimerWheel> m_timerWheel;
 
     struct PendingAck
     {
         std::function<void()> callback;
-        std::unique_ptr<asio::steady_timer> fallback;
+        std::shared_ptr<TimerWheel::Entry> fallback;
     };
     std::atomic<uint64_t> m_nextAckId {1};
     std::unordered_map<uint64_t, PendingAck> m_pendingAcks;
     std::mutex m_pendingAcksMutex;
 
+    // personal_received, rate limited like the session byte counters
+    std::unique_ptr<ProgressCoalescer> m_receivedProgress = nullptr; // none with a 0 interval
+    void sendReceivedProgress();
+
     void resolveAck(uint64_t id);
 };
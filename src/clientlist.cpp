@@ -4,20 +4,27 @@
 
 #include "clientlist.h"
 #include "client.h"
+#include "executor.h"
 #include "observerpattern.h"
 #include "captcha/skaptcha_tools.h"
 #include "log.h"
 
-#include <mutex>
 #include <chrono>
-#include <random>
+#include <vector>
 
 ClientList::~ClientList()
 {
-    m_ioContext.stop();
-    if (m_ioContextThreadPtr && m_ioContextThreadPtr->joinable())
+    Executor::instance().stop();
+
+    /*
+     * A client destroyed with pending ACKs runs their callbacks, which remove
+     * clients from this list, so the map is emptied while it is still whole.
+     */
+    std::vector<std::string> ids;
+    m_map.forEach([&](const std::string& id, const std::shared_ptr<Client>&) { ids.push_back(id); });
+    for (const auto& id : ids)
     {
-        m_ioContextThreadPtr->join();
+        remove(id);
     }
 }
 
@@ -27,59 +34,33 @@ ClientList &ClientList::instanse()
     return list;
 }
 
-std::string ClientList::generateIdCondidate(const std::string &seed)
+std::string ClientList::generateIdCondidate()
 {
-    const auto timestamp = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-    const std::string combinedSeed = seed + std::to_string(timestamp);
-
-    const size_t seedHash = std::hash<std::string>()(combinedSeed);
-
-    std::mt19937_64 generator(seedHash);
-    std::uniform_int_distribution<uint8_t> distribution(0, 255);
-
-    std::string binary;
-    binary.resize(ID_LENGTH_BYTES);
-
-    for (uint8_t i = 0; i < ID_LENGTH_BYTES; ++i)
-    {
-        binary[i] = distribution(generator);
-    }
-
+    const std::string binary = skaptcha_tools::string::simpleRandom(ID_LENGTH_BYTES);
     return skaptcha_tools::base64::encodeUrlsafe(binary);
 }
 
 std::shared_ptr<Client> ClientList::create(const std::string &token)
 {
-    std::unique_lock lock (m_mutex);
-
-    if (m_map.contains(token))
-    {
-        return nullptr;
-    }
-
-    auto client = createSubscriber<Client>(token, m_ioContext, [&, token](){ PLOG_DEBUG << "Client timeout: " << token; this->remove(token); });
+    std::shared_ptr<Client> client = nullptr;
 
-    m_map[token] = client;
+    m_map.tryEmplace(token, [&]() {
+        client = createSubscriber<Client>(token, m_ioContext, [&, token](){ PLOG_DEBUG << "Client timeout: " << token; this->remove(token); });
+        return client;
+    });
 
     return client;
 }
 
 std::shared_ptr<Client> ClientList::get(const std::string &token) const
 {
-    std::shared_lock lock (m_mutex);
-
-    const auto iter = m_map.find(token);
-    if (iter == m_map.end())
-    {
-        return nullptr;
-    }
-
-    return iter->second;
+    std::shared_ptr<Client> client = nullptr;
+    m_map.visit(token, [&](const std::shared_ptr<Client>& found) { client = found; });
+    return client;
 }
 
 size_t ClientList::count() const
 {
-    std::shared_lock lock (m_mutex);
     return m_map.size();
 }
 
@@ -90,22 +71,10 @@ void ClientList::remove(const std::string &id)
      */
 
     std::shared_ptr<Client> client = nullptr;
-    {
-        std::unique_lock lock (m_mutex);
-        auto iter = m_map.find(id);
-        if (iter == m_map.end())
-        {
-            return;
-        }
-        client = iter->second;
-        m_map.erase(iter);
-    }
+    m_map.erase(id, [&](std::shared_ptr<Client>& found) { client = std::move(found); });
 }
 
 ClientList::ClientList()
+    : m_ioContext(Executor::instance().ioContext())
 {
-    m_ioContextThreadPtr = std::make_unique<std::thread>([&]() {
-        asio::executor_work_guard<asio::io_context::executor_type> work = asio::make_work_guard(m_ioContext);
-        m_ioContext.run();
-    });
 }
@@ -4,11 +4,10 @@
 
 #pragma once
 
+#include "shardedmap.h"
+
 #include <string>
-#include <shared_mutex>
-#include <unordered_map>
 #include <memory>
-#include <thread>
 #include <asio.hpp>
 
 class Client;
@@ -21,7 +20,7 @@ public:
     ~ClientList();
 
     static ClientList& instanse();
-    static std::string generateIdCondidate(const std::string& ipAddressAsASeed);
+    static std::string generateIdCondidate();
 
     std::shared_ptr<Client> create(const std::string& id);
     std::shared_ptr<Client> get(const std::string& id) const;
@@ -34,9 +33,9 @@ private:
     ClientList(ClientList&&) = delete;
     ClientList& operator=(const ClientList&) = delete;
 
-    std::unique_ptr<std::thread> m_ioContextThreadPtr;
-    asio::io_context m_ioContext;
+    // Executor::instance(), the client timeouts run there
+    asio::io_context& m_ioContext;
 
-    mutable std::shared_mutex m_mutex;
-    std::unordered_map<std::string, std::shared_ptr<Client>> m_map;
+    // Every request looks its client up, the writers only lock one shard
+    ShardedMap<std::string, std::shared_ptr<Client>> m_map;
 };
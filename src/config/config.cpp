@@ -32,11 +32,17 @@ bool Config::loadFromFile(const std::string &path)
     m_logLevel = reader.GetString("server", "log_level", "info");
     m_address  = reader.GetString("server", "bind_address", "0.0.0.0");
     m_port     = static_cast<uint16_t>(reader.GetUnsigned("server", "bind_port", 2233));
+    m_workerThreads   = reader.GetUnsigned("server", "worker_threads", 0);
+    m_executorThreads = reader.GetUnsigned("server", "executor_threads", 1);
+    m_cpuAffinity     = reader.GetString("server", "cpu_affinity", "");
+    m_pinThreads      = reader.GetBoolean("server", "pin_threads", false);
+    m_sessionStrand   = reader.GetBoolean("server", "session_strand", false);
 
     // [client]
     m_apiMaxClientCount          = reader.GetUnsigned("client", "max_count", 500);
     m_apiWithoutCaptchaThreshold = reader.GetUnsigned("client", "without_captcha_threshold", 500);
     m_apiCaptchaLifetime         = reader.GetUnsigned("client", "captcha_lifetime", 180);
+    m_apiCaptchaPoolSize         = reader.GetUnsigned("client", "captcha_pool_size", 32);
     m_clientTimeout              = reader.GetUnsigned("client", "timeout", 60);
 
     // [session]
@@ -46,6 +52,10 @@ bool Config::loadFromFile(const std::string &path)
     m_transferSessionMaxLifetime             = reader.GetUnsigned("session", "max_lifetime", 7200);
     m_transferSessionMaxConsumerCount        = reader.GetUnsigned("session", "max_consumer_count", 5);
     m_transferSessionMaxInitialFreezeDuration = reader.GetUnsigned("session", "max_initial_freeze_duration", 120);
+    m_transferSessionChunkPoolSize           = reader.GetUnsigned("session", "chunk_pool_size", 10);
+    m_transferSessionMemoryBudget            = reader.GetUnsigned64("session", "memory_budget", 0);
+    m_transferSessionChunkQueueMaxBytes      = reader.GetUnsigned64("session", "chunk_queue_max_bytes", 0);
+    m_transferSessionProgressInterval        = reader.GetUnsigned("session", "progress_interval_ms", 250);
 
     return true;
 }
@@ -19,9 +19,15 @@ public:
     void setLogLevel(const std::string& level)              { m_logLevel = level; }
     void setBindAddress(const std::string& address)        { m_address = address; }
     void setBindPort(uint16_t port)                        { m_port = port; }
+    void setWorkerThreads(size_t value)                    { m_workerThreads = value; }
+    void setExecutorThreads(size_t value)                  { m_executorThreads = value; }
+    void setCpuAffinity(const std::string& cpus)           { m_cpuAffinity = cpus; }
+    void setPinThreads(bool value)                         { m_pinThreads = value; }
+    void setSessionStrand(bool value)                      { m_sessionStrand = value; }
     void setApiMaxClientCount(size_t value)                { m_apiMaxClientCount = value; }
     void setApiWithoutCaptchaThreshold(size_t value)       { m_apiWithoutCaptchaThreshold = value; }
     void setApiCaptchaLifetime(size_t value)               { m_apiCaptchaLifetime = value; }
+    void setApiCaptchaPoolSize(size_t value)               { m_apiCaptchaPoolSize = value; }
     void setClientTimeout(size_t value)                    { m_clientTimeout = value; }
     void setTransferSessionCountLimit(size_t value)        { m_transferSessionCountLimit = value; }
     void setTransferSessionMaxChunkSize(size_t value)      { m_transferSessionMaxChunkSize = value; }
@@ -29,20 +35,34 @@ public:
     void setTransferSessionMaxLifetime(size_t value)       { m_transferSessionMaxLifetime = value; }
     void setTransferSessionMaxConsumerCount(size_t value)  { m_transferSessionMaxConsumerCount = value; }
     void setTransferSessionMaxInitialFreezeDuration(size_t value) { m_transferSessionMaxInitialFreezeDuration = value; }
+    void setTransferSessionChunkPoolSize(size_t value)     { m_transferSessionChunkPoolSize = value; }
+    void setTransferSessionMemoryBudget(size_t value)      { m_transferSessionMemoryBudget = value; }
+    void setTransferSessionChunkQueueMaxBytes(size_t value) { m_transferSessionChunkQueueMaxBytes = value; }
+    void setTransferSessionProgressInterval(size_t ms)     { m_transferSessionProgressInterval = ms; }
 
     std::string logLevel() const                     { return m_logLevel; }
     std::string bindAddress() const                 { return m_address; }
     uint16_t bindPort() const                       { return m_port; }
+    size_t workerThreads() const                    { return m_workerThreads; }
+    size_t executorThreads() const                  { return m_executorThreads; }
+    std::string cpuAffinity() const                 { return m_cpuAffinity; }
+    bool pinThreads() const                         { return m_pinThreads; }
+    bool sessionStrand() const                      { return m_sessionStrand; }
     size_t clientTimeout() const                    { return m_clientTimeout; }
     size_t apiMaxClientCount() const                { return m_apiMaxClientCount; }
     size_t apiWithoutCaptchaThreshold() const       { return m_apiWithoutCaptchaThreshold; }
     size_t apiCaptchaLifetime() const               { return m_apiCaptchaLifetime; }
+    size_t apiCaptchaPoolSize() const               { return m_apiCaptchaPoolSize; }
     size_t transferSessionCountLimit() const        { return m_transferSessionCountLimit; }
     size_t transferSessionMaxChunkSize() const      { return m_transferSessionMaxChunkSize; }
     size_t transferSessionMaxLifetime() const       { return m_transferSessionMaxLifetime; }
     size_t transferSessionChunkQueueMaxSize() const { return m_transferSessionChunkQueueMaxSize; }
     size_t transferSessionMaxConsumerCount() const  { return m_transferSessionMaxConsumerCount; }
     size_t transferSessionMaxInitialFreezeDuration() const { return m_transferSessionMaxInitialFreezeDuration; }
+    size_t transferSessionChunkPoolSize() const     { return m_transferSessionChunkPoolSize; }
+    size_t transferSessionMemoryBudget() const      { return m_transferSessionMemoryBudget; }
+    size_t transferSessionChunkQueueMaxBytes() const { return m_transferSessionChunkQueueMaxBytes; }
+    size_t transferSessionProgressInterval() const  { return m_transferSessionProgressInterval; } // ms
 
 private:
     Config() = default;
@@ -53,9 +73,15 @@ private:
     std::string m_logLevel = "info";
     std::string m_address;
     uint16_t m_port = 0;
+    size_t m_workerThreads = 0;
+    size_t m_executorThreads = 0;
+    std::string m_cpuAffinity;
+    bool m_pinThreads = false;
+    bool m_sessionStrand = false;
     size_t m_apiMaxClientCount = 0;
     size_t m_apiWithoutCaptchaThreshold = 0;
     size_t m_apiCaptchaLifetime = 0;
+    size_t m_apiCaptchaPoolSize = 0;
     size_t m_clientTimeout = 0;
     size_t m_transferSessionCountLimit = 0;
     size_t m_transferSessionMaxChunkSize = 0;
@@ -63,4 +89,8 @@ private:
     size_t m_transferSessionChunkQueueMaxSize = 0;
     size_t m_transferSessionMaxConsumerCount = 0;
     size_t m_transferSessionMaxLifetime = 0;
+    size_t m_transferSessionChunkPoolSize = 0;
+    size_t m_transferSessionMemoryBudget = 0;
+    size_t m_transferSessionChunkQueueMaxBytes = 0;
+    size_t m_transferSessionProgressInterval = 0;
 };
@@ -359,7 +359,7 @@ namespace crow
 
             if (!res.manual_length_header && !res.headers.count("content-length"))
             {
-                content_length_ = std::to_string(res.body.size());
+                content_length_ = std::to_string(res.body_size());
                 static std::string content_length_tag = "Content-Length: ";
                 buffers_.emplace_back(content_length_tag.data(), content_length_tag.size());
                 buffers_.emplace_back(content_length_.data(), content_length_.size());
@@ -422,7 +422,22 @@ namespace crow
 
         void do_write_general()
         {
-            if (res.body.length() < res_stream_threshold_)
+            if (res.shared_body)
+            {
+                // Headers and the shared payload go out in one gather write, the payload is not copied
+                res_body_shared_ = std::move(res.shared_body);
+                buffers_.emplace_back(res_body_shared_->data(), res_body_shared_->size());
+
+                do_write_sync(buffers_);
+
+                if (need_to_start_read_after_complete_)
+                {
+                    need_to_start_read_after_complete_ = false;
+                    start_deadline();
+                    do_read();
+                }
+            }
+            else if (res.body.length() < res_stream_threshold_)
             {
                 res_body_copy_.swap(res.body);
                 buffers_.emplace_back(res_body_copy_.data(), res_body_copy_.size());
@@ -550,6 +565,7 @@ namespace crow
 
             this->res.clear();
             this->res_body_copy_.clear();
+            this->res_body_shared_.reset();
             if (this->continue_requested)
             {
                 this->continue_requested = false;
@@ -607,6 +623,7 @@ namespace crow
         std::string content_length_;
         std::string date_str_;
         std::string res_body_copy_;
+        std::shared_ptr<const std::string> res_body_shared_;
 
         detail::task_timer::identifier_type task_id_{};
 
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <memory>
 #include <unordered_map>
 #include <ios>
 #include <fstream>
@@ -39,6 +40,7 @@ namespace crow
 
         int code{200};    ///< The Status code for the response.
         std::string body; ///< The actual payload containing the response data.
+        std::shared_ptr<const std::string> shared_body; ///< Immutable payload written without copying, takes precedence over `body`.
         ci_map headers;   ///< HTTP headers.
 
 #ifdef CROW_ENABLE_COMPRESSION
@@ -166,6 +168,7 @@ namespace crow
         response& operator=(response&& r) noexcept
         {
             body = std::move(r.body);
+            shared_body = std::move(r.shared_body);
             code = r.code;
             headers = std::move(r.headers);
             completed_ = r.completed_;
@@ -182,6 +185,7 @@ namespace crow
         void clear()
         {
             body.clear();
+            shared_body.reset();
             code = 200;
             headers.clear();
             completed_ = false;
@@ -241,13 +245,17 @@ namespace crow
                 completed_ = true;
                 if (skip_body)
                 {
-                    set_header("Content-Length", std::to_string(body.size()));
+                    set_header("Content-Length", std::to_string(body_size()));
                     body = "";
+                    shared_body.reset();
                     manual_length_header = true;
                 }
                 if (complete_request_handler_)
                 {
-                    complete_request_handler_();
+                    // The connection clears the handler while it runs, and for a response
+                    // ended asynchronously the handler holds the last reference to the connection
+                    auto handler = complete_request_handler_;
+                    handler();
                     manual_length_header = false;
                     skip_body = false;
                 }
@@ -261,6 +269,12 @@ namespace crow
             end();
         }
 
+        /// Size of the payload that will be sent, whichever of `body` and `shared_body` holds it.
+        std::size_t body_size() const noexcept
+        {
+            return shared_body ? shared_body->size() : body.size();
+        }
+
         /// Check if the connection is still alive (usually by checking the socket status).
         bool is_alive()
         {
@@ -62,6 +62,9 @@ namespace crow // NOTE: Already documented in "crow/app.h"
         {
             virtual void send_binary(std::string msg) = 0;
             virtual void send_text(std::string msg) = 0;
+            virtual void send_binary(std::shared_ptr<const std::string> msg) = 0;
+            virtual void send_text(std::shared_ptr<const std::string> msg) = 0;
+            virtual void send_binary(std::string prefix, std::shared_ptr<const std::string> msg) = 0;
             virtual void send_ping(std::string msg) = 0;
             virtual void send_pong(std::string msg) = 0;
             virtual void close(std::string const& msg = "quit", uint16_t status_code = CloseStatusCode::NormalClosure) = 0;
@@ -113,7 +116,7 @@ namespace crow // NOTE: Already documented in "crow/app.h"
             Connection(const crow::request& req, Adaptor&& adaptor, Handler* handler,
                        uint64_t max_payload, const std::vector<std::string>& subprotocols,
                        std::function<void(crow::websocket::connection&)> open_handler,
-                       std::function<void(crow::websocket::connection&, const std::string&, bool)> message_handler,
+                       std::function<void(crow::websocket::connection&, std::string&, bool)> message_handler,
                        std::function<void(crow::websocket::connection&, const std::string&, uint16_t)> close_handler,
                        std::function<void(crow::websocket::connection&, const std::string&)> error_handler,
                        std::function<bool(const crow::request&, void**)> accept_handler,
@@ -252,6 +255,27 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                 send_data(0x1, std::move(msg));
             }
 
+            /// Send a binary encoded message without copying it.
+
+            ///
+            /// The payload is written straight from the shared buffer, which is kept alive until the write completes.
+            void send_binary(std::shared_ptr<const std::string> msg) override
+            {
+                send_data(0x2, std::move(msg));
+            }
+
+            /// Send a plaintext message without copying it.
+            void send_text(std::shared_ptr<const std::string> msg) override
+            {
+                send_data(0x1, std::move(msg));
+            }
+
+            /// Send a binary message made of a small prefix and a shared buffer, the buffer is not copied.
+            void send_binary(std::string prefix, std::shared_ptr<const std::string> msg) override
+            {
+                send_data(0x2, std::move(msg), std::move(prefix));
+            }
+
             /// Send a close signal.
 
             ///
@@ -294,6 +318,30 @@ namespace crow // NOTE: Already documented in "crow/app.h"
             }
 
         protected:
+            /// A queued write: either an owned string or a shared immutable payload.
+            struct write_buffer
+            {
+                write_buffer(std::string data):
+                  owned(std::move(data))
+                {}
+                write_buffer(std::shared_ptr<const std::string> data):
+                  shared(std::move(data))
+                {}
+
+                std::size_t size() const
+                {
+                    return shared ? shared->size() : owned.size();
+                }
+
+                asio::const_buffer buffer() const
+                {
+                    return shared ? asio::buffer(*shared) : asio::buffer(owned);
+                }
+
+                std::string owned;
+                std::shared_ptr<const std::string> shared;
+            };
+
             /// Generate the websocket headers using an opcode and the message size (in bytes).
             std::string build_header(int opcode, size_t size)
             {
@@ -557,6 +605,9 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                         break;
                     case WebSocketReadState::Payload:
                     {
+                        // The payload length is known here, so the fragment is sized once
+                        if (fragment_.empty())
+                            fragment_.reserve(static_cast<std::size_t>(remaining_length_));
                         auto to_read = static_cast<std::uint64_t>(buffer_.size());
                         if (remaining_length_ < to_read)
                             to_read = remaining_length_;
@@ -595,6 +646,15 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                 }
             }
 
+            /// Move the fragment payload into the message; a single-frame message is taken over without copying.
+            void append_fragment()
+            {
+                if (message_.empty())
+                    message_.swap(fragment_);
+                else
+                    message_ += fragment_;
+            }
+
             /// Check if the FIN bit is set.
             bool is_FIN()
             {
@@ -624,7 +684,7 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                 {
                     case 0: // Continuation
                     {
-                        message_ += fragment_;
+                        append_fragment();
                         if (is_FIN())
                         {
                             if (message_handler_)
@@ -636,7 +696,7 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                     case 1: // Text
                     {
                         is_binary_ = false;
-                        message_ += fragment_;
+                        append_fragment();
                         if (is_FIN())
                         {
                             if (message_handler_)
@@ -648,7 +708,7 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                     case 2: // Binary
                     {
                         is_binary_ = true;
-                        message_ += fragment_;
+                        append_fragment();
                         if (is_FIN())
                         {
                             if (message_handler_)
@@ -724,7 +784,7 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                     buffers.reserve(sending_buffers_.size());
                     for (auto& s : sending_buffers_)
                     {
-                        buffers.emplace_back(asio::buffer(s));
+                        buffers.emplace_back(s.buffer());
                     }
                     auto watch = std::weak_ptr<void>{anchor_};
                     asio::async_write(
@@ -767,9 +827,10 @@ namespace crow // NOTE: Already documented in "crow/app.h"
 
             struct SendMessageType
             {
-                std::string payload;
+                write_buffer payload;
                 Connection* self;
                 int opcode;
+                std::string prefix; // written before the payload, in the same frame
 
                 void operator()()
                 {
@@ -779,18 +840,20 @@ namespace crow // NOTE: Already documented in "crow/app.h"
 
             void send_data_impl(SendMessageType* s)
             {
-                auto header = build_header(s->opcode, s->payload.size());
+                auto header = build_header(s->opcode, s->prefix.size() + s->payload.size());
+                header += s->prefix;
                 write_buffers_.emplace_back(std::move(header));
                 write_buffers_.emplace_back(std::move(s->payload));
                 do_write();
             }
 
-            void send_data(int opcode, std::string&& msg)
+            void send_data(int opcode, write_buffer&& msg, std::string prefix = {})
             {
                 SendMessageType event_arg{
                   std::move(msg),
                   this,
-                  opcode};
+                  opcode,
+                  std::move(prefix)};
 
                 post(std::move(event_arg));
             }
@@ -799,8 +862,8 @@ namespace crow // NOTE: Already documented in "crow/app.h"
             Adaptor adaptor_;
             Handler* handler_;
 
-            std::vector<std::string> sending_buffers_;
-            std::vector<std::string> write_buffers_;
+            std::vector<write_buffer> sending_buffers_;
+            std::vector<write_buffer> write_buffers_;
 
             std::array<char, 4096> buffer_;
             bool is_binary_;
@@ -825,7 +888,7 @@ namespace crow // NOTE: Already documented in "crow/app.h"
             std::shared_ptr<void> anchor_ = std::make_shared<int>(); // Value is just for placeholding
 
             std::function<void(crow::websocket::connection&)> open_handler_;
-            std::function<void(crow::websocket::connection&, const std::string&, bool)> message_handler_;
+            std::function<void(crow::websocket::connection&, std::string&, bool)> message_handler_;
             std::function<void(crow::websocket::connection&, const std::string&, uint16_t status_code)> close_handler_;
             std::function<void(crow::websocket::connection&, const std::string&)> error_handler_;
             std::function<bool(const crow::request&, void**)> accept_handler_;
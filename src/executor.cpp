@@ -0,0 +1,222 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#include "executor.h"
+#include "config/config.h"
+#include "log.h"
+
+#include <cstdlib>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+#ifdef __linux__
+bool fillCpuSet(const std::vector<unsigned>& cpus, cpu_set_t& set)
+{
+    CPU_ZERO(&set);
+    for (unsigned cpu : cpus)
+    {
+        if (cpu >= CPU_SETSIZE)
+        {
+            return false;
+        }
+        CPU_SET(cpu, &set);
+    }
+    return true;
+}
+#endif
+
+void pinCurrentThread(unsigned cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    fillCpuSet({cpu}, set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+    {
+        PLOG_WARNING << "Executor: a thread can not be pinned to CPU " << cpu;
+    }
+#else
+    (void)cpu;
+#endif
+}
+
+} // namespace
+
+Executor::~Executor()
+{
+    stop();
+}
+
+Executor &Executor::instance()
+{
+    static Executor executor;
+    return executor;
+}
+
+asio::io_context &Executor::ioContext()
+{
+    start();
+    return m_ioContext;
+}
+
+void Executor::start()
+{
+    std::lock_guard lock (m_mutex);
+    if (m_started)
+    {
+        return;
+    }
+    m_started = true;
+
+    const auto& cfg = Config::instance();
+    const size_t count = std::max<size_t>(1, cfg.executorThreads());
+
+    std::vector<unsigned> pinTo;
+    if (cfg.pinThreads())
+    {
+        if (cfg.cpuAffinity().empty())
+        {
+            // No list: round-robin over the CPUs the process may run on
+            pinTo = allowedCpus();
+            if (pinTo.empty())
+            {
+                PLOG_WARNING << "Executor: the CPU affinity mask can not be read, the threads are not pinned";
+            }
+        }
+        else if (not parseCpuList(cfg.cpuAffinity(), pinTo))
+        {
+            PLOG_WARNING << "Executor: cpu_affinity is not a CPU list, the threads are not pinned";
+            pinTo.clear();
+        }
+    }
+
+    m_workGuard = std::make_unique<asio::executor_work_guard<asio::io_context::executor_type>>(m_ioContext.get_executor());
+    for (size_t i = 0; i < count; ++i)
+    {
+        m_threads.emplace_back([this, i, pinTo]() {
+            if (not pinTo.empty())
+            {
+                pinCurrentThread(pinTo[i % pinTo.size()]);
+            }
+#ifdef __linux__
+            pthread_setname_np(pthread_self(), ("pip-exec-" + std::to_string(i)).c_str());
+#endif
+            m_ioContext.run();
+        });
+    }
+}
+
+void Executor::stop()
+{
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard lock (m_mutex);
+        m_workGuard.reset();
+        m_ioContext.stop();
+        threads.swap(m_threads);
+    }
+
+    for (auto& thread : threads)
+    {
+        if (thread.get_id() == std::this_thread::get_id())
+        {
+            thread.detach(); // stopped from its own callback, it returns right after
+        }
+        else if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+}
+
+size_t Executor::threadCount() const
+{
+    std::lock_guard lock (m_mutex);
+    return m_threads.size();
+}
+
+bool Executor::parseCpuList(const std::string &text, std::vector<unsigned> &cpus)
+{
+    cpus.clear();
+    size_t pos = 0;
+    while (pos <= text.size())
+    {
+        // an empty item (",", "1,") is malformed as well
+        const size_t end = std::min(text.find(',', pos), text.size());
+        const std::string item = text.substr(pos, end - pos);
+        pos = end + 1;
+
+        char* rest = nullptr;
+        const unsigned long first = std::strtoul(item.c_str(), &rest, 10);
+        unsigned long last = first;
+        if (rest == item.c_str())
+        {
+            return false;
+        }
+        if (*rest == '-')
+        {
+            const char* lastText = rest + 1;
+            last = std::strtoul(lastText, &rest, 10);
+            if (rest == lastText or last < first)
+            {
+                return false;
+            }
+        }
+        if (*rest != '\0' or last >= 1024)
+        {
+            return false;
+        }
+        for (unsigned long cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(static_cast<unsigned>(cpu));
+        }
+    }
+    return not cpus.empty();
+}
+
+bool Executor::restrictProcessTo(const std::vector<unsigned> &cpus)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    return fillCpuSet(cpus, set) and sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+size_t Executor::availableCpuCount()
+{
+#ifdef __linux__
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        return std::max(1, CPU_COUNT(&set));
+    }
+#endif
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+std::vector<unsigned> Executor::allowedCpus()
+{
+    std::vector<unsigned> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &set))
+            {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    return cpus;
+}
@@ -0,0 +1,60 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <asio.hpp>
+
+/*
+ * The io_context shared by the background work of all subsystems: the
+ * timers of the clients and sessions (one TimerWheel for all of them) and
+ * the work the registries post. [server] executor_threads threads run it;
+ * with pin_threads they are bound one per CPU of cpu_affinity, round-robin,
+ * or of the CPUs the process may run on when cpu_affinity is empty.
+ * Crow keeps its own pool, sized by worker_threads; pin_threads does not
+ * apply to it, cpu_affinity restricts it as the rest of the process.
+ */
+class Executor
+{
+public:
+    ~Executor();
+
+    static Executor& instance();
+
+    // Starts the threads on first use
+    asio::io_context& ioContext();
+    // Reads the config, called once the config is loaded; later calls do nothing
+    void start();
+    // Joins the threads, the pending work is dropped. The registries call it
+    // on exit, so no timer runs into one of them while it is being destroyed.
+    void stop();
+
+    size_t threadCount() const;
+
+    // "0-3,8" -> {0, 1, 2, 3, 8}; false on a malformed list
+    static bool parseCpuList(const std::string& text, std::vector<unsigned>& cpus);
+    // Restricts the calling thread and every thread started after it to the CPUs
+    static bool restrictProcessTo(const std::vector<unsigned>& cpus);
+    // CPUs the process may run on (the affinity mask, not the whole machine)
+    static size_t availableCpuCount();
+    // The same CPUs by number, empty if the mask can not be read
+    static std::vector<unsigned> allowedCpus();
+
+private:
+    Executor() = default;
+    Executor(const Executor&) = delete;
+    Executor(Executor&&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    asio::io_context m_ioContext;
+    std::unique_ptr<asio::executor_work_guard<asio::io_context::executor_type>> m_workGuard;
+    std::vector<std::thread> m_threads;
+    mutable std::mutex m_mutex;
+    bool m_started = false;
+};
@@ -0,0 +1,137 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*
+ * Appends compact JSON straight to a string, without building a tree.
+ * Strings are escaped and numbers written the way crow::json::wvalue dumps
+ * them, so the output is the same, the object keys being in the order
+ * they are written. The keys are literals, their length is known at
+ * compile time. The caller writes a well-formed sequence, nothing is checked.
+ */
+class JsonWriter
+{
+public:
+    explicit JsonWriter(std::string& out) : m_out(out) {}
+
+    JsonWriter& beginObject() { open('{'); return *this; }
+    JsonWriter& endObject()   { close('}'); return *this; }
+    JsonWriter& beginArray()  { open('['); return *this; }
+    JsonWriter& endArray()    { close(']'); return *this; }
+
+    template<size_t N>
+    JsonWriter& key(const char (&name)[N])
+    {
+        separate();
+        m_out.push_back('"');
+        m_out.append(name, N - 1);
+        m_out.append("\":", 2);
+        m_afterKey = true;
+        return *this;
+    }
+
+    JsonWriter& string(std::string_view text)
+    {
+        separate();
+        m_out.push_back('"');
+        escape(text);
+        m_out.push_back('"');
+        return *this;
+    }
+
+    JsonWriter& number(uint64_t value)
+    {
+        separate();
+        char digits[20];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        m_out.append(digits, result.ptr - digits);
+        return *this;
+    }
+
+    JsonWriter& boolean(bool value)
+    {
+        separate();
+        value ? m_out.append("true", 4) : m_out.append("false", 5);
+        return *this;
+    }
+
+    JsonWriter& null()
+    {
+        separate();
+        m_out.append("null", 4);
+        return *this;
+    }
+
+private:
+    std::string& m_out;
+    bool m_first = true;     // nothing written yet in the current object/array
+    bool m_afterKey = false; // the value of a key comes next, no comma
+
+    void separate()
+    {
+        if (m_afterKey)
+        {
+            m_afterKey = false;
+        }
+        else if (not m_first)
+        {
+            m_out.push_back(',');
+        }
+        m_first = false;
+    }
+
+    void open(char bracket)
+    {
+        separate();
+        m_out.push_back(bracket);
+        m_first = true;
+    }
+
+    void close(char bracket)
+    {
+        m_out.push_back(bracket);
+        m_first = false;
+    }
+
+    // As crow::json::escape, the runs that need nothing are copied at once
+    void escape(std::string_view text)
+    {
+        static constexpr char HEX[] = "0123456789abcdef";
+
+        size_t runStart = 0;
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            const unsigned char c = static_cast<unsigned char>(text[i]);
+            if (c >= 0x20 and c != '"' and c != '\\')
+            {
+                continue;
+            }
+
+            m_out.append(text.data() + runStart, i - runStart);
+            runStart = i + 1;
+            switch (c)
+            {
+            case '"':  m_out.append("\\\"", 2); break;
+            case '\\': m_out.append("\\\\", 2); break;
+            case '\n': m_out.append("\\n", 2); break;
+            case '\b': m_out.append("\\b", 2); break;
+            case '\f': m_out.append("\\f", 2); break;
+            case '\r': m_out.append("\\r", 2); break;
+            case '\t': m_out.append("\\t", 2); break;
+            default:
+                m_out.append("\\u00", 4);
+                m_out.push_back(HEX[c >> 4]);
+                m_out.push_back(HEX[c & 0xf]);
+                break;
+            }
+        }
+        m_out.append(text.data() + runStart, text.size() - runStart);
+    }
+};
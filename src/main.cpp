@@ -4,7 +4,11 @@
 
 #include "config/config.h"
 #include "webapi.h"
+#include "executor.h"
+#include "chunk.h"
 #include "log.h"
+#include "captcha/sha256_backend/sha256.h"
+#include "captcha/chacha20_backend/chacha20_simd.h"
 
 #include <iostream>
 #include <fstream>
@@ -13,6 +17,7 @@
 #include <algorithm>
 #include <csignal>
 #include <iomanip>
+#include <vector>
 
 #ifdef __linux__
   #include <sys/sysinfo.h>
@@ -56,6 +61,19 @@ static constexpr const char* DEFAULT_CONFIG_CONTENT = R"([server]
 log_level = info
 bind_address = 0.0.0.0
 bind_port = 2233
+; HTTP/WebSocket threads, 0 = one per CPU the process may run on
+worker_threads = 0
+; Threads for timers and background work of the clients and sessions
+executor_threads = 1
+; CPUs for the whole process, for example 0-3,8 (empty = no restriction)
+cpu_affinity =
+; Bind each executor thread to one CPU of cpu_affinity (or of the CPUs the
+; process may run on if it is empty); the HTTP/WebSocket threads are not pinned
+pin_threads = false
+; Run all the work of each session one at a time on the executor, instead of
+; on whichever HTTP/WebSocket thread received it; the session state is then
+; confined to the session and is not locked
+session_strand = false
 
 [client]
 ; Maximum number of simultaneous clients
@@ -64,6 +82,8 @@ max_count = 500
 without_captcha_threshold = 500
 ; Captcha expiration time in seconds
 captcha_lifetime = 180
+; Number of captcha images rendered in advance by a background thread (0 = disabled)
+captcha_pool_size = 32
 ; Client timeout in seconds (disconnected without websocket)
 timeout = 60
 
@@ -74,12 +94,23 @@ count_limit = 100
 max_chunk_size = 5242880
 ; Maximum number of chunks in the buffer queue
 chunk_queue_max_size = 10
+; Per-session buffer window in bytes (0 = disabled). If set, it replaces
+; chunk_queue_max_size: the sender may upload while less than this is buffered
+chunk_queue_max_bytes = 0
 ; Session lifetime in seconds (default: 2 hours)
 max_lifetime = 7200
 ; Maximum number of receivers per session
 max_consumer_count = 5
 ; Initial freeze duration in seconds (time to wait for receivers)
 max_initial_freeze_duration = 120
+; Number of idle max_chunk_size buffers kept for reuse by new chunks
+chunk_pool_size = 10
+; Server-wide memory budget for chunk data in bytes (0 = half of physical RAM).
+; Senders are paused with new_chunk_allowed when it is exhausted
+memory_budget = 0
+; Byte counter events (bytes_count, personal_received) are sent at most once
+; per this many milliseconds, with the latest values (0 = on every change)
+progress_interval_ms = 250
 )";
 
 static void printHelp(const char* programName)
@@ -189,20 +220,78 @@ int main(int argc, char* argv[])
     PLOG_INFO << "Config loaded from " << configPath;
     PLOG_INFO << "Log level: " << cfg.logLevel();
     PLOG_INFO << "Listening on " << cfg.bindAddress() << ":" << cfg.bindPort();
+    PLOG_INFO << "Crypto code: SHA-256 " << tools::SHA256::implementationName(tools::SHA256::bestImplementation())
+              << ", ChaCha20 vector " << chacha20_simd_name();
 
+    // Before any thread is started, they all inherit the mask
+    if (not cfg.cpuAffinity().empty())
     {
-        const size_t maxMem = cfg.transferSessionCountLimit()
-                            * cfg.transferSessionMaxChunkSize()
-                            * cfg.transferSessionChunkQueueMaxSize();
+        std::vector<unsigned> cpus;
+        if (not Executor::parseCpuList(cfg.cpuAffinity(), cpus))
+        {
+            PLOG_ERROR << "cpu_affinity is not a CPU list (like 0-3,8): " << cfg.cpuAffinity();
+            return 1;
+        }
+        if (not Executor::restrictProcessTo(cpus))
+        {
+            PLOG_WARNING << "The process can not be restricted to CPUs " << cfg.cpuAffinity();
+        }
+    }
+    if (cfg.workerThreads() == 0)
+    {
+        cfg.setWorkerThreads(Executor::availableCpuCount());
+    }
+    Executor::instance().start();
+    PLOG_INFO << "Threads: " << cfg.workerThreads() << " HTTP/WebSocket, "
+              << Executor::instance().threadCount() << " executor"
+              << (cfg.pinThreads() ? " (pinned)" : "")
+              << ", " << Executor::availableCpuCount() << " CPUs available";
+
+    if (cfg.transferSessionMaxConsumerCount() > TransferSessionDetails::Chunk::MAX_CONSUMERS)
+    {
+        PLOG_WARNING << "max_consumer_count is " << cfg.transferSessionMaxConsumerCount()
+                     << ", but a session accepts at most " << TransferSessionDetails::Chunk::MAX_CONSUMERS << " receivers";
+    }
+
+    {
+        // In byte mode a session may overshoot its window by one chunk
+        const size_t perSession = cfg.transferSessionChunkQueueMaxBytes() > 0
+                                ? cfg.transferSessionChunkQueueMaxBytes() + cfg.transferSessionMaxChunkSize()
+                                : cfg.transferSessionMaxChunkSize() * cfg.transferSessionChunkQueueMaxSize();
+        const size_t maxMem = cfg.transferSessionCountLimit() * perSession;
         const double maxMemMB = static_cast<double>(maxMem) / (1024.0 * 1024.0);
-        PLOG_INFO << "Max memory for chunk buffers: "
-                  << cfg.transferSessionCountLimit() << " sessions * "
-                  << cfg.transferSessionMaxChunkSize() << " bytes/chunk * "
-                  << cfg.transferSessionChunkQueueMaxSize() << " chunks/buffer = "
-                  << std::fixed << std::setprecision(0) << maxMemMB << " MB";
+        if (cfg.transferSessionChunkQueueMaxBytes() > 0)
+        {
+            PLOG_INFO << "Max memory for chunk buffers: "
+                      << cfg.transferSessionCountLimit() << " sessions * ("
+                      << cfg.transferSessionChunkQueueMaxBytes() << " bytes/buffer + "
+                      << cfg.transferSessionMaxChunkSize() << " bytes/chunk) = "
+                      << std::fixed << std::setprecision(0) << maxMemMB << " MB";
+        }
+        else
+        {
+            PLOG_INFO << "Max memory for chunk buffers: "
+                      << cfg.transferSessionCountLimit() << " sessions * "
+                      << cfg.transferSessionMaxChunkSize() << " bytes/chunk * "
+                      << cfg.transferSessionChunkQueueMaxSize() << " chunks/buffer = "
+                      << std::fixed << std::setprecision(0) << maxMemMB << " MB";
+        }
 
         const size_t totalRAM = getTotalRAM();
-        if (totalRAM > 0 && maxMem > totalRAM) {
+        if (cfg.transferSessionMemoryBudget() == 0)
+        {
+            // Automatic budget: half of the physical memory (unlimited if it is unknown)
+            cfg.setTransferSessionMemoryBudget(totalRAM / 2);
+        }
+
+        const size_t budget = cfg.transferSessionMemoryBudget();
+        if (budget > 0)
+        {
+            const double budgetMB = static_cast<double>(budget) / (1024.0 * 1024.0);
+            PLOG_INFO << "Memory budget for chunk buffers: " << std::fixed << std::setprecision(0) << budgetMB << " MB";
+        }
+
+        if (totalRAM > 0 && (budget == 0 || budget > totalRAM) && maxMem > totalRAM) {
             const double ramMB = static_cast<double>(totalRAM) / (1024.0 * 1024.0);
             PLOG_WARNING << "Max chunk buffer memory (" << maxMemMB << " MB) exceeds available RAM (" << std::fixed << std::setprecision(0) << ramMB << " MB)";
         }
@@ -8,15 +8,30 @@
 #include <vector>
 #include <algorithm>
 #include <mutex>
-#include <shared_mutex>
-#include <any>
+#include <atomic>
+#include <iterator>
+#include <variant>
+
+/*
+ * The data of an event enum, declared next to the enum:
+ *     template<> struct EventPayload<Event::Foo> { using Type = ...; };
+ * One type for all its events, or a std::variant when they carry different
+ * data, so the subscriber gets it typed: no casts, no exceptions and no heap.
+ */
+template<typename EventType>
+struct EventPayload;
+
+template<typename EventType>
+using EventPayloadType = typename EventPayload<EventType>::Type;
 
 template<typename EventType>
 class Subscriber : public std::enable_shared_from_this<Subscriber<EventType>>
 {
 public:
+    using Payload = EventPayloadType<EventType>;
+
     virtual ~Subscriber() = default;
-    virtual void update(EventType type, std::any any) = 0;
+    virtual void update(EventType type, const Payload& data) = 0;
 
 protected:
     Subscriber() = default;
@@ -36,15 +51,18 @@ std::shared_ptr<SubscriberType> createSubscriber(Args&&... args)
 }
 
 
+/*
+ * The subscribers are kept in an immutable snapshot (copy-on-write):
+ * add/remove publish a new list, notify only loads the current one,
+ * so a notification takes no lock and allocates nothing, and a subscriber
+ * may subscribe or unsubscribe from its own update(). The expired entries
+ * are dropped by the next add/remove or by the notify that finds them.
+ */
 template<typename EventType>
 class Publisher
 {
 public:
-    virtual ~Publisher()
-    {
-        std::unique_lock lock(m_mutex);
-        m_subscribers.clear();
-    }
+    virtual ~Publisher() = default;
 
     void addSubscriber(std::shared_ptr<Subscriber<EventType>> subscriber)
     {
@@ -53,60 +71,64 @@ public:
             return;
         }
 
-        std::unique_lock lock(m_mutex);
+        std::lock_guard lock(m_writeMutex);
 
-        if (!hasSubscriber(subscriber))
+        const auto current = m_subscribers.load();
+        if (hasSubscriber(*current, subscriber))
         {
-            m_subscribers.push_back(subscriber);
+            return;
         }
+        auto next = withoutExpired(*current);
+        next->push_back(subscriber);
+        m_subscribers.store(std::move(next));
     }
 
     void removeSubscriber(std::shared_ptr<Subscriber<EventType>> subscriber)
     {
-        std::unique_lock lock(m_mutex);
+        std::lock_guard lock(m_writeMutex);
 
-        auto it = std::find_if(m_subscribers.begin(), m_subscribers.end(),
-                               [&subscriber](const std::weak_ptr<Subscriber<EventType>>& wp) {
-                                   return !wp.expired() && wp.lock() == subscriber;
-                               });
-
-        if (it != m_subscribers.end())
+        const auto current = m_subscribers.load();
+        if (not hasSubscriber(*current, subscriber))
         {
-            m_subscribers.erase(it);
+            return;
         }
+        auto next = withoutExpired(*current);
+        next->erase(std::find_if(next->begin(), next->end(),
+                                 [&subscriber](const std::weak_ptr<Subscriber<EventType>>& wp) {
+                                     return wp.lock() == subscriber;
+                                 }));
+        m_subscribers.store(std::move(next));
     }
 
-    void notifySubscribers(const EventType& event, std::any data)
+    void notifySubscribers(const EventType& event, const EventPayloadType<EventType>& data)
     {
-        std::vector<std::shared_ptr<Subscriber<EventType>>> validSubcribers;
+        const auto snapshot = m_subscribers.load();
+        bool someExpired = false;
 
+        for (const auto& wp : *snapshot)
         {
-            std::unique_lock lock(m_mutex);
-
-            m_subscribers.erase(
-                std::remove_if(m_subscribers.begin(), m_subscribers.end(),
-                                [&validSubcribers](const std::weak_ptr<Subscriber<EventType>>& wp) {
-                                    if (auto sp = wp.lock()) {
-                                        validSubcribers.push_back(sp);
-                                        return false;
-                                    }
-                                    return true;
-                                }),
-                m_subscribers.end()
-            );
+            if (auto subscriber = wp.lock())
+            {
+                subscriber->update(event, data);
+            }
+            else
+            {
+                someExpired = true;
+            }
         }
 
-        for (auto& subscriber : validSubcribers)
+        if (someExpired)
         {
-            subscriber->update(event, data);
+            std::lock_guard lock(m_writeMutex);
+            m_subscribers.store(withoutExpired(*m_subscribers.load()));
         }
     }
 
     size_t countSubscribers() const
     {
-        std::shared_lock lock(m_mutex);
+        const auto snapshot = m_subscribers.load();
 
-        return std::count_if(m_subscribers.begin(), m_subscribers.end(),
+        return std::count_if(snapshot->begin(), snapshot->end(),
                              [](const std::weak_ptr<Subscriber<EventType>>& wp) {
                                  return !wp.expired();
                              });
@@ -116,14 +138,27 @@ protected:
     Publisher() = default;
 
 private:
-    mutable std::shared_mutex m_mutex;
-    std::vector<std::weak_ptr<Subscriber<EventType>>> m_subscribers;
+    using List = std::vector<std::weak_ptr<Subscriber<EventType>>>;
+
+    std::atomic<std::shared_ptr<const List>> m_subscribers {std::make_shared<const List>()};
+    std::mutex m_writeMutex; // add/remove/compaction, one writer at a time
 
-    bool hasSubscriber(std::shared_ptr<Subscriber<EventType>> observer) const
+    static bool hasSubscriber(const List& list, const std::shared_ptr<Subscriber<EventType>>& observer)
     {
-        return std::any_of(m_subscribers.begin(), m_subscribers.end(),
+        return std::any_of(list.begin(), list.end(),
                            [&observer](const std::weak_ptr<Subscriber<EventType>>& wp) {
-                               return !wp.expired() && wp.lock() == observer;
+                               return wp.lock() == observer;
                            });
     }
+
+    static std::shared_ptr<List> withoutExpired(const List& list)
+    {
+        auto next = std::make_shared<List>();
+        next->reserve(list.size() + 1);
+        std::copy_if(list.begin(), list.end(), std::back_inserter(*next),
+                     [](const std::weak_ptr<Subscriber<EventType>>& wp) {
+                         return !wp.expired();
+                     });
+        return next;
+    }
 };
@@ -0,0 +1,36 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#pragma once
+
+#include <shared_mutex>
+
+/*
+ * A shared mutex that can be switched off when it is constructed.
+ * With [server] session_strand all the work of a session runs on its strand,
+ * so the session state is confined to the strand and its locks are not taken.
+ * Otherwise it is an ordinary std::shared_mutex.
+ */
+class OptionalSharedMutex
+{
+public:
+    explicit OptionalSharedMutex(bool enabled = true) : m_enabled(enabled) {}
+
+    OptionalSharedMutex(const OptionalSharedMutex&) = delete;
+    OptionalSharedMutex& operator=(const OptionalSharedMutex&) = delete;
+
+    void lock()                 { if (m_enabled) m_mutex.lock(); }
+    bool try_lock()             { return not m_enabled or m_mutex.try_lock(); }
+    void unlock()               { if (m_enabled) m_mutex.unlock(); }
+
+    void lock_shared()          { if (m_enabled) m_mutex.lock_shared(); }
+    bool try_lock_shared()      { return not m_enabled or m_mutex.try_lock_shared(); }
+    void unlock_shared()        { if (m_enabled) m_mutex.unlock_shared(); }
+
+    bool enabled() const        { return m_enabled; }
+
+private:
+    std::shared_mutex m_mutex;
+    const bool m_enabled;
+};
@@ -0,0 +1,85 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#include "progresscoalescer.h"
+
+ProgressCoalescer::ProgressCoalescer(asio::io_context &ioContext, Duration interval, std::function<void()> emit)
+    : m_state(std::make_shared<State>())
+    , m_wheel(TimerWheel::of(ioContext))
+{
+    std::weak_ptr<State> weakState = m_state;
+    m_entry = TimerWheel::makeEntry([weakState]() {
+        if (auto state = weakState.lock())
+        {
+            onInterval(state);
+        }
+    });
+
+    m_state->emit = std::move(emit);
+    m_state->interval = interval;
+    m_state->wheel = m_wheel;
+    m_state->entry = m_entry;
+}
+
+ProgressCoalescer::~ProgressCoalescer()
+{
+    m_wheel->cancel(m_entry);
+}
+
+void ProgressCoalescer::touch()
+{
+    {
+        std::lock_guard lock (m_state->mutex);
+        if (m_state->armed)
+        {
+            m_state->dirty = true;
+            return;
+        }
+        if (m_state->interval.count() > 0)
+        {
+            m_state->armed = true;
+            m_wheel->arm(m_entry, m_state->interval);
+        }
+    }
+    m_state->emit();
+}
+
+void ProgressCoalescer::flush()
+{
+    {
+        std::lock_guard lock (m_state->mutex);
+        if (not m_state->dirty)
+        {
+            return;
+        }
+        m_state->dirty = false;
+    }
+    m_state->emit();
+}
+
+void ProgressCoalescer::onInterval(const std::shared_ptr<State> &state)
+{
+    {
+        std::lock_guard lock (state->mutex);
+        if (not state->dirty)
+        {
+            state->armed = false;
+            return;
+        }
+
+        // The merged change goes out now and opens a new interval
+        state->dirty = false;
+        auto wheel = state->wheel.lock();
+        auto entry = state->entry.lock();
+        if (wheel and entry)
+        {
+            wheel->arm(entry, state->interval);
+        }
+        else
+        {
+            state->armed = false;
+        }
+    }
+    state->emit();
+}
@@ -0,0 +1,59 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#pragma once
+
+#include "timerwheel.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <asio.hpp>
+
+/*
+ * Rate limit for progress counters (bytes in/out, bytes received).
+ * The first change after a quiet period is emitted at once; the changes
+ * within the following interval are merged, and the emit callback, which
+ * reads the latest counters itself, runs once when the interval ends.
+ * An interval of 0 emits every change.
+ *
+ * The timed emit runs on the io_context thread, so the callback must not
+ * refer to an owner that may be gone by then.
+ */
+class ProgressCoalescer
+{
+public:
+    using Duration = std::chrono::milliseconds;
+
+    ProgressCoalescer(asio::io_context& ioContext, Duration interval, std::function<void()> emit);
+    ~ProgressCoalescer();
+
+    // The counters have changed
+    void touch();
+    // Emits a change that is still waiting for the interval to end
+    void flush();
+
+private:
+    ProgressCoalescer(const ProgressCoalescer&) = delete;
+    ProgressCoalescer& operator=(const ProgressCoalescer&) = delete;
+
+    // Shared with the timer entry, which may fire after the coalescer is gone
+    struct State
+    {
+        std::mutex mutex;
+        bool armed = false; // an interval is running
+        bool dirty = false; // changed since the last emit
+        std::function<void()> emit;
+        Duration interval;
+        std::weak_ptr<TimerWheel> wheel;
+        std::weak_ptr<TimerWheel::Entry> entry;
+    };
+
+    static void onInterval(const std::shared_ptr<State>& state);
+
+    std::shared_ptr<State> m_state;
+    std::shared_ptr<TimerWheel> m_wheel;
+    std::shared_ptr<TimerWheel::Entry> m_entry;
+};
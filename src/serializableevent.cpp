@@ -3,256 +3,256 @@
 // For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
 
 #include "serializableevent.h"
-#include "crowlib/crow/json.h"
+#include "jsonwriter.h"
+#include "binaryprotocol.h"
 #include "transfersession.h"
 #include "buffer.h"
 
+namespace {
+
+/*
+ * {"event":"<name>","data":{...}}, the data fields are written by fill.
+ * The result is the only allocation, sized for the fields beforehand.
+ */
+template<size_t N, typename Fill>
+std::string event(const char (&name)[N], size_t dataSize, Fill fill)
+{
+    std::string out;
+    out.reserve(N + dataSize + 24);
+    JsonWriter writer (out);
+    writer.beginObject().key("event").string(name).key("data").beginObject();
+    fill(writer);
+    writer.endObject().endObject();
+    return out;
+}
+
+template<size_t N>
+std::string emptyEvent(const char (&name)[N])
+{
+    return event(name, 0, [](JsonWriter&) {});
+}
+
+// An empty list is dumped by crow::json as null, the clients got it so
+template<typename List, typename WriteItem>
+void writeList(JsonWriter& writer, const List& list, WriteItem writeItem)
+{
+    if (list.empty())
+    {
+        writer.null();
+        return;
+    }
+    writer.beginArray();
+    for (const auto& item: list)
+    {
+        writeItem(item);
+    }
+    writer.endArray();
+}
+
+std::string binaryEvent(BinaryProtocol::EventType type, size_t size)
+{
+    std::string out;
+    out.reserve(size + 1);
+    out.push_back(static_cast<char>(type));
+    return out;
+}
+
+} // namespace
+
 std::string SerializableEvent::Online::json() const
 {
-    crow::json::wvalue root = {
-        {"event", "online"},
-        {"data", {
-             {"id", publicId},
-             {"status", connected}
-         }}
-    };
-
-    return root.dump();
+    return event("online", publicId.size() + 32, [&](JsonWriter& w) {
+        w.key("id").string(publicId);
+        w.key("status").boolean(connected);
+    });
 }
 
 std::string SerializableEvent::NameChanged::json() const
 {
-    crow::json::wvalue root = {
-        {"event", "name_changed"},
-        {"data", {
-             {"id", publicId},
-             {"name", name}
-         }}
-    };
-
-    return root.dump();
+    return event("name_changed", publicId.size() + name.size() + 32, [&](JsonWriter& w) {
+        w.key("id").string(publicId);
+        w.key("name").string(name);
+    });
 }
 
 std::string SerializableEvent::NewReceiver::json() const
 {
-    crow::json::wvalue root = {
-        {"event", "new_receiver"},
-        {"data", {
-             {"id", publicId},
-             {"name", name}
-         }}
-    };
-
-    return root.dump();
+    return event("new_receiver", publicId.size() + name.size() + 32, [&](JsonWriter& w) {
+        w.key("id").string(publicId);
+        w.key("name").string(name);
+    });
 }
 
 std::string SerializableEvent::ReceiverRemoved::json() const
 {
-    crow::json::wvalue root = {
-        {"event", "receiver_removed"},
-        {"data", {
-             {"id", publicId}
-         }}
-    };
-
-    return root.dump();
+    return event("receiver_removed", publicId.size() + 16, [&](JsonWriter& w) {
+        w.key("id").string(publicId);
+    });
 }
 
-
 std::string SerializableEvent::FileInfoUpdated::json() const
 {
-    crow::json::wvalue root = {
-        {"event", "file_info"},
-        {"data", {
-             {"name", name},
-             {"size", size}
-         }}
-    };
-
-    return root.dump();
+    return event("file_info", name.size() + 48, [&](JsonWriter& w) {
+        w.key("name").string(name);
+        w.key("size").number(size);
+    });
 }
 
 std::string SerializableEvent::ChunkDownload::json() const
 {
-    crow::json::wvalue root = {
-        {"event", "chunk_download"},
-        {"data", {
-             {"id", publicId},
-             {"index", chunkId},
-             {"action", started ? "started" : "finished"}
-         }}
-    };
-
-    return root.dump();
+    return event("chunk_download", publicId.size() + 64, [&](JsonWriter& w) {
+        w.key("id").string(publicId);
+        w.key("index").number(chunkId);
+        w.key("action").string(started ? "started" : "finished");
+    });
+}
+
+std::string SerializableEvent::ChunkDownload::binary() const
+{
+    auto out = binaryEvent(BinaryProtocol::EventType::chunkDownload, publicId.size() + 12);
+    BinaryProtocol::appendString(out, publicId);
+    BinaryProtocol::appendVarint(out, chunkId);
+    out.push_back(started ? 1 : 0);
+    return out;
 }
 
 std::string SerializableEvent::NewChunkAvailable::json() const
 {
-    crow::json::wvalue root = {
-        {"event", "new_chunk"},
-        {"data", {
-             {"index", chunkId},
-             {"size", size}
-         }}
-    };
-
-    return root.dump();
+    return event("new_chunk", 64, [&](JsonWriter& w) {
+        w.key("index").number(chunkId);
+        w.key("size").number(size);
+    });
+}
+
+std::string SerializableEvent::NewChunkAvailable::binary() const
+{
+    auto out = binaryEvent(BinaryProtocol::EventType::newChunk, 20);
+    BinaryProtocol::appendVarint(out, chunkId);
+    BinaryProtocol::appendVarint(out, size);
+    return out;
 }
 
 std::string SerializableEvent::ChunksRemoved::json() const
 {
-    crow::json::wvalue idxs;
-    size_t index = 0;
+    return event("chunk_removed", 16 + list.size() * 8, [&](JsonWriter& w) {
+        w.key("id");
+        writeList(w, list, [&](size_t id) { w.number(id); });
+    });
+}
+
+std::string SerializableEvent::ChunksRemoved::binary() const
+{
+    auto out = binaryEvent(BinaryProtocol::EventType::chunksRemoved, 2 + list.size() * 4);
+    BinaryProtocol::appendVarint(out, list.size());
     for (const auto& id: list)
     {
-        idxs[index++] = id;
+        BinaryProtocol::appendVarint(out, id);
     }
-
-    crow::json::wvalue root = {
-        {"event", "chunk_removed"},
-        {"data", {
-            {"id", std::move(idxs)}
-        }}
-    };
-
-    return root.dump();
+    return out;
 }
 
 std::string SerializableEvent::UploadFinished::json() const
 {
-    crow::json::wvalue root = {
-        {"event", "upload_finished"},
-        {"data", crow::json::wvalue::empty_object()}
-    };
-
-    return root.dump();
+    return emptyEvent("upload_finished");
 }
 
 std::string SerializableEvent::SessionComplete::json() const
 {
     using t = Event::Data::TransferSessionCompleteType;
 
-    crow::json::wvalue root = {
-        {"event", "complete"},
-        {"data", {
-            {"status", type == t::ok ? "ok" : type == t::timeout ? "timeout" :
-                       type == t::senderIsGone ? "sender_is_gone" :
-                       type == t::noReceivers ? "no_receivers" : "error"}
-         }}
-    };
-
-    return root.dump();
+    return event("complete", 32, [&](JsonWriter& w) {
+        w.key("status").string(type == t::ok ? "ok" : type == t::timeout ? "timeout" :
+                               type == t::senderIsGone ? "sender_is_gone" :
+                               type == t::noReceivers ? "no_receivers" : "error");
+    });
 }
 
 std::string SerializableEvent::Kicked::json() const
 {
-    crow::json::wvalue root = {
-        {"event", "kicked"},
-        {"data", crow::json::wvalue::empty_object()}
-    };
-
-    return root.dump();
+    return emptyEvent("kicked");
 }
 
 std::string SerializableEvent::TotalBytesCount::json() const
 {
-    crow::json::wvalue root = {
-        {"event", "bytes_count"},
-        {"data", {
-             {"value", value},
-             {"direction", in ? "from_sender" : "to_receivers"}
-         }}
-    };
-
-    return root.dump();
+    return event("bytes_count", 64, [&](JsonWriter& w) {
+        w.key("value").number(value);
+        w.key("direction").string(in ? "from_sender" : "to_receivers");
+    });
+}
+
+std::string SerializableEvent::TotalBytesCount::binary() const
+{
+    auto out = binaryEvent(BinaryProtocol::EventType::bytesCount, 11);
+    BinaryProtocol::appendVarint(out, value);
+    out.push_back(in ? 1 : 0);
+    return out;
 }
 
 std::string SerializableEvent::NewChunkIsAllowed::json() const
 {
     // The event is for sender only
-    crow::json::wvalue root = {
-        {"event", "new_chunk_allowed"},
-        {"data", {
-            {"status", status}
-        }}
-    };
-
-    return root.dump();
+    return event("new_chunk_allowed", 48, [&](JsonWriter& w) {
+        w.key("status").boolean(status);
+        if (not status and memoryBudgetExhausted)
+        {
+            w.key("reason").string("memory_budget");
+        }
+    });
 }
 
-std::string SerializableEvent::ChunksAreUnfrozen::json() const
+std::string SerializableEvent::NewChunkIsAllowed::binary() const
 {
-    crow::json::wvalue root = {
-        {"event", "chunks_unfrozen"},
-        {"data", crow::json::wvalue::empty_object()}
-    };
+    auto out = binaryEvent(BinaryProtocol::EventType::newChunkAllowed, 2);
+    out.push_back(status ? 1 : 0);
+    out.push_back(not status and memoryBudgetExhausted ? 1 : 0);
+    return out;
+}
 
-    return root.dump();
+std::string SerializableEvent::ChunksAreUnfrozen::json() const
+{
+    return emptyEvent("chunks_unfrozen");
 }
 
 std::string SerializableEvent::PersonalReceivedUpdated::json() const
 {
-    crow::json::wvalue root = {
-        {"event", "personal_received"},
-        {"data", {
-            {"bytes", bytes}
-        }
-    }};
+    return event("personal_received", 32, [&](JsonWriter& w) {
+        w.key("bytes").number(bytes);
+    });
+}
 
-    return root.dump();
+std::string SerializableEvent::PersonalReceivedUpdated::binary() const
+{
+    auto out = binaryEvent(BinaryProtocol::EventType::personalReceived, 10);
+    BinaryProtocol::appendVarint(out, bytes);
+    return out;
 }
 
 std::string SerializableEvent::AddingChunkFailure::json() const
 {
-    crow::json::wvalue root = {
-        {"event", "add_chunk_failure"},
-        {"data", crow::json::wvalue::empty_object()}
-    };
-
-    return root.dump();
+    return emptyEvent("add_chunk_failure");
 }
 
 std::string SerializableEvent::SetFileInfoFailure::json() const
 {
-    crow::json::wvalue root = {
-        {"event", "set_file_info_failure"},
-        {"data", crow::json::wvalue::empty_object()}
-    };
-
-    return root.dump();
+    return emptyEvent("set_file_info_failure");
 }
 
 std::string SerializableEvent::GetChunkFailure::json() const
 {
-    crow::json::wvalue infoJson;
-    size_t counter = 0;
-    for (const auto& info: list)
-    {
-        infoJson[counter]["index"] = info.index;
-        infoJson[counter]["size"] = info.size;
-
-        ++counter;
-    }
-
-    crow::json::wvalue root = {
-        {"event", "requested_chunk_not_found"},
-        {"data", {
-            {"available", std::move(infoJson)}
-        }}
-    };
-
-    return root.dump();
+    return event("requested_chunk_not_found", 16 + list.size() * 40, [&](JsonWriter& w) {
+        w.key("available");
+        writeList(w, list, [&](const Event::Data::ChunkInfo& info) {
+            w.beginObject();
+            w.key("index").number(info.index);
+            w.key("size").number(info.size);
+            w.endObject();
+        });
+    });
 }
 
 std::string SerializableEvent::UnknownAction::json() const
 {
-    crow::json::wvalue root = {
-        {"event", "unknown_action"},
-        {"data", {
-            {"name", action}
-        }
-    }};
-
-    return root.dump();
+    return event("unknown_action", action.size() + 16, [&](JsonWriter& w) {
+        w.key("name").string(action);
+    });
 }
-
@@ -6,6 +6,7 @@
 
 #include <string>
 #include <list>
+#include <memory>
 
 namespace Event {
 namespace Data {
@@ -15,6 +16,32 @@ struct ChunkInfo;}
 
 namespace SerializableEvent {
 
+/*
+ * An event serialized once for all its recipients: every websocket
+ * queues the same immutable buffer.
+ */
+using Frame = std::shared_ptr<const std::string>;
+
+inline Frame frame(std::string json)
+{
+    return std::make_shared<const std::string>(std::move(json));
+}
+
+/*
+ * The frames of an event for both WebSocket protocols. binary is null
+ * for the events that have no binary form, they are sent as JSON.
+ */
+struct Frames
+{
+    Frame json;
+    Frame binary;
+};
+
+/*
+ * The events sent for every chunk also have a binary form (binary()),
+ * see BinaryProtocol::EventType.
+ */
+
 struct Online
 {
     std::string publicId;
@@ -61,6 +88,7 @@ struct ChunkDownload
     bool started = false; // else finished
 
     std::string json() const;
+    std::string binary() const;
 };
 
 struct NewChunkAvailable
@@ -69,6 +97,7 @@ struct NewChunkAvailable
     size_t size = 0;
 
     std::string json() const;
+    std::string binary() const;
 };
 
 struct ChunksRemoved
@@ -76,6 +105,7 @@ struct ChunksRemoved
     std::list<size_t> list;
 
     std::string json() const;
+    std::string binary() const;
 };
 
 struct UploadFinished
@@ -101,14 +131,17 @@ struct TotalBytesCount
     bool in = false; // else - out
 
     std::string json() const;
+    std::string binary() const;
 };
 
 // The event is for sender only
 struct NewChunkIsAllowed
 {
     bool status = false;
+    bool memoryBudgetExhausted = false; // adds "reason": "memory_budget" when not allowed
 
     std::string json() const;
+    std::string binary() const;
 };
 
 struct ChunksAreUnfrozen
@@ -121,6 +154,7 @@ struct PersonalReceivedUpdated
     size_t bytes = 0;
 
     std::string json() const;
+    std::string binary() const;
 };
 
 struct AddingChunkFailure
@@ -0,0 +1,133 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex> // unique_lock
+#include <shared_mutex>
+#include <unordered_map>
+
+/*
+ * Hash map split into SHARDS independent maps, each with its own lock.
+ * A key always lands in the shard picked by its hash, so lookups of
+ * different keys rarely wait for each other and an insertion or a removal
+ * blocks only the readers of one shard. The element count is kept in an
+ * atomic and is read without any lock.
+ *
+ * The values are only reached through callbacks run under the shard lock:
+ * keep them short and do not call back into the same map from them.
+ */
+template<typename Key, typename Value, size_t SHARDS = 16>
+class ShardedMap
+{
+    static_assert(SHARDS > 0 and (SHARDS & (SHARDS - 1)) == 0, "the shard count must be a power of two");
+
+public:
+    size_t size() const
+    {
+        return m_size.load(std::memory_order_relaxed);
+    }
+
+    // Calls visit(const Value&) if the key is present
+    template<typename Visit>
+    bool visit(const Key& key, Visit&& visit) const
+    {
+        const Shard& shard = shardFor(key);
+        std::shared_lock lock (shard.mutex);
+
+        const auto iter = shard.map.find(key);
+        if (iter == shard.map.end())
+        {
+            return false;
+        }
+        visit(iter->second);
+        return true;
+    }
+
+    /*
+     * Inserts make() unless the key is present, make() is not called then.
+     * inserted(Value&) is called for the new value before the shard is unlocked.
+     */
+    template<typename Make, typename Inserted>
+    bool tryEmplace(const Key& key, Make&& make, Inserted&& inserted)
+    {
+        Shard& shard = shardFor(key);
+        std::unique_lock lock (shard.mutex);
+
+        if (shard.map.contains(key))
+        {
+            return false;
+        }
+        auto [iter, _] = shard.map.try_emplace(key, make());
+        m_size.fetch_add(1, std::memory_order_relaxed);
+        inserted(iter->second);
+        return true;
+    }
+
+    template<typename Make>
+    bool tryEmplace(const Key& key, Make&& make)
+    {
+        return tryEmplace(key, std::forward<Make>(make), [](Value&) {});
+    }
+
+    /*
+     * Calls take(Value&) and erases the key if it is present. The value is
+     * destroyed under the shard lock: move out of it whatever has to outlive
+     * the lock (for example a shared_ptr whose object locks this map when destroyed).
+     */
+    template<typename Take>
+    bool erase(const Key& key, Take&& take)
+    {
+        Shard& shard = shardFor(key);
+        std::unique_lock lock (shard.mutex);
+
+        auto iter = shard.map.find(key);
+        if (iter == shard.map.end())
+        {
+            return false;
+        }
+        take(iter->second);
+        shard.map.erase(iter);
+        m_size.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Calls visit(const Key&, const Value&) for every element, one shard at a time
+    template<typename Visit>
+    void forEach(Visit&& visit) const
+    {
+        for (const Shard& shard : m_shards)
+        {
+            std::shared_lock lock (shard.mutex);
+            for (const auto& [key, value] : shard.map)
+            {
+                visit(key, value);
+            }
+        }
+    }
+
+private:
+    // Every shard on its own cache line, so the locks of neighbours do not share one
+    struct alignas(64) Shard
+    {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<Key, Value> map;
+    };
+
+    Shard& shardFor(const Key& key)
+    {
+        return m_shards[std::hash<Key>()(key) & (SHARDS - 1)];
+    }
+
+    const Shard& shardFor(const Key& key) const
+    {
+        return m_shards[std::hash<Key>()(key) & (SHARDS - 1)];
+    }
+
+    std::array<Shard, SHARDS> m_shards;
+    std::atomic<size_t> m_size {0};
+};
@@ -5,11 +5,9 @@
 #include "timercallback.h"
 
 TimerCallback::TimerCallback(TimerCallback &&another) noexcept
-    : m_timer(std::move(another.m_timer))
-    , m_callback(std::move(another.m_callback))
-    , m_duration(another.m_duration)
-    , m_startTime(another.m_startTime)
-    , m_isRunning(another.m_isRunning.exchange(false))
+    : m_wheel(std::move(another.m_wheel))
+    , m_entry(std::move(another.m_entry))
+    , m_duration(another.m_duration.load())
 {
 }
 
@@ -20,68 +18,44 @@ TimerCallback::~TimerCallback()
 
 void TimerCallback::start()
 {
-    if (m_isRunning.exchange(true))
+    if (m_entry)
     {
-        return;
+        m_wheel->armIfIdle(m_entry, m_duration.load());
     }
-
-    {
-        std::lock_guard lock(m_timeMutex);
-        m_startTime = std::chrono::steady_clock::now();
-    }
-    m_timer.expires_after(m_duration);
-
-    m_timer.async_wait([this](const std::error_code& ec) {
-        if (!ec && m_isRunning.load())
-        {
-            m_isRunning.store(false);
-            if (m_callback)
-            {
-                m_callback();
-            }
-        }
-    });
 }
 
 void TimerCallback::stop()
 {
-    if (m_isRunning.exchange(false))
+    if (m_entry)
     {
-        m_timer.cancel();
+        m_wheel->cancel(m_entry);
     }
 }
 
 bool TimerCallback::isRunning() const
 {
-    return m_isRunning.load();
+    return m_entry and m_wheel->isArmed(m_entry);
 }
 
 void TimerCallback::restart(Duration newDuration)
 {
-    stop();
-    {
-        std::lock_guard lock(m_timeMutex);
-        m_duration = newDuration;
-    }
-    start();
+    m_duration.store(newDuration);
+    restart();
 }
 
 void TimerCallback::restart()
 {
-    stop();
-    start();
+    if (m_entry)
+    {
+        m_wheel->arm(m_entry, m_duration.load());
+    }
 }
 
 TimerCallback::Duration TimerCallback::timeRemaining() const
 {
-    if (not m_isRunning.load())
+    if (not m_entry)
     {
         return Duration(0);
     }
-
-    std::lock_guard lock(m_timeMutex);
-    const auto elapsed = std::chrono::steady_clock::now() - m_startTime;
-    const auto remaining = m_duration - std::chrono::duration_cast<Duration>(elapsed);
-
-    return std::max(Duration(0), remaining);
+    return std::chrono::ceil<Duration>(m_wheel->remaining(m_entry));
 }
@@ -4,12 +4,15 @@
 
 #pragma once
 
+#include "timerwheel.h"
+
 #include <functional>
 #include <chrono>
-#include <mutex>
+#include <memory>
 #include <asio.hpp>
 #include <atomic>
 
+// One-shot timeout on the TimerWheel of the io_context: the callback runs on its thread
 class TimerCallback
 {
 public:
@@ -17,11 +20,9 @@ public:
     using Duration = std::chrono::seconds;
 
     TimerCallback(asio::io_context& ioContext, Callback callback, Duration duration)
-                  : m_timer(ioContext)
-                  , m_callback(std::move(callback))
-                  , m_duration(duration)
-                  , m_startTime(std::chrono::steady_clock::now())
-                  , m_isRunning(false) {}
+                  : m_wheel(TimerWheel::of(ioContext))
+                  , m_entry(TimerWheel::makeEntry(std::move(callback)))
+                  , m_duration(duration) {}
 
     TimerCallback(TimerCallback&& another) noexcept;
     ~TimerCallback();
@@ -34,10 +35,8 @@ public:
     void restart();
 
 private:
-    asio::steady_timer m_timer;
-    Callback m_callback;
-    Duration m_duration;
-    std::chrono::steady_clock::time_point m_startTime;
-    mutable std::mutex m_timeMutex;
-    std::atomic<bool> m_isRunning;
+    std::shared_ptr<TimerWheel> m_wheel;
+    // Null in a moved-from object
+    std::shared_ptr<TimerWheel::Entry> m_entry;
+    std::atomic<Duration> m_duration;
 };
@@ -0,0 +1,240 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#include "timerwheel.h"
+
+#include <vector>
+
+/*
+ * Holds the wheel of an io_context. The entries own the wheel as well,
+ * so it may outlive the io_context: the service shuts it down when the
+ * io_context is destroyed.
+ */
+class TimerWheel::Service : public asio::execution_context::service
+{
+public:
+    static asio::execution_context::id id;
+
+    explicit Service(asio::io_context& ioContext)
+        : asio::execution_context::service(ioContext)
+        , wheel(new TimerWheel(ioContext))
+    {
+    }
+
+    void shutdown() override
+    {
+        wheel->shutdown();
+    }
+
+    const std::shared_ptr<TimerWheel> wheel;
+};
+
+asio::execution_context::id TimerWheel::Service::id;
+
+std::shared_ptr<TimerWheel> TimerWheel::of(asio::io_context &ioContext)
+{
+    return asio::use_service<Service>(ioContext).wheel;
+}
+
+std::shared_ptr<TimerWheel::Entry> TimerWheel::makeEntry(std::function<void()> callback)
+{
+    return std::make_shared<Entry>(std::move(callback));
+}
+
+TimerWheel::TimerWheel(asio::io_context &ioContext)
+    : m_timer(std::make_unique<asio::steady_timer>(ioContext))
+    , m_origin(Clock::now())
+{
+}
+
+TimerWheel::~TimerWheel() = default;
+
+void TimerWheel::arm(const std::shared_ptr<Entry> &entry, Clock::duration after)
+{
+    std::shared_ptr<Entry> previous;
+    std::lock_guard lock (m_mutex);
+    if (entry->m_self)
+    {
+        previous = unlink(*entry);
+    }
+    link(entry, after);
+}
+
+bool TimerWheel::armIfIdle(const std::shared_ptr<Entry> &entry, Clock::duration after)
+{
+    std::lock_guard lock (m_mutex);
+    if (entry->m_self)
+    {
+        return false;
+    }
+    link(entry, after);
+    return true;
+}
+
+bool TimerWheel::cancel(const std::shared_ptr<Entry> &entry)
+{
+    // Released after the mutex: the entry may hold the last reference to itself
+    std::shared_ptr<Entry> self;
+    std::lock_guard lock (m_mutex);
+    entry->m_generation.fetch_add(1);
+    if (not entry->m_self)
+    {
+        return false;
+    }
+    self = unlink(*entry);
+    return true;
+}
+
+bool TimerWheel::isArmed(const std::shared_ptr<Entry> &entry) const
+{
+    std::lock_guard lock (m_mutex);
+    return entry->m_self != nullptr;
+}
+
+TimerWheel::Clock::duration TimerWheel::remaining(const std::shared_ptr<Entry> &entry) const
+{
+    Clock::time_point deadline;
+    {
+        std::lock_guard lock (m_mutex);
+        if (not entry->m_self)
+        {
+            return Clock::duration(0);
+        }
+        deadline = m_origin + entry->m_expiresAt * TICK;
+    }
+    return std::max(Clock::duration(0), deadline - Clock::now());
+}
+
+size_t TimerWheel::armedCount() const
+{
+    std::lock_guard lock (m_mutex);
+    return m_armed;
+}
+
+uint64_t TimerWheel::currentTick() const
+{
+    return (Clock::now() - m_origin) / TICK;
+}
+
+void TimerWheel::link(const std::shared_ptr<Entry> &entry, Clock::duration after)
+{
+    if (not m_timer)
+    {
+        return; // shut down
+    }
+
+    if (m_armed == 0)
+    {
+        // Nothing was visited while the wheel was idle
+        m_tick = currentTick();
+    }
+
+    // Rounded up, so the entry never fires early
+    const uint64_t ticks = std::max<uint64_t>(1, (after + TICK - Clock::duration(1)) / TICK);
+    entry->m_expiresAt = currentTick() + ticks;
+    entry->m_generation.fetch_add(1);
+    entry->m_self = entry;
+
+    Slot& slot = m_slots[entry->m_expiresAt % SLOTS];
+    entry->m_prev = nullptr;
+    entry->m_next = slot.head;
+    if (slot.head)
+    {
+        slot.head->m_prev = entry.get();
+    }
+    slot.head = entry.get();
+
+    ++m_armed;
+    scheduleTick();
+}
+
+std::shared_ptr<TimerWheel::Entry> TimerWheel::unlink(Entry &entry)
+{
+    if (entry.m_prev)
+    {
+        entry.m_prev->m_next = entry.m_next;
+    }
+    else
+    {
+        m_slots[entry.m_expiresAt % SLOTS].head = entry.m_next;
+    }
+    if (entry.m_next)
+    {
+        entry.m_next->m_prev = entry.m_prev;
+    }
+    entry.m_prev = nullptr;
+    entry.m_next = nullptr;
+    --m_armed;
+    return std::move(entry.m_self);
+}
+
+void TimerWheel::scheduleTick()
+{
+    if (m_ticking or m_armed == 0 or not m_timer)
+    {
+        return;
+    }
+    m_ticking = true;
+    m_timer->expires_at(m_origin + (m_tick + 1) * TICK);
+    m_timer->async_wait([this](const std::error_code& ec) { onTick(ec); });
+}
+
+void TimerWheel::onTick(const std::error_code &ec)
+{
+    if (ec)
+    {
+        return;
+    }
+
+    std::vector<std::pair<std::shared_ptr<Entry>, uint64_t>> fired;
+    {
+        std::lock_guard lock (m_mutex);
+        m_ticking = false;
+
+        // After a stall every slot is visited at most once
+        const uint64_t now = currentTick();
+        const uint64_t steps = std::min<uint64_t>(now - m_tick, SLOTS);
+        for (uint64_t step = 1; step <= steps; ++step)
+        {
+            Entry* entry = m_slots[(m_tick + step) % SLOTS].head;
+            while (entry)
+            {
+                Entry* next = entry->m_next;
+                if (entry->m_expiresAt <= now)
+                {
+                    const uint64_t generation = entry->m_generation.load();
+                    fired.emplace_back(unlink(*entry), generation);
+                }
+                entry = next;
+            }
+        }
+        m_tick = std::max(m_tick, now);
+        scheduleTick();
+    }
+
+    for (const auto& [entry, generation] : fired)
+    {
+        if (entry->m_generation.load() == generation and entry->m_callback)
+        {
+            entry->m_callback();
+        }
+    }
+}
+
+void TimerWheel::shutdown()
+{
+    std::vector<std::shared_ptr<Entry>> dropped;
+    {
+        std::lock_guard lock (m_mutex);
+        for (auto& slot : m_slots)
+        {
+            while (slot.head)
+            {
+                dropped.push_back(unlink(*slot.head));
+            }
+        }
+        m_timer.reset();
+        m_ticking = false;
+    }
+}
@@ -0,0 +1,100 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <asio.hpp>
+
+/*
+ * Hashed timer wheel, one per io_context, for the many coarse timeouts of
+ * the server (client disconnects, session lifetimes, ACK fallbacks).
+ * Instead of an asio timer per object, the entries are linked into one of
+ * SLOTS lists by their expiry tick: arming and cancelling is an O(1) list
+ * operation under one mutex, and a single steady_timer, running only while
+ * something is armed, visits one slot per TICK. Entries further than a full
+ * turn stay in their slot until the turn on which they are due.
+ *
+ * The callbacks run on the io_context thread, at most TICK late.
+ */
+class TimerWheel
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr std::chrono::milliseconds TICK {100};
+    static constexpr size_t SLOTS = 512;
+
+    class Entry
+    {
+    public:
+        explicit Entry(std::function<void()> callback) : m_callback(std::move(callback)) {}
+
+    private:
+        friend class TimerWheel;
+
+        std::function<void()> m_callback;
+        Entry* m_prev = nullptr;
+        Entry* m_next = nullptr;
+        // The wheel keeps an armed entry alive, its owner may drop it
+        std::shared_ptr<Entry> m_self;
+        uint64_t m_expiresAt = 0; // tick
+        // Bumped by every arm and cancel: a callback already collected for
+        // firing is skipped if its entry has been re-armed or cancelled since
+        std::atomic<uint64_t> m_generation {0};
+    };
+
+    // The wheel of the io_context, created on first use
+    static std::shared_ptr<TimerWheel> of(asio::io_context& ioContext);
+    static std::shared_ptr<Entry> makeEntry(std::function<void()> callback);
+
+    ~TimerWheel();
+
+    // Arms the entry to fire once after the given time, replacing a pending expiry
+    void arm(const std::shared_ptr<Entry>& entry, Clock::duration after);
+    // Arms the entry unless it is already armed, returns false then
+    bool armIfIdle(const std::shared_ptr<Entry>& entry, Clock::duration after);
+    // Returns false if the entry was not armed
+    bool cancel(const std::shared_ptr<Entry>& entry);
+
+    bool isArmed(const std::shared_ptr<Entry>& entry) const;
+    Clock::duration remaining(const std::shared_ptr<Entry>& entry) const;
+    size_t armedCount() const;
+
+private:
+    class Service;
+
+    explicit TimerWheel(asio::io_context& ioContext);
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel(TimerWheel&&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    uint64_t currentTick() const;
+    // The callers hold m_mutex
+    void link(const std::shared_ptr<Entry>& entry, Clock::duration after);
+    std::shared_ptr<Entry> unlink(Entry& entry);
+    void scheduleTick();
+
+    void onTick(const std::error_code& ec);
+    // Called by the io_context when it is destroyed: the armed entries are dropped
+    void shutdown();
+
+    struct Slot
+    {
+        Entry* head = nullptr;
+    };
+
+    mutable std::mutex m_mutex;
+    std::array<Slot, SLOTS> m_slots;
+    // Reset on shutdown, the io_context is gone after that
+    std::unique_ptr<asio::steady_timer> m_timer;
+    const Clock::time_point m_origin;
+    uint64_t m_tick = 0; // the last visited tick
+    size_t m_armed = 0;
+    bool m_ticking = false;
+};
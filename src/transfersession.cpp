@@ -8,6 +8,7 @@
 #include "serializableevent.h"
 #include "crowlib/crow/utility.h"
 #include "config/config.h"
+#include "chunkmemorypool.h"
 
 #include "log.h"
 
@@ -16,18 +17,27 @@
 TransferSession::TransferSession(std::shared_ptr<Client> sender, const std::string& sessionId,
                                  asio::io_context& ioContext, const Options& options)
     : m_id(sessionId)
+    , m_serialized(Config::instance().sessionStrand())
     , m_dataSender(sender)
+    , m_fileInfoMutex(not m_serialized)
+    , m_buffer(not m_serialized)
+    , m_receiversMutex(not m_serialized)
     , m_ioContext(ioContext)
+    , m_strand(asio::make_strand(ioContext))
     , m_options(options)
 {
     PLOG_DEBUG << "Session " << sessionId << " created"
-               << (options.autoDropFreezeOnFirstChunk ? " [auto-drop freeze]" : "");
+               << (options.autoDropFreezeOnFirstChunk ? " [auto-drop freeze]" : "")
+               << (m_serialized ? " [strand]" : "");
 }
 
 TransferSession::~TransferSession()
 {
     PLOG_INFO << "Session " << m_id << " destroyed";
 
+    // The last counters may still wait for their interval
+    publishProgress();
+
     // Each subscribed client's update() handler sends the "complete" event
     // via sendTextWithAck and, on ACK (or fallback timer), removes itself
     // from ClientList. No session-wide coordination required.
@@ -40,16 +50,40 @@ void TransferSession::initTimers(std::shared_ptr<TransferSession> me)
     m_initialFreezeTimer = std::make_unique<TimerCallback>(m_ioContext,
                      [weakSelf]() {
                         if (auto sharedSelf = weakSelf.lock()) {
-                            sharedSelf->dropInitialChunksFreeze();
+                            sharedSelf->execute([sharedSelf]() { sharedSelf->dropInitialChunksFreeze(); });
                         }
                      },
                     TimerCallback::Duration(Config::instance().transferSessionMaxInitialFreezeDuration()));
 
     m_initialFreezeTimer->start();
 
+    const auto progressInterval = Config::instance().transferSessionProgressInterval();
+    if (progressInterval > 0)
+    {
+        m_progress = std::make_unique<ProgressCoalescer>(m_ioContext,
+                        ProgressCoalescer::Duration(progressInterval),
+                        [weakSelf]() {
+                            if (auto sharedSelf = weakSelf.lock()) {
+                                sharedSelf->execute([sharedSelf]() { sharedSelf->publishProgress(); });
+                            }
+                        });
+    }
+
     PLOG_DEBUG << "Session " << m_id << " timers initialized";
 }
 
+void TransferSession::execute(std::function<void()> work)
+{
+    if (m_serialized)
+    {
+        asio::post(m_strand, std::move(work));
+    }
+    else
+    {
+        work();
+    }
+}
+
 const TransferSession::FileInfo TransferSession::fileInfo() const
 {
     std::shared_lock lock (m_fileInfoMutex);
@@ -107,7 +141,7 @@ bool TransferSession::addReceiver(std::shared_ptr<Client> client)
         client->Publisher<Event::ClientInternal>::addSubscriber(shared_from_this());
 
         Publisher<Event::TransferSession>::addSubscriber(client);
-        Publisher<Event::TransferSession>::notifySubscribers(Event::TransferSession::newReceiver, client);
+        broadcast(Event::TransferSession::newReceiver, SerializableEvent::NewReceiver{client->publicId(), client->name()});
     } catch (...) {
         std::list<size_t> removedChunks;
         m_buffer.removeOneFromExpectedConsumers(client->publicId(), removedChunks);
@@ -158,15 +192,17 @@ void TransferSession::removeReceiver(const std::string &publicId)
 
     // Remove from expected consumers and sanitize buffer
     std::list<size_t> removedChunks;
-    m_buffer.removeOneFromExpectedConsumers(publicId, removedChunks);
+    TransferSessionDetails::Buffer::State state;
+    m_buffer.removeOneFromExpectedConsumers(publicId, removedChunks, state);
     if (not removedChunks.empty())
     {
         std::string idxs;
         for (auto id : removedChunks) { if (!idxs.empty()) idxs += ','; idxs += std::to_string(id); }
         PLOG_INFO << "[sess=" << m_id << "] removeReceiver " << publicId
                   << " triggered sanitize of chunks [" << idxs << "]";
-        Publisher<Event::TransferSession>::notifySubscribers(Event::TransferSession::chunksWasRemoved, removedChunks);
+        broadcast(Event::TransferSession::chunksWasRemoved, SerializableEvent::ChunksRemoved{removedChunks});
     }
+    publishNewChunkAllowance(state);
 
     // Notify the removed client with an ACK-required "kicked" event;
     // the client removes itself from ClientList on ACK or fallback timer.
@@ -181,7 +217,7 @@ void TransferSession::removeReceiver(const std::string &publicId)
         removedClient.reset();
     }
 
-    Publisher<Event::TransferSession>::notifySubscribers(Event::TransferSession::receiverRemoved, publicId);
+    broadcast(Event::TransferSession::receiverRemoved, SerializableEvent::ReceiverRemoved{publicId});
 
     // Terminate when no receivers are left. Three cases:
     //
@@ -209,7 +245,7 @@ void TransferSession::removeReceiver(const std::string &publicId)
         }
         if (m_buffer.someChunksWasRemoved() or not m_buffer.initialChunksFreezing())
         {
-            if (m_buffer.eof() and m_buffer.chunkCount() == 0)
+            if (state.eof and state.chunkCount == 0)
             {
                 PLOG_INFO << "Session " << m_id << ": last receiver left after full transfer, terminating (ok)";
                 m_completeType = Event::Data::TransferSessionCompleteType::ok;
@@ -253,42 +289,35 @@ bool TransferSession::setFileInfo(const FileInfo &info)
         }
     }
 
-    Publisher<Event::TransferSession>::notifySubscribers(Event::TransferSession::fileInfoUpdated, m_fileInfo);
+    broadcast(Event::TransferSession::fileInfoUpdated, SerializableEvent::FileInfoUpdated{m_fileInfo.name, m_fileInfo.size});
 
     return true;
 }
 
-bool TransferSession::addChunk(const std::string &binaryData)
+bool TransferSession::addChunk(std::string binaryData)
 {
-    const auto oldAllowed = m_buffer.newChunkIsAllowed();
-
-    const auto newIndex = m_buffer.addChunk(binaryData);
+    TransferSessionDetails::Buffer::State state;
+    const auto newIndex = m_buffer.addChunk(std::move(binaryData), state);
     if (newIndex == 0)
     {
+        // A refused chunk may still have changed the allowance (memory budget)
+        publishNewChunkAllowance(state);
         return false;
     }
 
     PLOG_DEBUG << "[sess=" << m_id << "] addChunk -> index=" << newIndex
-               << " size=" << binaryData.size()
-               << " bufferCount=" << m_buffer.chunkCount();
+               << " size=" << state.chunkSize
+               << " bufferCount=" << state.chunkCount;
 
-    Event::Data::ChunkInfo info;
-    info.index = newIndex;
-    info.size = binaryData.size();
+    broadcast(Event::TransferSession::newChunkIsAvailable, SerializableEvent::NewChunkAvailable{newIndex, state.chunkSize});
 
-    Publisher<Event::TransferSession>::notifySubscribers(Event::TransferSession::newChunkIsAvailable, info);
-
-    const auto newAllowed = m_buffer.newChunkIsAllowed();
-    if (oldAllowed != newAllowed)
-    {
-        Publisher<Event::TransferSessionForSender>::notifySubscribers(Event::TransferSessionForSender::newChunkIsAllowed, newAllowed);
-    }
-    Publisher<Event::TransferSession>::notifySubscribers(Event::TransferSession::bytesInUpdated, m_buffer.bytesIn());
+    publishNewChunkAllowance(state);
+    m_progress ? m_progress->touch() : publishProgress();
 
     return true;
 }
 
-const std::shared_ptr<const std::vector<uint8_t>> TransferSession::getChunk(size_t index, std::shared_ptr<Client> client)
+const std::shared_ptr<const std::string> TransferSession::getChunk(size_t index, std::shared_ptr<Client> client)
 {
     if (client == nullptr)
     {
@@ -302,11 +331,7 @@ const std::shared_ptr<const std::vector<uint8_t>> TransferSession::getChunk(size
         return nullptr;
     }
 
-    Event::Data::TransferSessionDownloadInfo info;
-    info.publicId = client->publicId();
-    info.chunkId = index;
-
-    Publisher<Event::TransferSession>::notifySubscribers(Event::TransferSession::chunkDownloadStarted, info);
+    broadcast(Event::TransferSession::chunkDownloadStarted, SerializableEvent::ChunkDownload{client->publicId(), index, true});
 
     return data;
 }
@@ -332,22 +357,18 @@ void TransferSession::setChunkAsReceived(size_t index, std::shared_ptr<Client> c
         }
     }
 
-    const auto chunk = m_buffer[index];
-    if (chunk)
-    {
-        /*
-         * The size of the overhead is adjusted so that users can be informed
-         * of the practical size of the useful data (for displaying the progress bar, for example)
-         */
-        client->incrementReceived(chunk->size());
-    }
-
-    const auto oldAllowed = m_buffer.newChunkIsAllowed();
     std::list<size_t> removedChunks;
+    TransferSessionDetails::Buffer::State state;
+
+    if (not m_buffer.setChunkAsReceived(index, client->publicId(), removedChunks, state)) return;
 
-    if (not m_buffer.setChunkAsReceived(index, removedChunks)) return;
+    /*
+     * The size of the overhead is adjusted so that users can be informed
+     * of the practical size of the useful data (for displaying the progress bar, for example)
+     */
+    client->incrementReceived(state.chunkSize);
 
-    const auto newCount = m_buffer.chunkCount();
+    const auto newCount = state.chunkCount;
 
     if (not removedChunks.empty())
     {
@@ -361,7 +382,7 @@ void TransferSession::setChunkAsReceived(size_t index, std::shared_ptr<Client> c
                        << " by " << client->publicId() << " -> sanitized [" << idxs
                        << "] bufferCount=" << newCount;
         }
-        Publisher<Event::TransferSession>::notifySubscribers(Event::TransferSession::chunksWasRemoved, removedChunks);
+        broadcast(Event::TransferSession::chunksWasRemoved, SerializableEvent::ChunksRemoved{removedChunks});
     }
     else
     {
@@ -369,20 +390,12 @@ void TransferSession::setChunkAsReceived(size_t index, std::shared_ptr<Client> c
                    << " by " << client->publicId() << " (no removal, bufferCount=" << newCount << ")";
     }
 
-    const auto newAllowed = m_buffer.newChunkIsAllowed();
-    if (oldAllowed != newAllowed)
-    {
-        Publisher<Event::TransferSessionForSender>::notifySubscribers(Event::TransferSessionForSender::newChunkIsAllowed, newAllowed);
-    }
-    Publisher<Event::TransferSession>::notifySubscribers(Event::TransferSession::bytesOutUpdated, m_buffer.bytesOut());
+    publishNewChunkAllowance(state);
+    m_progress ? m_progress->touch() : publishProgress();
 
-    Event::Data::TransferSessionDownloadInfo info;
-    info.publicId = client->publicId();
-    info.chunkId = index;
+    broadcast(Event::TransferSession::chunkDownloadFinished, SerializableEvent::ChunkDownload{client->publicId(), index, false});
 
-    Publisher<Event::TransferSession>::notifySubscribers(Event::TransferSession::chunkDownloadFinished, info);
-
-    if (newCount == 0 and m_buffer.eof())
+    if (newCount == 0 and state.eof)
     {
         PLOG_INFO << "Session " << m_id << ": transfer complete";
         TransferSessionList::instanse().remove(m_id);
@@ -403,15 +416,15 @@ void TransferSession::setTimedout()
 
 void TransferSession::setEndOfFile()
 {
-    if (m_buffer.eof()) return;
-    m_buffer.setEndOfFile();
+    TransferSessionDetails::Buffer::State state;
+    if (not m_buffer.setEndOfFile(state)) return;
 
-    Publisher<Event::TransferSession>::notifySubscribers(Event::TransferSession::fileUploadFinished, nullptr);
+    broadcast(Event::TransferSession::fileUploadFinished, SerializableEvent::UploadFinished{});
 
     // If all chunks were already confirmed before EOF arrived, the completion
     // check in setChunkAsReceived would have missed (eof was false then).
     // Re-check here so the session terminates deterministically.
-    if (m_buffer.chunkCount() == 0)
+    if (state.chunkCount == 0)
     {
         PLOG_INFO << "Session " << m_id << ": transfer complete (EOF after all chunks confirmed)";
         TransferSessionList::instanse().remove(m_id);
@@ -421,7 +434,8 @@ void TransferSession::setEndOfFile()
 void TransferSession::dropInitialChunksFreeze()
 {
     std::list<size_t> removedChunks;
-    if (not m_buffer.setInitialChunksFreezingDropped(removedChunks))
+    TransferSessionDetails::Buffer::State state;
+    if (not m_buffer.setInitialChunksFreezingDropped(removedChunks, state))
     {
         return;
     }
@@ -458,16 +472,15 @@ void TransferSession::dropInitialChunksFreeze()
 
     if (not removedChunks.empty())
     {
-        Publisher<Event::TransferSession>::notifySubscribers(Event::TransferSession::chunksWasRemoved, removedChunks);
+        broadcast(Event::TransferSession::chunksWasRemoved, SerializableEvent::ChunksRemoved{removedChunks});
     }
 
-    const auto newAllowed = m_buffer.newChunkIsAllowed();
-    Publisher<Event::TransferSessionForSender>::notifySubscribers(Event::TransferSessionForSender::newChunkIsAllowed, newAllowed);
+    publishNewChunkAllowance(state, true);
 
-    Publisher<Event::TransferSession>::notifySubscribers(Event::TransferSession::chunksAreUnfrozen, nullptr);
+    broadcast(Event::TransferSession::chunksAreUnfrozen, SerializableEvent::ChunksAreUnfrozen{});
 
     // Check if transfer is already complete (all chunks confirmed during freeze)
-    if (m_buffer.chunkCount() == 0 and m_buffer.eof())
+    if (state.chunkCount == 0 and state.eof)
     {
         PLOG_INFO << "Session " << m_id << ": transfer complete (all confirmed during freeze)";
         TransferSessionList::instanse().remove(m_id);
@@ -481,43 +494,100 @@ std::chrono::seconds TransferSession::remainingUntilAutoDropInitialFreeze() cons
     return m_initialFreezeTimer->timeRemaining();
 }
 
-void TransferSession::update(Event::ClientInternal event, std::any data)
+void TransferSession::update(Event::ClientInternal event, const std::string& publicId)
 {
-    if (event == Event::ClientInternal::destroyed)
+    if (event != Event::ClientInternal::destroyed)
     {
-        try {
-            const std::string publicId = std::any_cast<std::string>(data);
-            const auto spSender = m_dataSender.lock();
-            if (spSender == nullptr or spSender->publicId() == publicId)
-            {
-                if (m_buffer.eof())
-                {
-                    // File fully uploaded. If no receivers left, terminate —
-                    // otherwise let session continue for remaining receivers.
-                    std::shared_lock lock(m_receiversMutex);
-                    if (m_dataReceivers.empty())
-                    {
-                        PLOG_INFO << "Session " << m_id << ": sender left after upload, no receivers, terminating";
-                        m_completeType = Event::Data::TransferSessionCompleteType::noReceivers;
-                        lock.unlock();
-                        TransferSessionList::instanse().remove(m_id);
-                    }
-                    return;
-                }
+        return;
+    }
 
-                PLOG_INFO << "Session " << m_id << ": sender disconnected before upload finished, terminating";
-                m_completeType = Event::Data::TransferSessionCompleteType::senderIsGone;
+    if (not m_serialized)
+    {
+        onClientDestroyed(publicId);
+        return;
+    }
+
+    // Published by the client destructor, on whichever thread released the client
+    auto self = std::static_pointer_cast<TransferSession>(Subscriber<Event::ClientInternal>::weak_from_this().lock());
+    if (self == nullptr)
+    {
+        return; // the session itself is being destroyed
+    }
+    execute([self, publicId]() { self->onClientDestroyed(publicId); });
+}
+
+void TransferSession::onClientDestroyed(const std::string& publicId)
+{
+    const auto spSender = m_dataSender.lock();
+    if (spSender == nullptr or spSender->publicId() == publicId)
+    {
+        if (m_buffer.eof())
+        {
+            // File fully uploaded. If no receivers left, terminate —
+            // otherwise let session continue for remaining receivers.
+            std::shared_lock lock(m_receiversMutex);
+            if (m_dataReceivers.empty())
+            {
+                PLOG_INFO << "Session " << m_id << ": sender left after upload, no receivers, terminating";
+                m_completeType = Event::Data::TransferSessionCompleteType::noReceivers;
+                lock.unlock();
                 TransferSessionList::instanse().remove(m_id);
-                return;
             }
-            removeReceiver(publicId);
-        } catch (const std::bad_any_cast& e) {
-            PLOG_ERROR << "TransferSession::update - Event::ClientInternal::destroyed - expected std::string: " << e.what();
             return;
         }
+
+        PLOG_INFO << "Session " << m_id << ": sender disconnected before upload finished, terminating";
+        m_completeType = Event::Data::TransferSessionCompleteType::senderIsGone;
+        TransferSessionList::instanse().remove(m_id);
+        return;
     }
-    else
+    removeReceiver(publicId);
+}
+
+void TransferSession::notifyNewChunkIsAllowed()
+{
+    publishNewChunkAllowance(m_buffer.snapshot());
+}
+
+template<typename Serializable>
+void TransferSession::broadcast(Event::TransferSession event, const Serializable& serializable)
+{
+    SerializableEvent::Frames frames {SerializableEvent::frame(serializable.json()), nullptr};
+    if constexpr (requires { serializable.binary(); })
     {
-        PLOG_WARNING << "TransferSession::update(Event::ClientInternal) unknown event";
+        // A member connecting meanwhile gets the JSON frame, which the binary protocol carries too
+        if (m_binaryMembers.load(std::memory_order_relaxed) > 0)
+        {
+            frames.binary = SerializableEvent::frame(serializable.binary());
+        }
+    }
+    Publisher<Event::TransferSession>::notifySubscribers(event, std::move(frames));
+}
+
+void TransferSession::publishProgress()
+{
+    const size_t in = m_buffer.bytesIn();
+    if (m_sentBytesIn.exchange(in) != in)
+    {
+        broadcast(Event::TransferSession::bytesInUpdated, SerializableEvent::TotalBytesCount{in, true});
+    }
+    const size_t out = m_buffer.bytesOut();
+    if (m_sentBytesOut.exchange(out) != out)
+    {
+        broadcast(Event::TransferSession::bytesOutUpdated, SerializableEvent::TotalBytesCount{out, false});
     }
 }
+
+void TransferSession::publishNewChunkAllowance(const TransferSessionDetails::Buffer::State &state, bool force)
+{
+    if (not state.newChunkIsAllowedChanged and not force)
+    {
+        return;
+    }
+
+    Event::Data::NewChunkAllowance allowance;
+    allowance.allowed = state.newChunkIsAllowed;
+    allowance.memoryBudgetExhausted = not ChunkMemoryPool::instance().budgetAvailable();
+
+    Publisher<Event::TransferSessionForSender>::notifySubscribers(Event::TransferSessionForSender::newChunkIsAllowed, allowance);
+}
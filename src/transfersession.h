@@ -5,54 +5,19 @@
 #pragma once
 
 #include "observerpattern.h"
+#include "transfersessionevents.h"
 #include "client.h"
 #include "buffer.h"
 #include "timercallback.h"
+#include "progresscoalescer.h"
+#include "optionalsharedmutex.h"
 
 #include <vector>
 #include <memory>
 #include <list>
+#include <functional>
 #include <asio.hpp>
 
-namespace Event {
-
-enum class TransferSession {
-//  Event                      Data
-    newReceiver,            // std::shared_ptr<Client>
-    receiverRemoved,        // publicId
-    fileInfoUpdated,        // FileInfo
-    chunkDownloadStarted,   // Data::TransferSessionDownloadInfo
-    chunkDownloadFinished,  // Data::TransferSessionDownloadInfo
-    newChunkIsAvailable,    // Data::ChunkInfo
-    chunksWasRemoved,       // std::list<size_t>
-    bytesInUpdated,         // size_t
-    bytesOutUpdated,        // size_t
-    chunksAreUnfrozen,      // nullptr
-    fileUploadFinished,     // nullptr
-    complete                // Data::TransferSessionCompleteType
-
-};
-enum class TransferSessionForSender {
-    newChunkIsAllowed // bool
-};
-
-namespace Data {
-enum class TransferSessionCompleteType
-{
-    ok,
-    timeout,
-    senderIsGone,
-    noReceivers
-};
-
-struct TransferSessionDownloadInfo
-{
-    std::string publicId;
-    size_t chunkId = 0;
-};
-} // namespace Data
-} // namespace Event
-
 class TransferSession : public Subscriber<Event::ClientInternal>,
                         public Publisher<Event::TransferSession>,
                         public Publisher<Event::TransferSessionForSender>
@@ -80,6 +45,18 @@ public:
 
     void initTimers(std::shared_ptr<TransferSession> me);
 
+    /*
+     * With [server] session_strand the work is queued on the session strand,
+     * otherwise it runs right away. Every entry point into a session goes
+     * through here: chunk GET/POST, join, WebSocket open and messages, the
+     * session timers, the registry lifetime timer and the memory budget
+     * notifications, and the destruction of a member (meLeave, timeouts).
+     * In that mode the receivers, the file info and the buffer are confined
+     * to the strand and their locks are not taken.
+     */
+    void execute(std::function<void()> work);
+    bool serialized() const { return m_serialized; }
+
     std::string id() const { return m_id; }
 
     const FileInfo fileInfo() const;
@@ -89,8 +66,9 @@ public:
     bool addReceiver(std::shared_ptr<Client> client);
     void removeReceiver(const std::string& publicId);
     bool setFileInfo(const FileInfo& info);
-    bool addChunk(const std::string& binaryData);
-    const std::shared_ptr<const std::vector<uint8_t>> getChunk(size_t index, std::shared_ptr<Client> client);
+    // The data is moved into the session buffer, the caller's string is left empty
+    bool addChunk(std::string binaryData);
+    const std::shared_ptr<const std::string> getChunk(size_t index, std::shared_ptr<Client> client);
     void setChunkAsReceived(size_t index, std::shared_ptr<Client> client);
     void manualTerminate();
     void setTimedout();
@@ -106,9 +84,14 @@ public:
     std::list<Event::Data::ChunkInfo> chunksInfo() { return m_buffer.chunksInfo(); }
     void dropInitialChunksFreeze();
     std::chrono::seconds remainingUntilAutoDropInitialFreeze() const;
+    // Tells the sender whether a new chunk is allowed, if it has changed since the last time
+    void notifyNewChunkIsAllowed();
+    // WebSockets of the members on the binary subprotocol, broadcast skips the binary frame without them
+    void binaryMemberConnected()        { ++m_binaryMembers; }
+    void binaryMemberDisconnected()     { --m_binaryMembers; }
 
     // Subscriber interface
-    void update(Event::ClientInternal event, std::any data) override;
+    void update(Event::ClientInternal event, const std::string& publicId) override;
 
 protected:
     // we explicit use shared_ptr only (Subscriber)
@@ -116,15 +99,32 @@ protected:
                     asio::io_context& ioContext, const Options& options);
 
 private:
+    void onClientDestroyed(const std::string& publicId);
+
+    // Serializes the event once per protocol, every member queues the same frame
+    template<typename Serializable>
+    void broadcast(Event::TransferSession event, const Serializable& serializable);
+    // Publishes the byte counters that have changed since they were last sent
+    void publishProgress();
+
+    // Unless forced, only a changed allowance is published
+    void publishNewChunkAllowance(const TransferSessionDetails::Buffer::State& state, bool force = false);
+
     std::string m_id;
+    const bool m_serialized;
     std::weak_ptr<Client> m_dataSender;
     std::list<std::weak_ptr<Client>> m_dataReceivers;
-    mutable std::shared_mutex m_fileInfoMutex;
+    mutable OptionalSharedMutex m_fileInfoMutex;
     FileInfo m_fileInfo;
     TransferSessionDetails::Buffer m_buffer;
-    mutable std::shared_mutex m_receiversMutex;
+    mutable OptionalSharedMutex m_receiversMutex;
     std::unique_ptr<TimerCallback> m_initialFreezeTimer = nullptr;
+    std::unique_ptr<ProgressCoalescer> m_progress = nullptr; // none with a 0 interval
+    std::atomic<size_t> m_sentBytesIn {0};
+    std::atomic<size_t> m_sentBytesOut {0};
+    std::atomic<size_t> m_binaryMembers {0};
     asio::io_context& m_ioContext;
+    asio::strand<asio::io_context::executor_type> m_strand;
     Options m_options;
     std::atomic<bool> m_autoDropFreezeFired {false};
 
@@ -0,0 +1,63 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#pragma once
+
+/*
+ * The events of TransferSession, apart from the class, as Client subscribes
+ * to them and its header can not include transfersession.h.
+ */
+
+#include "observerpattern.h"
+#include "serializableevent.h"
+
+namespace Event {
+
+/*
+ * The members get the same frames for all the events but "complete",
+ * so the session serializes them once and publishes them.
+ * The byte counters are rate limited by [session] progress_interval_ms,
+ * the other events go out at once.
+ */
+enum class TransferSession {
+//  Event                      Data
+    newReceiver,            // SerializableEvent::Frames (NewReceiver)
+    receiverRemoved,        // SerializableEvent::Frames (ReceiverRemoved)
+    fileInfoUpdated,        // SerializableEvent::Frames (FileInfoUpdated)
+    chunkDownloadStarted,   // SerializableEvent::Frames (ChunkDownload)
+    chunkDownloadFinished,  // SerializableEvent::Frames (ChunkDownload)
+    newChunkIsAvailable,    // SerializableEvent::Frames (NewChunkAvailable)
+    chunksWasRemoved,       // SerializableEvent::Frames (ChunksRemoved)
+    bytesInUpdated,         // SerializableEvent::Frames (TotalBytesCount), coalesced
+    bytesOutUpdated,        // SerializableEvent::Frames (TotalBytesCount), coalesced
+    chunksAreUnfrozen,      // SerializableEvent::Frames (ChunksAreUnfrozen)
+    fileUploadFinished,     // SerializableEvent::Frames (UploadFinished)
+    complete                // Data::TransferSessionCompleteType, the frame is per member (ACK id)
+};
+enum class TransferSessionForSender {
+    newChunkIsAllowed // Data::NewChunkAllowance
+};
+
+namespace Data {
+enum class TransferSessionCompleteType
+{
+    ok,
+    timeout,
+    senderIsGone,
+    noReceivers
+};
+
+struct NewChunkAllowance
+{
+    bool allowed = false;
+    bool memoryBudgetExhausted = false; // the reason when not allowed
+};
+} // namespace Data
+} // namespace Event
+
+template<> struct EventPayload<Event::TransferSession>
+{
+    using Type = std::variant<SerializableEvent::Frames, Event::Data::TransferSessionCompleteType>;
+};
+template<> struct EventPayload<Event::TransferSessionForSender> { using Type = Event::Data::NewChunkAllowance; };
@@ -7,18 +7,41 @@
 #include "observerpattern.h"
 #include "transfersession.h"
 #include "config/config.h"
+#include "executor.h"
 
 #include "log.h"
 
-#include <mutex>
+namespace {
 
-TransferSessionList::~TransferSessionList()
+// Forwards the chunk memory budget state to the senders of all sessions
+class ChunkMemoryRelay : public Subscriber<Event::ChunkMemoryPool>
 {
-    m_ioContext.stop();
-    if (m_ioContextThreadPtr && m_ioContextThreadPtr->joinable())
+public:
+    void update(Event::ChunkMemoryPool event, const std::monostate&) override
     {
-        m_ioContextThreadPtr->join();
+        if (event == Event::ChunkMemoryPool::budgetExhausted or
+            event == Event::ChunkMemoryPool::budgetAvailable)
+        {
+            m_list.notifyNewChunkIsAllowed();
+        }
+        else
+        {
+            PLOG_WARNING << "ChunkMemoryRelay::update(Event::ChunkMemoryPool) unknown event";
+        }
     }
+
+protected:
+    ChunkMemoryRelay(TransferSessionList& list) : m_list(list) {}
+
+private:
+    TransferSessionList& m_list;
+};
+
+} // namespace
+
+TransferSessionList::~TransferSessionList()
+{
+    Executor::instance().stop();
 }
 
 TransferSessionList &TransferSessionList::instanse()
@@ -32,76 +55,66 @@ TransferSessionList::SessionAndTimeout TransferSessionList::create(std::shared_p
 {
     if (creator == nullptr) return {nullptr, 0};
 
-    std::unique_lock lock (m_mutex);
-
     /*
      * The session identifier is equal to the public identifier of its creator,
      * in order to avoid difficulties in detecting attempts to create multiple
      * sessions by one client.
      */
     const std::string id = creator->publicId();
-    while (m_map.contains(id))
-    {
-        return {nullptr, 0};
-    }
 
-    auto session = createSubscriber<TransferSession>(creator, id, m_ioContext, options);
-    session->initTimers(session);
-
-    session->Publisher<Event::TransferSession>::addSubscriber(creator);
-    session->Publisher<Event::TransferSessionForSender>::addSubscriber(creator);
-    creator->Publisher<Event::ClientInternal>::addSubscriber(session);
-
-    auto [iter, _] = m_map.try_emplace(
+    SessionAndTimeout result {nullptr, 0};
+    m_map.tryEmplace(
         id,
-        SessionWithTimer {
-            session,
-            {
-                m_ioContext,
-                [this, session, id](){
-                    session->setTimedout();
-                    this->remove(id);
-                },
-                TimerCallback::Duration(Config::instance().transferSessionMaxLifetime())
-            }
+        [&]() {
+            auto session = createSubscriber<TransferSession>(creator, id, m_ioContext, options);
+            session->initTimers(session);
+
+            session->Publisher<Event::TransferSession>::addSubscriber(creator);
+            session->Publisher<Event::TransferSessionForSender>::addSubscriber(creator);
+            creator->Publisher<Event::ClientInternal>::addSubscriber(session);
+
+            return SessionWithTimer {
+                session,
+                {
+                    m_ioContext,
+                    [this, session, id](){
+                        session->execute([this, session, id]() {
+                            // Queued on the strand: the session may have completed meanwhile
+                            if (this->get(id).first != session) return;
+                            session->setTimedout();
+                            this->remove(id);
+                        });
+                    },
+                    TimerCallback::Duration(Config::instance().transferSessionMaxLifetime())
+                }
+            };
+        },
+        [&](SessionWithTimer& entry) {
+            // Started in place: the timer handler refers to this very object
+            entry.timer.start();
+            result = {entry.session, entry.timer.timeRemaining().count()};
         }
     );
 
-    if (iter == m_map.end())
-    {
-        PLOG_ERROR << "TransferSessionList::create - invalid iterator";
-        return {nullptr, 0};
-    }
-
-    auto &timer = iter->second.timer;
-    timer.start();
-
-    return {session, timer.timeRemaining().count()};
+    return result;
 }
 
 TransferSessionList::SessionAndTimeout TransferSessionList::get(const std::string &id)
 {
-    std::shared_lock lock (m_mutex);
-
-    const auto iter = m_map.find(id);
-    if (iter == m_map.end())
-    {
-        return {nullptr, 0};
-    }
-
-    return {iter->second.session, iter->second.timer.timeRemaining().count()};
+    SessionAndTimeout result {nullptr, 0};
+    m_map.visit(id, [&](const SessionWithTimer& entry) {
+        result = {entry.session, entry.timer.timeRemaining().count()};
+    });
+    return result;
 }
 
 size_t TransferSessionList::count() const
 {
-    std::shared_lock lock (m_mutex);
     return m_map.size();
 }
 
 bool TransferSessionList::possibleToCreateNew()
 {
-    std::shared_lock lock (m_mutex);
-
     return Config::instance().transferSessionCountLimit() > m_map.size();
 }
 
@@ -114,22 +127,34 @@ void TransferSessionList::remove(const std::string &id)
      */
 
     std::shared_ptr<TransferSession> session = nullptr;
-    {
-        std::unique_lock lock (m_mutex);
-        auto iter = m_map.find(id);
-        if (iter == m_map.end())
+    m_map.erase(id, [&](SessionWithTimer& entry) { session = std::move(entry.session); });
+}
+
+void TransferSessionList::notifyNewChunkIsAllowed()
+{
+    /*
+     * The memory pool publishes its state while a chunk is added or freed,
+     * that is with some session buffer locked by the calling thread.
+     * The sessions take their buffer lock to notify, so it is done later
+     * from the session thread.
+     */
+    asio::post(m_ioContext, [this]() {
+        std::vector<std::shared_ptr<TransferSession>> sessions;
+        sessions.reserve(m_map.size());
+        m_map.forEach([&](const std::string&, const SessionWithTimer& entry) {
+            sessions.push_back(entry.session);
+        });
+
+        for (const auto& session : sessions)
         {
-            return;
+            session->execute([session]() { session->notifyNewChunkIsAllowed(); });
         }
-        session = iter->second.session;
-        m_map.erase(iter);
-    }
+    });
 }
 
 TransferSessionList::TransferSessionList()
+    : m_ioContext(Executor::instance().ioContext())
 {
-    m_ioContextThreadPtr = std::make_unique<std::thread>([&]() {
-        asio::executor_work_guard<asio::io_context::executor_type> work = asio::make_work_guard(m_ioContext);
-        m_ioContext.run();
-    });
+    m_chunkMemoryRelay = createSubscriber<ChunkMemoryRelay>(*this);
+    ChunkMemoryPool::instance().addSubscriber(m_chunkMemoryRelay);
 }
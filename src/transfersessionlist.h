@@ -6,12 +6,11 @@
 
 #include "timercallback.h"
 #include "transfersession.h"
+#include "chunkmemorypool.h"
+#include "shardedmap.h"
 
 #include <string>
-#include <shared_mutex>
-#include <unordered_map>
 #include <memory>
-#include <thread>
 
 class Client;
 
@@ -32,6 +31,9 @@ public:
 
     void remove(const std::string& id);
 
+    // Every session re-evaluates whether its sender may upload (the chunk memory budget has changed), asynchronously
+    void notifyNewChunkIsAllowed();
+
 private:
     TransferSessionList();
     TransferSessionList(const TransferSessionList&) = delete;
@@ -47,9 +49,11 @@ private:
         TimerCallback timer;
     };
 
-    mutable std::shared_mutex m_mutex;
-    std::unordered_map<std::string, SessionWithTimer> m_map;
+    ShardedMap<std::string, SessionWithTimer> m_map;
+
+    // Executor::instance(), the session timers and notifications run there
+    asio::io_context& m_ioContext;
 
-    asio::io_context m_ioContext;
-    std::unique_ptr<std::thread> m_ioContextThreadPtr;
+    // Declared after the map so that it is gone before the sessions are destroyed
+    std::shared_ptr<Subscriber<Event::ChunkMemoryPool>> m_chunkMemoryRelay;
 };
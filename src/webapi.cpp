@@ -14,9 +14,36 @@
 #include "client.h"
 #include "transfersession.h"
 #include "serializableevent.h"
+#include "chunkmemorypool.h"
+#include "binaryprotocol.h"
+#include "actionscanner.h"
 
 const char CLIENT_ID_TOKEN[] = "putin";
 
+namespace {
+
+/*
+ * Runs work() on the session strand with [server] session_strand and hands its
+ * result to reply() back on the connection thread, which ends the response.
+ * Otherwise both run right away. Crow keeps the request and the response of
+ * the connection until the response is ended, so both may refer to them.
+ */
+template<typename Work, typename Reply>
+void onSession(const crow::request& req, const std::shared_ptr<TransferSession>& session, Work work, Reply reply)
+{
+    if (not session->serialized())
+    {
+        reply(work());
+        return;
+    }
+
+    session->execute([ioContext = req.io_context, work, reply]() {
+        asio::post(*ioContext, [reply, result = work()]() { reply(result); });
+    });
+}
+
+} // namespace
+
 WebAPI::WebAPI()
 {
     initRoutes();
@@ -27,7 +54,10 @@ void WebAPI::run()
     const auto& cfg = Config::instance();
     // Extra margin for encryption overhead (nonce + auth tag) and JSON framing
     m_app.websocket_max_payload(cfg.transferSessionMaxChunkSize() + 256);
-    m_app.bindaddr(cfg.bindAddress()).port(cfg.bindPort()).multithreaded().run();
+    // main() replaces 0 with the CPU count, the tests may leave it unset
+    const size_t threads = cfg.workerThreads() ? cfg.workerThreads() : std::thread::hardware_concurrency();
+    m_app.bindaddr(cfg.bindAddress()).port(cfg.bindPort())
+         .concurrency(static_cast<uint16_t>(std::min<size_t>(threads, UINT16_MAX))).run();
 }
 
 void WebAPI::stop()
@@ -63,6 +93,7 @@ void WebAPI::initRoutes()
     });
 
     CROW_WEBSOCKET_ROUTE(m_app, "/api/ws")
+        .subprotocols({BinaryProtocol::SUBPROTOCOL})
         .onaccept([&](const crow::request& req, void** userdata){
             return wsOnAccept(req, userdata);
         })
@@ -72,7 +103,7 @@ void WebAPI::initRoutes()
         .onclose([&](crow::websocket::connection& conn, const std::string& reason, uint16_t code) {
             wsOnClose(conn, reason, code);
         })
-        .onmessage([&](crow::websocket::connection& conn, const std::string& data, bool isBinary) {
+        .onmessage([&](crow::websocket::connection& conn, std::string& data, bool isBinary) {
             wsOnMessage(conn, data, isBinary);
         });
 
@@ -108,7 +139,7 @@ void WebAPI::initRoutes()
     ([this](const crow::request &req, crow::response &resp){ sessionChunkGet(req, resp); });
 
     CROW_ROUTE(m_app, "/api/session/chunk").methods("POST"_method)
-    ([this](const crow::request &req, crow::response &resp){ sessionChunkPost(req, resp); });
+    ([this](crow::request &req, crow::response &resp){ sessionChunkPost(req, resp); });
 }
 
 void WebAPI::currentStatistics(const crow::request &req, crow::response &res)
@@ -221,12 +252,20 @@ void WebAPI::identityRequest(const crow::request &req, crow::response &res)
 
     if (ClientList::instanse().count() < Config::instance().apiWithoutCaptchaThreshold())
     {
-        internalCreateClient(req, res, nameParam);
+        internalCreateClient(res, nameParam);
         return;
     }
 
-    const auto clientIdCondidate = ClientList::generateIdCondidate(req.remote_ip_address);
+    const auto clientIdCondidate = ClientList::generateIdCondidate();
     const auto captcha = Skaptcha::instance().generate( clientIdCondidate, std::chrono::seconds(Config::instance().apiCaptchaLifetime()) );
+    if (captcha == nullptr)
+    {
+        res.code = 500;
+        res.body = "Captcha is not available";
+        res.end();
+        return;
+    }
+
     crow::json::wvalue json {
         {"captcha_image", crow::utility::base64encode( captcha->png.data(), captcha->png.size() )},
         {"captcha_token", captcha->token},
@@ -349,7 +388,7 @@ void WebAPI::identityValidation(const crow::request &req, crow::response &res)
         return;
     }
 
-    internalCreateClient(req, res, name, clientId);
+    internalCreateClient(res, name, clientId);
 }
 
 void WebAPI::sessionCreate(const crow::request &req, crow::response &res)
@@ -506,62 +545,61 @@ void WebAPI::sessionJoin(const crow::request &req, crow::response &res)
         return;
     }
 
-    if (session.first->someChunkWasRemoved())
-    {
-        /*
-         * If some chunk has been deleted, that is, part of the data is lost,
-         * it is impossible to join a new user.
-         */
-
-        bool isMember = false;
-        for (const auto& received: session.first->receivers())
+    auto join = [client, session = session.first]() -> std::pair<int, std::string> {
+        if (session->someChunkWasRemoved())
         {
-            auto sp = received.lock();
-            if (sp and sp->id() == client->id())
+            /*
+             * If some chunk has been deleted, that is, part of the data is lost,
+             * it is impossible to join a new user.
+             */
+
+            bool isMember = false;
+            for (const auto& received: session->receivers())
+            {
+                auto sp = received.lock();
+                if (sp and sp->id() == client->id())
+                {
+                    isMember = true;
+                    break;
+                }
+            }
+
+            if (not isMember)
             {
-                isMember = true;
-                break;
+                return {403, "It is impossible to join the session"};
             }
         }
 
-        if (not isMember)
+        if (not session->addReceiver(client))
         {
-            res.code = 403;
-            res.body = "It is impossible to join the session";
-            res.end();
-            return;
+            PLOG_WARNING << "addReceiver failed for client " << client->publicId() << " to session " << session->id();
+            return {500, "Couldn't join the session"};
         }
-    }
-
-    if (not session.first->addReceiver(client))
-    {
-        PLOG_WARNING << "addReceiver failed for client " << client->publicId() << " to session " << session.first->id();
-        res.code = 500;
-        res.body = "Couldn't join the session";
-        res.end();
-        return;
-    }
 
-    if (not client->joinSession(session.first->id()))
-    {
-        PLOG_ERROR << "Client " << client->publicId() << " joinSession failed for " << session.first->id();
-        res.code = 500;
-        res.body = "Couldn't join the session (2)";
-        res.end();
-        return;
-    }
+        if (not client->joinSession(session->id()))
+        {
+            PLOG_ERROR << "Client " << client->publicId() << " joinSession failed for " << session->id();
+            return {500, "Couldn't join the session (2)"};
+        }
 
-    crow::json::wvalue json {
-        {"id", session.first->id()}
+        crow::json::wvalue json {
+            {"id", session->id()}
+        };
+        return {202, json.dump()};
     };
 
-    res.code = 202;
-    res.set_header("Content-Type", "application/json; charset=utf-8");
-    res.body = json.dump();
-    res.end();
+    onSession(req, session.first, join, [&res](const std::pair<int, std::string>& result) {
+        res.code = result.first;
+        if (res.code == 202)
+        {
+            res.set_header("Content-Type", "application/json; charset=utf-8");
+        }
+        res.body = result.second;
+        res.end();
+    });
 }
 
-void WebAPI::sessionChunkPost(const crow::request &req, crow::response &res)
+void WebAPI::sessionChunkPost(crow::request &req, crow::response &res)
 {
     auto& cookieCtx = m_app.get_context<crow::CookieParser>(req);
     const auto token = cookieCtx.get_cookie(CLIENT_ID_TOKEN);
@@ -610,8 +648,7 @@ void WebAPI::sessionChunkPost(const crow::request &req, crow::response &res)
         return;
     }
 
-    const auto body = req.body;
-    if (body.size() > Config::instance().transferSessionMaxChunkSize())
+    if (req.body.size() > Config::instance().transferSessionMaxChunkSize())
     {
         res.code = 400;
         res.body = "The data size exceeds the maximum allowed chunk size";
@@ -619,17 +656,23 @@ void WebAPI::sessionChunkPost(const crow::request &req, crow::response &res)
         return;
     }
 
-    if (not session.first->addChunk(body))
-    {
-        res.code = 421;
-        res.body = "Adding a chunk failed";
-        res.end();
-        return;
-    }
+    // The request body is handed over to the session buffer without copying
+    auto add = [&req, session = session.first]() {
+        return session->addChunk(std::move(req.body));
+    };
 
-    res.code = 202;
-    res.end();
-    return;
+    onSession(req, session.first, add, [&res](bool added) {
+        if (not added)
+        {
+            res.code = 421;
+            res.body = "Adding a chunk failed";
+            res.end();
+            return;
+        }
+
+        res.code = 202;
+        res.end();
+    });
 }
 
 void WebAPI::sessionChunkGet(const crow::request &req, crow::response &res)
@@ -691,26 +734,34 @@ void WebAPI::sessionChunkGet(const crow::request &req, crow::response &res)
         return;
     }
 
-    const auto chunk = session.first->getChunk(index, client);
-    if (chunk == nullptr)
-    {
-        PLOG_WARNING << "[sess=" << sessionId << "] GET chunk " << index
-                     << " -> 404 (not in buffer); client=" << client->publicId()
-                     << " currentMaxChunkIndex=" << session.first->currentMaxChunkIndex()
-                     << " someRemoved=" << session.first->someChunkWasRemoved();
-        res.code = 404;
-        res.body = "Chunk not found";
-        res.end();
-        return;
-    }
+    auto get = [sessionId, index, client, session = session.first]() {
+        auto chunk = session->getChunk(index, client);
+        if (chunk == nullptr)
+        {
+            PLOG_WARNING << "[sess=" << sessionId << "] GET chunk " << index
+                         << " -> 404 (not in buffer); client=" << client->publicId()
+                         << " currentMaxChunkIndex=" << session->currentMaxChunkIndex()
+                         << " someRemoved=" << session->someChunkWasRemoved();
+        }
+        return chunk;
+    };
 
-    PLOG_DEBUG << "[sess=" << sessionId << "] GET chunk " << index
-               << " -> 200 (" << chunk->size() << " bytes); client=" << client->publicId();
-    res.code = 200;
-    res.set_header("Content-Type", "application/octet-stream");
-    res.body = std::string(chunk->begin(), chunk->end());
-    res.end();
-    return;
+    onSession(req, session.first, get, [&res, sessionId, index, client](const std::shared_ptr<const std::string>& chunk) {
+        if (chunk == nullptr)
+        {
+            res.code = 404;
+            res.body = "Chunk not found";
+            res.end();
+            return;
+        }
+
+        PLOG_DEBUG << "[sess=" << sessionId << "] GET chunk " << index
+                   << " -> 200 (" << chunk->size() << " bytes); client=" << client->publicId();
+        res.code = 200;
+        res.set_header("Content-Type", "application/octet-stream");
+        res.shared_body = chunk;
+        res.end();
+    });
 }
 
 bool WebAPI::wsOnAccept(const crow::request &req, void **userdata)
@@ -776,9 +827,20 @@ void WebAPI::wsOnConnect(crow::websocket::connection &conn)
         conn.close("Session not found", crow::websocket::CloseStatusCode::ClosedAbnormally);
         return;
     }
+    wsWrapperPtr->joinSession(session.first);
 
+    // The snapshot of the session is taken on its strand, like any other session work
+    session.first->execute([this, ws = wsWrapperPtr->ws, client = client, session = session.first, expirationIn = session.second]() mutable {
+        internalWsStartInit(*ws, client, session, expirationIn);
+    });
+}
+
+void WebAPI::internalWsStartInit(WebSocketConnection &ws,
+                                 std::shared_ptr<Client>& client, std::shared_ptr<TransferSession>& session,
+                                 size_t expirationIn)
+{
     crow::json::wvalue receiverArray = crow::json::wvalue::list();
-    const auto receiverList = session.first->receivers();
+    const auto receiverList = session->receivers();
     size_t receiverCounter = 0;
     for (const auto& c: receiverList)
     {
@@ -793,7 +855,7 @@ void WebAPI::wsOnConnect(crow::websocket::connection &conn)
         ++receiverCounter;
     }
 
-    const auto sender = session.first->sender().lock();
+    const auto sender = session->sender().lock();
 
     crow::json::wvalue senderInfo;
     if (sender != nullptr)
@@ -810,9 +872,9 @@ void WebAPI::wsOnConnect(crow::websocket::connection &conn)
 
     const auto& cfg = Config::instance();
 
-    const auto fileInfo = session.first->fileInfo();
+    const auto fileInfo = session->fileInfo();
 
-    const auto chunksInfoList = session.first->chunksInfo();
+    const auto chunksInfoList = session->chunksInfo();
     crow::json::wvalue chunksInfo;
     size_t chunksCounter = 0;
     for (const auto& info: chunksInfoList)
@@ -824,25 +886,27 @@ void WebAPI::wsOnConnect(crow::websocket::connection &conn)
     }
 
     crow::json::wvalue json {
-        {"session_id", session.first->id()},
+        {"session_id", session->id()},
         {"limits", {
             {"max_receiver_count", cfg.transferSessionMaxConsumerCount()},
             {"max_chunk_size", cfg.transferSessionMaxChunkSize()},
             {"max_initial_freeze", cfg.transferSessionMaxInitialFreezeDuration()},
-            {"max_chunk_queue", cfg.transferSessionChunkQueueMaxSize()}
+            {"max_chunk_queue", cfg.transferSessionChunkQueueMaxSize()},
+            {"max_chunk_queue_bytes", cfg.transferSessionChunkQueueMaxBytes()}
         }},
         {"members", {
             {"receivers", receiverArray},
             {"sender", sender ? senderInfo : nullptr}
         }},
         {"state", {
-            {"current_chunk", session.first->currentMaxChunkIndex()},
-            {"upload_finished", session.first->eof()},
-            {"some_chunk_was_removed", session.first->someChunkWasRemoved()},
-            {"initial_freeze", session.first->initialChunksFreeze()},
-            {"initial_freeze_remaining", session.first->remainingUntilAutoDropInitialFreeze().count()},
+            {"current_chunk", session->currentMaxChunkIndex()},
+            {"upload_finished", session->eof()},
+            {"some_chunk_was_removed", session->someChunkWasRemoved()},
+            {"new_chunk_allowed", session->newChunkIsAllowed()},
+            {"initial_freeze", session->initialChunksFreeze()},
+            {"initial_freeze_remaining", session->remainingUntilAutoDropInitialFreeze().count()},
             {"chunks", std::move(chunksInfo)},
-            {"expiration_in", session.second},
+            {"expiration_in", expirationIn},
             {"file", {
                 {"name", fileInfo.name},
                 {"size", fileInfo.size}
@@ -850,8 +914,8 @@ void WebAPI::wsOnConnect(crow::websocket::connection &conn)
         }},
         {"transferred", {
             {"global", {
-                {"from_sender", session.first->bytesIn()},
-                {"to_receivers", session.first->bytesOut()}
+                {"from_sender", session->bytesIn()},
+                {"to_receivers", session->bytesOut()}
             }},
             {"received_by_you", client->bytesReceived()}
         }}
@@ -861,7 +925,7 @@ void WebAPI::wsOnConnect(crow::websocket::connection &conn)
     root["data"] = std::move(json);
     root["event"] = "start_init";
 
-    conn.send_text(root.dump());
+    ws.sendText(root.dump());
 }
 
 void WebAPI::wsOnClose(crow::websocket::connection &conn, const std::string& /*reason*/, uint16_t /*code*/)
@@ -872,7 +936,7 @@ void WebAPI::wsOnClose(crow::websocket::connection &conn, const std::string& /*r
     delete wsWrapperPtr;
 }
 
-void WebAPI::wsOnMessage(crow::websocket::connection &conn, const std::string &data, bool isBinary)
+void WebAPI::wsOnMessage(crow::websocket::connection &conn, std::string &data, bool isBinary)
 {
     PLOG_VERBOSE << "WS isBinary=" << isBinary << " size=" << data.size();
 
@@ -897,61 +961,185 @@ void WebAPI::wsOnMessage(crow::websocket::connection &conn, const std::string &d
         return;
     }
 
+    auto ws = wsWrapperPtr->ws;
+    const size_t size = data.size();
+
+    if (not session.first->serialized())
+    {
+        internalWsMessage(*ws, client, session.first, data, isBinary);
+    }
+    else
+    {
+        // The frame is moved into the queued work, it is processed on the session strand
+        auto message = std::make_shared<std::string>(std::move(data));
+        session.first->execute([this, ws, client, session = session.first, message, isBinary]() mutable {
+            internalWsMessage(*ws, client, session, *message, isBinary);
+        });
+    }
+
+    // Crow reads following frames into this buffer, so a full-sized chunk leaves a pooled slab in its place
+    auto& pool = ChunkMemoryPool::instance();
+    if (isBinary and size >= pool.slabSize() / 2)
+    {
+        data = pool.acquire();
+    }
+}
+
+void WebAPI::internalWsMessage(WebSocketConnection &ws,
+                               std::shared_ptr<Client>& client, std::shared_ptr<TransferSession>& session,
+                               std::string &data, bool isBinary)
+{
+    if (isBinary and ws.protocol() == WebSocketConnection::Protocol::binary and not ws.takeExpectedChunk())
+    {
+        internalWsBinaryProtocolMessage(ws, client, session, data);
+        return;
+    }
+
     if (isBinary)
     {
-        // Binary data can only be sent by the sender of the file
-        const auto sessionCreator = session.first->sender().lock();
-        if (sessionCreator == nullptr)
-        {
-            conn.close("It is impossible to verify the session creator", crow::websocket::CloseStatusCode::UnacceptableData);
-            return;
-        }
-        if (client->id() != sessionCreator->id())
-        {
-            conn.close("Only the session creator can send binary data", crow::websocket::CloseStatusCode::UnacceptableData);
-            return;
-        }
-        if (not session.first->addChunk(data))
+        wsAddChunk(ws, client, session, data);
+        return;
+    }
+
+    internalWsJsonMessage(ws, client, session, data);
+}
+
+void WebAPI::internalWsBinaryProtocolMessage(WebSocketConnection &ws,
+                                             std::shared_ptr<Client>& client, std::shared_ptr<TransferSession>& session,
+                                             std::string &data)
+{
+    BinaryProtocol::Action action;
+    if (not BinaryProtocol::parseAction(data, action))
+    {
+        ws.close("Malformed binary protocol message", crow::websocket::CloseStatusCode::UnacceptableData);
+        return;
+    }
+
+    switch (action.type)
+    {
+    case BinaryProtocol::ActionType::chunk:
+        // The chunk comes untagged in the next frame, so it is not shifted past a type byte
+        ws.expectChunk();
+        break;
+    case BinaryProtocol::ActionType::confirmChunk:
+        wsConfirmChunk(client, session, action.value);
+        break;
+    case BinaryProtocol::ActionType::getChunk:
+        wsGetChunk(ws, client, session, action.value);
+        break;
+    case BinaryProtocol::ActionType::ack:
+        client->processAck(action.value);
+        break;
+    case BinaryProtocol::ActionType::json:
+        internalWsJsonMessage(ws, client, session, action.payload);
+        break;
+    }
+}
+
+void WebAPI::internalWsJsonMessage(WebSocketConnection &ws,
+                                   std::shared_ptr<Client>& client, std::shared_ptr<TransferSession>& session,
+                                   std::string_view text)
+{
+    // The chunk confirmations, requests and acks in their usual shape skip the JSON tree
+    BinaryProtocol::Action hot;
+    if (ActionScanner::scan(text, hot))
+    {
+        switch (hot.type)
         {
-            PLOG_WARNING << "[sess=" << joinedSessionId << "] addChunk rejected (buffer full or oversized);"
-                         << " size=" << data.size()
-                         << " currentMaxChunkIndex=" << session.first->currentMaxChunkIndex();
-            conn.send_text( SerializableEvent::AddingChunkFailure{}.json() );
+        case BinaryProtocol::ActionType::confirmChunk:
+            wsConfirmChunk(client, session, hot.value);
+            break;
+        case BinaryProtocol::ActionType::getChunk:
+            wsGetChunk(ws, client, session, hot.value);
+            break;
+        case BinaryProtocol::ActionType::ack:
+            client->processAck(hot.value);
+            break;
+        default:
+            break;
         }
         return;
     }
 
     try {
-        const auto json = crow::json::load(data);
+        const auto json = crow::json::load(text.data(), text.size());
         if (! json)
         {
-            conn.close("Text messages are expected only in JSON format", crow::websocket::CloseStatusCode::UnacceptableData);
+            ws.close("Text messages are expected only in JSON format", crow::websocket::CloseStatusCode::UnacceptableData);
             return;
         }
 
         if (not json.has("action") or json["action"].t() != crow::json::type::String)
         {
-            conn.close("Invalid JSON: the 'action' string must be passed", crow::websocket::CloseStatusCode::UnacceptableData);
+            ws.close("Invalid JSON: the 'action' string must be passed", crow::websocket::CloseStatusCode::UnacceptableData);
             return;
         }
 
         if (not json.has("data") or json["data"].t() != crow::json::type::Object)
         {
-            conn.close("Invalid JSON: the 'data' object must be passed", crow::websocket::CloseStatusCode::UnacceptableData);
+            ws.close("Invalid JSON: the 'data' object must be passed", crow::websocket::CloseStatusCode::UnacceptableData);
             return;
         }
 
-        internalWsMessageProcessing(conn, client, session.first, json["action"].s(), json["data"]);
+        internalWsMessageProcessing(ws, client, session, json["action"].s(), json["data"]);
     } catch (const std::exception& e) {
-        conn.close("Exception: " + std::string(e.what()), crow::websocket::CloseStatusCode::UnacceptableData);
+        ws.close("Exception: " + std::string(e.what()), crow::websocket::CloseStatusCode::UnacceptableData);
+        return;
+    }
+}
+
+void WebAPI::wsAddChunk(WebSocketConnection &ws,
+                        std::shared_ptr<Client>& client, std::shared_ptr<TransferSession>& session,
+                        std::string &data)
+{
+    // Binary data can only be sent by the sender of the file
+    const auto sessionCreator = session->sender().lock();
+    if (sessionCreator == nullptr)
+    {
+        ws.close("It is impossible to verify the session creator", crow::websocket::CloseStatusCode::UnacceptableData);
+        return;
+    }
+    if (client->id() != sessionCreator->id())
+    {
+        ws.close("Only the session creator can send binary data", crow::websocket::CloseStatusCode::UnacceptableData);
         return;
     }
+    // The reassembled frame is handed over to the session buffer without copying
+    const size_t size = data.size();
+    if (not session->addChunk(std::move(data)))
+    {
+        PLOG_WARNING << "[sess=" << session->id() << "] addChunk rejected (buffer full or oversized);"
+                     << " size=" << size
+                     << " currentMaxChunkIndex=" << session->currentMaxChunkIndex();
+        ws.sendText( SerializableEvent::AddingChunkFailure{}.json() );
+    }
+}
+
+void WebAPI::wsGetChunk(WebSocketConnection &ws,
+                        std::shared_ptr<Client>& client, std::shared_ptr<TransferSession>& session,
+                        size_t index)
+{
+    const auto data = session->getChunk(index, client);
+    if (data == nullptr)
+    {
+        ws.sendText( SerializableEvent::GetChunkFailure{session->chunksInfo()}.json() );
+    }
+    else
+    {
+        ws.sendBinary(data);
+    }
+}
+
+void WebAPI::wsConfirmChunk(std::shared_ptr<Client>& client, std::shared_ptr<TransferSession>& session, size_t index)
+{
+    client->setCurrentChunkIndex(index);
+    session->setChunkAsReceived(index, client);
 }
 
-void WebAPI::internalCreateClient(const crow::request &req, crow::response &res, const std::string& name, const std::string& clientId)
+void WebAPI::internalCreateClient(crow::response &res, const std::string& name, const std::string& clientId)
 {
     const auto client = ClientList::instanse().create(
-            clientId.empty() ? ClientList::generateIdCondidate( req.remote_ip_address ) : clientId
+            clientId.empty() ? ClientList::generateIdCondidate() : clientId
         );
 
     if (client == nullptr)
@@ -989,7 +1177,7 @@ void WebAPI::internalCreateClient(const crow::request &req, crow::response &res,
     res.end();
 }
 
-void WebAPI::internalWsMessageProcessing(crow::websocket::connection &conn,
+void WebAPI::internalWsMessageProcessing(WebSocketConnection &ws,
                                          std::shared_ptr<Client>& client, std::shared_ptr<TransferSession>& session,
                                          const std::string& action, const crow::json::rvalue &data)
 {
@@ -1005,7 +1193,7 @@ void WebAPI::internalWsMessageProcessing(crow::websocket::connection &conn,
         const auto creatorSp = session->sender().lock();
         if (creatorSp == nullptr or creatorSp->id() != client->id())
         {
-            conn.close("Only the session creator can set the file information", crow::websocket::CloseStatusCode::UnacceptableData);
+            ws.close("Only the session creator can set the file information", crow::websocket::CloseStatusCode::UnacceptableData);
             return;
         }
 
@@ -1014,7 +1202,7 @@ void WebAPI::internalWsMessageProcessing(crow::websocket::connection &conn,
 
         if (not session->setFileInfo({name, size}))
         {
-            conn.send_text( SerializableEvent::SetFileInfoFailure{}.json() );
+            ws.sendText( SerializableEvent::SetFileInfoFailure{}.json() );
         }
         return;
     }
@@ -1023,7 +1211,7 @@ void WebAPI::internalWsMessageProcessing(crow::websocket::connection &conn,
         const auto creatorSp = session->sender().lock();
         if (creatorSp == nullptr or creatorSp->id() != client->id())
         {
-            conn.close("Only the session creator can set the upload finish", crow::websocket::CloseStatusCode::UnacceptableData);
+            ws.close("Only the session creator can set the upload finish", crow::websocket::CloseStatusCode::UnacceptableData);
             return;
         }
 
@@ -1034,14 +1222,14 @@ void WebAPI::internalWsMessageProcessing(crow::websocket::connection &conn,
         const auto creatorSp = session->sender().lock();
         if (creatorSp == nullptr or creatorSp->id() != client->id())
         {
-            conn.close("Only the session creator can delete participants", crow::websocket::CloseStatusCode::UnacceptableData);
+            ws.close("Only the session creator can delete participants", crow::websocket::CloseStatusCode::UnacceptableData);
             return;
         }
 
         const std::string publicId = data["id"].s();
         if (client->publicId() == publicId)
         {
-            conn.close("You can't delete yourself", crow::websocket::CloseStatusCode::UnacceptableData);
+            ws.close("You can't delete yourself", crow::websocket::CloseStatusCode::UnacceptableData);
             return;
         }
 
@@ -1052,7 +1240,7 @@ void WebAPI::internalWsMessageProcessing(crow::websocket::connection &conn,
         const auto creatorSp = session->sender().lock();
         if (creatorSp == nullptr or creatorSp->id() != client->id())
         {
-            conn.close("Only the creator of the session can forcibly terminate it", crow::websocket::CloseStatusCode::UnacceptableData);
+            ws.close("Only the creator of the session can forcibly terminate it", crow::websocket::CloseStatusCode::UnacceptableData);
             return;
         }
 
@@ -1075,22 +1263,11 @@ void WebAPI::internalWsMessageProcessing(crow::websocket::connection &conn,
     }
     else if (action == "get_chunk")
     {
-        const size_t chunkId = data["index"].u();
-        const auto data = session->getChunk(chunkId, client);
-        if (data == nullptr)
-        {
-            conn.send_text( SerializableEvent::GetChunkFailure{session->chunksInfo()}.json() );
-        }
-        else
-        {
-            conn.send_binary( {data->begin(), data->end()} );
-        }
+        wsGetChunk(ws, client, session, data["index"].u());
     }
     else if (action == "confirm_chunk")
     {
-        const size_t chunkId = data["index"].u();
-        client->setCurrentChunkIndex(chunkId);
-        session->setChunkAsReceived(chunkId, client);
+        wsConfirmChunk(client, session, data["index"].u());
     }
     else if (action == "ack")
     {
@@ -1106,6 +1283,6 @@ void WebAPI::internalWsMessageProcessing(crow::websocket::connection &conn,
     }
     else
     {
-        conn.send_text( SerializableEvent::UnknownAction{action}.json() );
+        ws.sendText( SerializableEvent::UnknownAction{action}.json() );
     }
 }
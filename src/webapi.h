@@ -52,20 +52,50 @@ private:
     void identityValidation(const crow::request& req, crow::response& res);
     void sessionCreate(const crow::request& req, crow::response& res);
     void sessionJoin(const crow::request& req, crow::response& res);
-    void sessionChunkPost(const crow::request& req, crow::response& res);
+    void sessionChunkPost(crow::request& req, crow::response& res);
     void sessionChunkGet(const crow::request& req, crow::response& res);
 
     bool wsOnAccept(const crow::request& req, void** userdata);
     void wsOnConnect(crow::websocket::connection& conn);
     void wsOnClose(crow::websocket::connection& conn, const std::string& reason, uint16_t code);
-    void wsOnMessage(crow::websocket::connection& conn, const std::string& data, bool isBinary);
+    void wsOnMessage(crow::websocket::connection& conn, std::string& data, bool isBinary);
 
-    void internalCreateClient(const crow::request& req, crow::response& res, const std::string& name, const std::string& clientId = std::string());
-    void internalWsMessageProcessing(crow::websocket::connection &conn,
+    void internalCreateClient(crow::response& res, const std::string& name, const std::string& clientId = std::string());
+    // The start_init event, on the session strand with [server] session_strand
+    void internalWsStartInit(WebSocketConnection& ws,
+                             std::shared_ptr<Client>& client,
+                             std::shared_ptr<TransferSession>& session,
+                             size_t expirationIn);
+    // Runs through TransferSession::execute(), so it replies via the wrapper rather than the Crow connection
+    void internalWsMessage(WebSocketConnection& ws,
+                           std::shared_ptr<Client>& client,
+                           std::shared_ptr<TransferSession>& session,
+                           std::string& data, bool isBinary);
+    // A binary frame of the binary subprotocol, see BinaryProtocol
+    void internalWsBinaryProtocolMessage(WebSocketConnection& ws,
+                                         std::shared_ptr<Client>& client,
+                                         std::shared_ptr<TransferSession>& session,
+                                         std::string& data);
+    void internalWsJsonMessage(WebSocketConnection& ws,
+                               std::shared_ptr<Client>& client,
+                               std::shared_ptr<TransferSession>& session,
+                               std::string_view text);
+    void internalWsMessageProcessing(WebSocketConnection& ws,
                                      std::shared_ptr<Client>& client,
                                      std::shared_ptr<TransferSession>& session,
                                      const std::string& action,
                                      const crow::json::rvalue &data);
 
+    // The actions both protocols share
+    void wsAddChunk(WebSocketConnection& ws,
+                    std::shared_ptr<Client>& client,
+                    std::shared_ptr<TransferSession>& session,
+                    std::string& data);
+    void wsGetChunk(WebSocketConnection& ws,
+                    std::shared_ptr<Client>& client,
+                    std::shared_ptr<TransferSession>& session,
+                    size_t index);
+    void wsConfirmChunk(std::shared_ptr<Client>& client, std::shared_ptr<TransferSession>& session, size_t index);
+
     crow::App<crow::CookieParser, WebAPIDetails::XForwardedFor> m_app;
 };
@@ -3,7 +3,9 @@
 // For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
 
 #include "websocketconnection.h"
+#include "binaryprotocol.h"
 #include "client.h"
+#include "transfersession.h"
 #include "log.h"
 
 WebSocketConnection::~WebSocketConnection()
@@ -14,40 +16,119 @@ WebSocketConnection::~WebSocketConnection()
     }
 }
 
+void WebSocketConnection::sendEvent(const SerializableEvent::Frames &frames)
+{
+    if (m_protocol == Protocol::binary and frames.binary)
+    {
+        sendFrame(frames.binary);
+    }
+    else
+    {
+        sendText(frames.json);
+    }
+}
+
 void WebSocketConnection::sendText(const std::string &string)
 {
-    if (!m_connection)
+    if (m_protocol == Protocol::binary)
+    {
+        sendText(std::make_shared<const std::string>(string));
+        return;
+    }
+
+    auto connection = m_connection.load();
+    if (!connection)
+    {
+        PLOG_WARNING << "WebSocketConnection::sendText: connection is nullptr";
+        return;
+    }
+    connection->send_text(string);
+}
+
+void WebSocketConnection::sendText(std::shared_ptr<const std::string> string)
+{
+    auto connection = m_connection.load();
+    if (!connection)
     {
         PLOG_WARNING << "WebSocketConnection::sendText: connection is nullptr";
         return;
     }
-    m_connection->send_text(string);
+    if (m_protocol == Protocol::binary)
+    {
+        connection->send_binary(BinaryProtocol::header(BinaryProtocol::EventType::json), std::move(string));
+        return;
+    }
+    connection->send_text(std::move(string));
 }
 
 void WebSocketConnection::sendBinary(const std::string &binary)
 {
-    if (!m_connection)
+    if (m_protocol == Protocol::binary)
+    {
+        sendBinary(std::make_shared<const std::string>(binary));
+        return;
+    }
+
+    auto connection = m_connection.load();
+    if (!connection)
     {
         PLOG_WARNING << "WebSocketConnection::sendBinary: connection is nullptr";
         return;
     }
-    m_connection->send_binary(binary);
+    connection->send_binary(binary);
 }
 
-void WebSocketConnection::close()
+void WebSocketConnection::sendBinary(std::shared_ptr<const std::string> binary)
 {
-    if (!m_connection)
+    auto connection = m_connection.load();
+    if (!connection)
+    {
+        PLOG_WARNING << "WebSocketConnection::sendBinary: connection is nullptr";
+        return;
+    }
+    if (m_protocol == Protocol::binary)
+    {
+        connection->send_binary(BinaryProtocol::header(BinaryProtocol::EventType::chunk), std::move(binary));
+        return;
+    }
+    connection->send_binary(std::move(binary));
+}
+
+void WebSocketConnection::sendFrame(std::shared_ptr<const std::string> message)
+{
+    auto connection = m_connection.load();
+    if (!connection)
+    {
+        PLOG_WARNING << "WebSocketConnection::sendFrame: connection is nullptr";
+        return;
+    }
+    connection->send_binary(std::move(message));
+}
+
+void WebSocketConnection::close(const std::string &reason, uint16_t code)
+{
+    auto connection = m_connection.load();
+    if (!connection)
     {
         PLOG_WARNING << "WebSocketConnection::close: connection is nullptr";
         return;
     }
-    m_connection->close();
+    connection->close(reason, code);
 }
 
-WebSocketConnectionDetails::WebSocketConnectionRAIIWrapper::~WebSocketConnectionRAIIWrapper() = default;
+WebSocketConnectionDetails::WebSocketConnectionRAIIWrapper::~WebSocketConnectionRAIIWrapper()
+{
+    ws->m_connection = nullptr;
+    if (auto session = m_binaryMemberOf.lock())
+    {
+        session->binaryMemberDisconnected();
+    }
+}
 
 void WebSocketConnectionDetails::WebSocketConnectionRAIIWrapper::setConnection(crow::websocket::connection &conn)
 {
+    ws->m_protocol = conn.get_subprotocol() == BinaryProtocol::SUBPROTOCOL ? WebSocketConnection::Protocol::binary
+                                                                           : WebSocketConnection::Protocol::json;
     ws->m_connection = &conn;
 
     if (auto sp = ws->m_client.lock())
@@ -55,3 +136,13 @@ void WebSocketConnectionDetails::WebSocketConnectionRAIIWrapper::setConnection(c
         sp->onWebSocketConnected(ws);
     }
 }
+
+void WebSocketConnectionDetails::WebSocketConnectionRAIIWrapper::joinSession(std::shared_ptr<TransferSession> session)
+{
+    if (ws->m_protocol != WebSocketConnection::Protocol::binary or not m_binaryMemberOf.expired())
+    {
+        return;
+    }
+    m_binaryMemberOf = session;
+    session->binaryMemberConnected();
+}
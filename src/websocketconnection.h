@@ -5,8 +5,13 @@
 #pragma once
 
 #include "crowlib/crow/websocket.h"
+#include "serializableevent.h"
+
+#include <atomic>
+#include <utility>
 
 class Client;
+class TransferSession;
 
 namespace WebSocketConnectionDetails {
 class WebSocketConnectionRAIIWrapper;
@@ -16,18 +21,61 @@ class WebSocketConnection
 {
     friend WebSocketConnectionDetails::WebSocketConnectionRAIIWrapper;
 public:
+    /*
+     * Negotiated by Sec-WebSocket-Protocol. With the binary protocol
+     * (see BinaryProtocol) the text frames are sent as binary JSON messages
+     * and the binary ones as chunk messages, the callers need not care.
+     */
+    enum class Protocol
+    {
+        json,
+        binary
+    };
+
     ~WebSocketConnection();
 
+    Protocol protocol() const { return m_protocol; }
+    // Binary protocol: a chunk action makes the next binary frame a bare chunk
+    void expectChunk() { m_chunkExpected = true; }
+    bool takeExpectedChunk() { return std::exchange(m_chunkExpected, false); }
+
+    // The binary form of the event when the protocol is binary and it has one, JSON otherwise
+    template<typename Serializable>
+    void sendEvent(const Serializable& event)
+    {
+        if constexpr (requires { event.binary(); })
+        {
+            if (m_protocol == Protocol::binary)
+            {
+                sendFrame(std::make_shared<const std::string>(event.binary()));
+                return;
+            }
+        }
+        sendText(event.json());
+    }
+    void sendEvent(const SerializableEvent::Frames& frames);
+
     void sendText(const std::string& string);
+    // The buffer is shared with the socket until written, one frame may go to many sockets
+    void sendText(std::shared_ptr<const std::string> string);
     void sendBinary(const std::string& binary);
-    void close();
+    // The buffer is shared with the socket until written, it is not copied
+    void sendBinary(std::shared_ptr<const std::string> binary);
+    void close(const std::string& reason = "quit",
+               uint16_t code = crow::websocket::CloseStatusCode::NormalClosure);
 
 private:
     WebSocketConnection(std::shared_ptr<Client> client)
         : m_client(client) {}
 
-    crow::websocket::connection* m_connection = nullptr;
+    // A complete binary protocol message, sent as is
+    void sendFrame(std::shared_ptr<const std::string> message);
+
+    // Reset when Crow closes the connection: events published from other threads may still hold this object
+    std::atomic<crow::websocket::connection*> m_connection {nullptr};
     std::weak_ptr<Client> m_client;
+    Protocol m_protocol = Protocol::json; // set before the connection is published
+    bool m_chunkExpected = false; // the messages of the connection are handled one at a time, in order
 };
 
 namespace WebSocketConnectionDetails {
@@ -45,6 +93,11 @@ struct WebSocketConnectionRAIIWrapper
 
     std::weak_ptr<Client> client() { return ws->m_client; }
     void setConnection(crow::websocket::connection& conn);
+    // Counts a binary protocol connection in the session's binary members until the wrapper is deleted
+    void joinSession(std::shared_ptr<TransferSession> session);
+
+private:
+    std::weak_ptr<TransferSession> m_binaryMemberOf;
 };
 } // namespace WebSocketConnectionDetails
 
@@ -0,0 +1,74 @@
+// Benchmark: decoding the actions a receiver sends for every chunk
+//
+// get_chunk, confirm_chunk and the acks go through crow::json::load, the
+// "action"/"data" checks and data["index"].u() on the generic path, this
+// compares it with ActionScanner on the same frames.
+// Usage: bench_actions [messages]
+
+#include "actionscanner.h"
+#include "crowlib/crow/json.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+uint64_t generic(const std::string& text)
+{
+    const auto json = crow::json::load(text);
+    if (!json or not json.has("action") or json["action"].t() != crow::json::type::String or
+        not json.has("data") or json["data"].t() != crow::json::type::Object) {
+        return 0;
+    }
+    const std::string action = json["action"].s();
+    const auto& data = json["data"];
+    if (action == "ack") {
+        return data.has("id") ? data["id"].u() : 0;
+    }
+    return data["index"].u();
+}
+
+uint64_t scanned(const std::string& text)
+{
+    BinaryProtocol::Action action;
+    return ActionScanner::scan(text, action) ? action.value : 0;
+}
+
+template<typename Decode>
+void run(const char* name, size_t count, const std::vector<std::string>& messages, Decode decode)
+{
+    uint64_t sum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        sum += decode(messages[i % messages.size()]);
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("%-8s %8.1f ns/message  (checksum %llu)\n", name, elapsed.count() / count,
+                static_cast<unsigned long long>(sum));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    if (count == 0) {
+        std::fprintf(stderr, "Usage: %s [messages > 0]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> messages;
+    for (size_t chunk = 1; chunk <= 64; ++chunk) {
+        const std::string index = std::to_string(chunk * 37);
+        messages.push_back(R"({"action":"get_chunk","data":{"index":)" + index + "}}");
+        messages.push_back(R"({"action":"confirm_chunk","data":{"index":)" + index + "}}");
+    }
+    messages.push_back(R"({"action":"ack","data":{"id":17}})");
+
+    run("crow", count, messages, generic);
+    run("scanner", count, messages, scanned);
+    return 0;
+}
@@ -0,0 +1,105 @@
+// Benchmark: captcha PNG size against encoding time
+//
+// Compares lodepng with the settings generate_captcha() used before,
+// lodepng with a fixed filter and the specialized captcha encoder.
+// Usage: bench_captcha_png [captcha count]
+
+#include "captcha/skaptcha_backend/captcha.h"
+#include "captcha/skaptcha_backend/captcha_png.h"
+
+extern "C" {
+#include "captcha/skaptcha_backend/lodepng.h"
+}
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Bitmap
+{
+    std::vector<unsigned char> pixels;
+    unsigned width = 0;
+    unsigned height = 0;
+};
+
+using Encoder = std::function<size_t(const Bitmap&)>;
+
+size_t encodeLodepng(const Bitmap& bitmap, bool fixedFilter)
+{
+    LodePNGState state;
+    lodepng_state_init(&state);
+    state.info_png.color.colortype = LCT_GREY;
+    state.info_png.color.bitdepth = 8;
+    state.info_raw.colortype = LCT_GREY;
+    state.info_raw.bitdepth = 8;
+    state.encoder.auto_convert = 0;
+    if (fixedFilter) {
+        state.encoder.filter_strategy = LFS_ZERO;
+    }
+
+    unsigned char* png = nullptr;
+    size_t size = 0;
+    lodepng_encode(&png, &size, bitmap.pixels.data(), bitmap.width, bitmap.height, &state);
+    lodepng_state_cleanup(&state);
+    free(png);
+    return size;
+}
+
+size_t encodeCaptchaPng(const Bitmap& bitmap)
+{
+    size_t size = 0;
+    free(captcha_png_encode(bitmap.pixels.data(), bitmap.width, bitmap.height, &size));
+    return size;
+}
+
+void run(const char* name, const std::vector<Bitmap>& bitmaps, const Encoder& encode)
+{
+    size_t bytes = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (const auto& bitmap : bitmaps) {
+        bytes += encode(bitmap);
+    }
+    const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+    const size_t png = bytes / bitmaps.size();
+    std::printf("%-22s %7zu B  %7zu B base64  %8.1f us/captcha\n",
+                name, png, (png + 2) / 3 * 4, elapsed.count() / bitmaps.size());
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500;
+    if (count == 0 or captcha_init() != 0) {
+        std::fprintf(stderr, "Usage: %s [captcha count > 0]\n", argv[0]);
+        return 1;
+    }
+
+    // The composed bitmaps, taken back out of generated captchas
+    std::vector<Bitmap> bitmaps(count);
+    for (auto& bitmap : bitmaps) {
+        char* img = nullptr;
+        int size = 0;
+        char answer[CAPTCHA_STRING_LENGTH + 1];
+        generate_captcha(&img, &size, answer);
+
+        unsigned char* pixels = nullptr;
+        lodepng_decode_memory(&pixels, &bitmap.width, &bitmap.height,
+                              reinterpret_cast<unsigned char*>(img), size, LCT_GREY, 8);
+        bitmap.pixels.assign(pixels, pixels + bitmap.width * bitmap.height);
+        free(pixels);
+        free(img);
+    }
+
+    std::printf("%zu captchas of %ux%u\n", count, bitmaps[0].width, bitmaps[0].height);
+    run("lodepng (default)", bitmaps, [](const Bitmap& b) { return encodeLodepng(b, false); });
+    run("lodepng (no filter)", bitmaps, [](const Bitmap& b) { return encodeLodepng(b, true); });
+    run("captcha_png_encode", bitmaps, encodeCaptchaPng);
+    return 0;
+}
@@ -0,0 +1,94 @@
+// Benchmark: serializing the events sent for every chunk
+//
+// A chunk produces new_chunk, chunk_download started/finished, bytes_count
+// in and out and personal_received. They used to be built as a
+// crow::json::wvalue tree and dumped, that code is reproduced here and
+// compared with SerializableEvent, which writes them with JsonWriter.
+// Usage: bench_events [chunks]
+
+#include "serializableevent.h"
+#include "crowlib/crow/json.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+size_t wvalueChunkEvents(size_t chunk, const std::string& publicId)
+{
+    size_t bytes = 0;
+    {
+        crow::json::wvalue root = {
+            {"event", "new_chunk"},
+            {"data", {{"index", chunk}, {"size", size_t(1048576)}}}
+        };
+        bytes += root.dump().size();
+    }
+    for (bool started : {true, false}) {
+        crow::json::wvalue root = {
+            {"event", "chunk_download"},
+            {"data", {{"id", publicId}, {"index", chunk}, {"action", started ? "started" : "finished"}}}
+        };
+        bytes += root.dump().size();
+    }
+    for (bool in : {true, false}) {
+        crow::json::wvalue root = {
+            {"event", "bytes_count"},
+            {"data", {{"value", chunk * 1048576}, {"direction", in ? "from_sender" : "to_receivers"}}}
+        };
+        bytes += root.dump().size();
+    }
+    {
+        crow::json::wvalue root = {
+            {"event", "personal_received"},
+            {"data", {{"bytes", chunk * 1048576}}}
+        };
+        bytes += root.dump().size();
+    }
+    return bytes;
+}
+
+size_t writerChunkEvents(size_t chunk, const std::string& publicId)
+{
+    using namespace SerializableEvent;
+
+    size_t bytes = NewChunkAvailable{chunk, 1048576}.json().size();
+    for (bool started : {true, false}) {
+        bytes += ChunkDownload{publicId, chunk, started}.json().size();
+    }
+    for (bool in : {true, false}) {
+        bytes += TotalBytesCount{chunk * 1048576, in}.json().size();
+    }
+    bytes += PersonalReceivedUpdated{chunk * 1048576}.json().size();
+    return bytes;
+}
+
+template<typename Events>
+void run(const char* name, size_t chunks, Events events)
+{
+    const std::string publicId(43, 'p');
+    size_t bytes = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t chunk = 0; chunk < chunks; ++chunk) {
+        bytes += events(chunk, publicId);
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("%-10s %8.1f ns/chunk  (%zu bytes)\n", name, elapsed.count() / chunks, bytes);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t chunks = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    if (chunks == 0) {
+        std::fprintf(stderr, "Usage: %s [chunks > 0]\n", argv[0]);
+        return 1;
+    }
+
+    run("wvalue", chunks, wvalueChunkEvents);
+    run("JsonWriter", chunks, writerChunkEvents);
+    return 0;
+}
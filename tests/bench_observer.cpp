@@ -0,0 +1,178 @@
+// Benchmark: the cost of one notification to the members of a session
+//
+// The publisher as it was (std::any payload copied for every subscriber,
+// a unique lock and a fresh vector per notify, any_cast in a try block in
+// every update) is reproduced here and compared with Publisher and its
+// typed payloads. The frame case is what every chunk event sends, the
+// list case a payload bigger than the std::any small buffer.
+// Usage: bench_observer [notifications] [subscribers]
+
+#include "observerpattern.h"
+#include "serializableevent.h"
+
+#include <algorithm>
+#include <any>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace {
+
+enum class BenchEvent { frame, list };
+
+using ListPayload = std::list<size_t>;
+
+} // namespace
+
+template<> struct EventPayload<BenchEvent>
+{
+    using Type = std::variant<SerializableEvent::Frame, ListPayload>;
+};
+
+namespace {
+
+// ---- before ----------------------------------------------------------------
+
+class AnySubscriber
+{
+public:
+    void update(BenchEvent event, std::any data)
+    {
+        try {
+            if (event == BenchEvent::frame) {
+                sum += std::any_cast<SerializableEvent::Frame>(data)->size();
+            } else {
+                sum += std::any_cast<ListPayload>(data).size();
+            }
+        } catch (const std::bad_any_cast&) {
+        }
+    }
+    size_t sum = 0;
+};
+
+class AnyPublisher
+{
+public:
+    void addSubscriber(std::shared_ptr<AnySubscriber> subscriber)
+    {
+        std::unique_lock lock(m_mutex);
+        m_subscribers.push_back(subscriber);
+    }
+
+    void notifySubscribers(BenchEvent event, std::any data)
+    {
+        std::vector<std::shared_ptr<AnySubscriber>> valid;
+        {
+            std::unique_lock lock(m_mutex);
+            m_subscribers.erase(
+                std::remove_if(m_subscribers.begin(), m_subscribers.end(),
+                               [&valid](const std::weak_ptr<AnySubscriber>& wp) {
+                                   if (auto sp = wp.lock()) {
+                                       valid.push_back(sp);
+                                       return false;
+                                   }
+                                   return true;
+                               }),
+                m_subscribers.end());
+        }
+        for (auto& subscriber : valid) {
+            subscriber->update(event, data);
+        }
+    }
+
+private:
+    std::shared_mutex m_mutex;
+    std::vector<std::weak_ptr<AnySubscriber>> m_subscribers;
+};
+
+// ---- after -----------------------------------------------------------------
+
+class TypedSubscriber : public Subscriber<BenchEvent>
+{
+public:
+    void update(BenchEvent, const Payload& data) override
+    {
+        if (const auto* frame = std::get_if<SerializableEvent::Frame>(&data)) {
+            sum += (*frame)->size();
+        } else if (const auto* list = std::get_if<ListPayload>(&data)) {
+            sum += list->size();
+        }
+    }
+    size_t sum = 0;
+
+protected:
+    TypedSubscriber() = default;
+};
+
+class TypedPublisher : public Publisher<BenchEvent>
+{
+public:
+    using Publisher<BenchEvent>::addSubscriber;
+    using Publisher<BenchEvent>::notifySubscribers;
+};
+
+template<typename Notify>
+void run(const char* name, size_t notifications, Notify notify)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < notifications; ++i) {
+        notify(i);
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("%-28s %8.1f ns/notify\n", name, elapsed.count() / notifications);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t notifications = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    const size_t subscriberCount = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 8;
+    if (notifications == 0) {
+        std::fprintf(stderr, "Usage: %s [notifications > 0] [subscribers]\n", argv[0]);
+        return 1;
+    }
+    std::printf("%zu notifications, %zu subscriber(s)\n", notifications, subscriberCount);
+
+    AnyPublisher anyPublisher;
+    std::vector<std::shared_ptr<AnySubscriber>> anySubscribers;
+    TypedPublisher typedPublisher;
+    std::vector<std::shared_ptr<TypedSubscriber>> typedSubscribers;
+    for (size_t i = 0; i < subscriberCount; ++i) {
+        anySubscribers.push_back(std::make_shared<AnySubscriber>());
+        anyPublisher.addSubscriber(anySubscribers.back());
+        typedSubscribers.push_back(createSubscriber<TypedSubscriber>());
+        typedPublisher.addSubscriber(typedSubscribers.back());
+    }
+
+    const auto frame = SerializableEvent::frame(std::string(64, 'x'));
+    const ListPayload list {1, 2, 3, 4};
+
+    run("before: any, frame", notifications, [&](size_t) {
+        anyPublisher.notifySubscribers(BenchEvent::frame, frame);
+    });
+    run("after:  typed, frame", notifications, [&](size_t) {
+        typedPublisher.notifySubscribers(BenchEvent::frame, frame);
+    });
+    run("before: any, list", notifications / 4, [&](size_t) {
+        anyPublisher.notifySubscribers(BenchEvent::list, list);
+    });
+    run("after:  typed, list", notifications / 4, [&](size_t) {
+        typedPublisher.notifySubscribers(BenchEvent::list, list);
+    });
+
+    // keeps the updates from being optimized away
+    size_t sum = 0;
+    for (size_t i = 0; i < subscriberCount; ++i) {
+        sum += anySubscribers[i]->sum + typedSubscribers[i]->sum;
+    }
+    std::printf("(checksum %zu)\n", sum);
+    return 0;
+}
@@ -0,0 +1,131 @@
+// Benchmark: the per-thread ChaCha20 generator against the random sources it replaced
+//
+// Each case produces what one of the call sites needs: a 12-byte token nonce,
+// a 12-byte client id and the 6 letters of a captcha answer. The old code
+// is reproduced here as it was: random_device + mt19937 per call, mt19937_64
+// seeded from a hash of the IP and the time, and rand() behind a mutex.
+// Usage: bench_random [iterations per thread] [threads]
+
+#include "captcha/chacha20_backend/chacha20_drbg.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const size_t NONCE_SIZE = 12;
+const size_t ID_SIZE = 12;
+const unsigned ANSWER_LENGTH = 6;
+const unsigned LETTER_COUNT = 33;
+
+using Case = std::function<unsigned()>;
+
+unsigned oldNonce()
+{
+    std::string result(NONCE_SIZE, '\0');
+    std::random_device rd;
+    std::mt19937 generator(rd());
+    std::uniform_int_distribution<> distribution(0, 255);
+    for (auto& ch : result) {
+        ch = static_cast<char>(distribution(generator));
+    }
+    return static_cast<unsigned char>(result[0]);
+}
+
+unsigned oldId()
+{
+    const auto timestamp = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    const size_t seedHash = std::hash<std::string>()("192.168.100.200" + std::to_string(timestamp));
+    std::mt19937_64 generator(seedHash);
+    std::uniform_int_distribution<uint16_t> distribution(0, 255);
+    std::string result(ID_SIZE, '\0');
+    for (auto& ch : result) {
+        ch = static_cast<char>(distribution(generator));
+    }
+    return static_cast<unsigned char>(result[0]);
+}
+
+std::mutex randMutex;
+
+unsigned oldAnswer()
+{
+    std::lock_guard lock (randMutex);
+    unsigned sum = 0;
+    for (unsigned i = 0; i < ANSWER_LENGTH; ++i) {
+        sum += rand() % LETTER_COUNT;
+    }
+    return sum;
+}
+
+unsigned drbgBytes(size_t size)
+{
+    std::string result(size, '\0');
+    chacha20_drbg_fill(result.data(), size);
+    return static_cast<unsigned char>(result[0]);
+}
+
+unsigned drbgAnswer()
+{
+    unsigned sum = 0;
+    for (unsigned i = 0; i < ANSWER_LENGTH; ++i) {
+        sum += chacha20_drbg_uniform(LETTER_COUNT);
+    }
+    return sum;
+}
+
+void run(const char* name, size_t iterations, unsigned threads, const Case& call)
+{
+    std::vector<std::thread> workers;
+    std::vector<unsigned> sinks(threads);
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            for (size_t i = 0; i < iterations; ++i) {
+                sinks[t] += call();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+    unsigned sink = 0;
+    for (auto value : sinks) {
+        sink += value;
+    }
+    std::printf("%-28s %2u thread(s) %10.1f ns/call  (%u)\n",
+                name, threads, elapsed.count() / iterations, sink & 0xf);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    const unsigned threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : std::thread::hardware_concurrency();
+    if (iterations == 0 or threads == 0) {
+        std::fprintf(stderr, "Usage: %s [iterations per thread > 0] [threads > 0]\n", argv[0]);
+        return 1;
+    }
+
+    for (unsigned count : {1u, threads}) {
+        run("nonce: random_device+mt19937", iterations, count, oldNonce);
+        run("nonce: chacha20_drbg", iterations, count, []() { return drbgBytes(NONCE_SIZE); });
+        run("id: hash+mt19937_64", iterations, count, oldId);
+        run("id: chacha20_drbg", iterations, count, []() { return drbgBytes(ID_SIZE); });
+        run("answer: rand()+mutex", iterations, count, oldAnswer);
+        run("answer: chacha20_drbg", iterations, count, drbgAnswer);
+        if (threads == 1) {
+            break;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,179 @@
+// Benchmark: registry lookups under contention
+//
+// Many threads do what the HTTP and WebSocket handlers do to the client and
+// session registries: mostly lookups, with some creations and removals.
+// The single shared_mutex map the registries used before is compared with
+// ShardedMap, then the real ClientList is run with the same mix.
+// Usage: bench_registry [operations per thread] [threads] [lookups per write]
+
+#include "log.h"
+#include <plog/Appenders/ConsoleAppender.h>
+
+#include "shardedmap.h"
+#include "clientlist.h"
+#include "client.h"
+#include "config/config.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const size_t KEY_COUNT = 4096;
+
+struct Operations
+{
+    std::function<bool(const std::string&)> get;
+    std::function<void(const std::string&)> create;
+    std::function<void(const std::string&)> remove;
+};
+
+class SingleLockMap
+{
+public:
+    bool get(const std::string& key) const
+    {
+        std::shared_lock lock (m_mutex);
+        return m_map.find(key) != m_map.end();
+    }
+
+    void create(const std::string& key)
+    {
+        std::unique_lock lock (m_mutex);
+        if (not m_map.contains(key)) {
+            m_map[key] = std::make_shared<int>(0);
+        }
+    }
+
+    void remove(const std::string& key)
+    {
+        std::shared_ptr<int> value;
+        std::unique_lock lock (m_mutex);
+        auto iter = m_map.find(key);
+        if (iter != m_map.end()) {
+            value = iter->second;
+            m_map.erase(iter);
+        }
+    }
+
+    size_t count() const
+    {
+        std::shared_lock lock (m_mutex);
+        return m_map.size();
+    }
+
+private:
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<std::string, std::shared_ptr<int>> m_map;
+};
+
+void run(const char* name, const std::vector<std::string>& keys, size_t operations,
+         unsigned threads, unsigned readsPerWrite, const Operations& ops)
+{
+    for (size_t i = 0; i < keys.size(); i += 2) {
+        ops.create(keys[i]);
+    }
+
+    std::vector<std::thread> workers;
+    std::vector<size_t> hits(threads);
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            size_t index = t * 7919;
+            for (size_t i = 0; i < operations; ++i) {
+                index = (index + 104729) % keys.size();
+                const std::string& key = keys[index];
+                const size_t slot = i % (readsPerWrite + 2);
+                if (slot == readsPerWrite) {
+                    ops.create(key);
+                } else if (slot == readsPerWrite + 1) {
+                    ops.remove(key);
+                } else {
+                    hits[t] += ops.get(key);
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+    size_t hit = 0;
+    for (auto value : hits) {
+        hit += value;
+    }
+    const double total = double(operations) * threads;
+    std::printf("%-22s %2u thread(s) %8.1f ns/op  %5.1f Mops/s  (%.0f%% hits)\n",
+                name, threads, elapsed.count() * threads / total, total / elapsed.count() * 1000,
+                100.0 * hit / total);
+
+    for (const auto& key : keys) {
+        ops.remove(key);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    static plog::ConsoleAppender<plog::TxtFormatter> appender;
+    plog::init(plog::none, &appender);
+
+    const size_t operations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    const unsigned threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 16;
+    const unsigned readsPerWrite = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 18;
+    if (operations == 0 or threads == 0) {
+        std::fprintf(stderr, "Usage: %s [operations per thread > 0] [threads > 0] [lookups per write]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < KEY_COUNT; ++i) {
+        keys.push_back(ClientList::generateIdCondidate());
+    }
+    std::printf("%zu keys, %u lookups per create+remove pair, %u hardware thread(s)\n",
+                keys.size(), readsPerWrite, std::thread::hardware_concurrency());
+
+    SingleLockMap single;
+    const Operations singleOps {
+        [&](const std::string& key) { return single.get(key); },
+        [&](const std::string& key) { single.create(key); },
+        [&](const std::string& key) { single.remove(key); }
+    };
+
+    ShardedMap<std::string, std::shared_ptr<int>> sharded;
+    const Operations shardedOps {
+        [&](const std::string& key) { return sharded.visit(key, [](const std::shared_ptr<int>&) {}); },
+        [&](const std::string& key) { sharded.tryEmplace(key, []() { return std::make_shared<int>(0); }); },
+        [&](const std::string& key) { sharded.erase(key, [](std::shared_ptr<int>&) {}); }
+    };
+
+    // Not loaded from a file, the clients would time out at once
+    Config::instance().setClientTimeout(3600);
+    auto& clients = ClientList::instanse();
+    const Operations clientListOps {
+        [&](const std::string& key) { return clients.get(key) != nullptr; },
+        [&](const std::string& key) { clients.create(key); },
+        [&](const std::string& key) { clients.remove(key); }
+    };
+
+    for (unsigned count : {1u, threads}) {
+        run("single shared_mutex", keys, operations, count, readsPerWrite, singleOps);
+        run("ShardedMap", keys, operations, count, readsPerWrite, shardedOps);
+        run("ClientList", keys, operations / 10, count, readsPerWrite, clientListOps);
+        if (threads == 1) {
+            break;
+        }
+    }
+    return 0;
+}
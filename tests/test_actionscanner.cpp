@@ -0,0 +1,202 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#include <gtest/gtest.h>
+
+#include "log.h"
+#include <plog/Appenders/ConsoleAppender.h>
+struct PlogInit {
+    PlogInit() {
+        static plog::ConsoleAppender<plog::TxtFormatter> appender;
+        static bool initialized = false;
+        if (!initialized) {
+            plog::init(plog::none, &appender);
+            initialized = true;
+        }
+    }
+};
+static PlogInit plogInit;
+
+#include "actionscanner.h"
+#include "crowlib/crow/json.h"
+
+#include <optional>
+#include <random>
+#include <utility>
+
+using BinaryProtocol::ActionType;
+
+namespace {
+
+using Decoded = std::optional<std::pair<ActionType, uint64_t>>;
+
+Decoded scanned(std::string_view text)
+{
+    BinaryProtocol::Action action;
+    if (not ActionScanner::scan(text, action)) {
+        return std::nullopt;
+    }
+    return std::make_pair(action.type, action.value);
+}
+
+// What WebAPI::internalWsJsonMessage and internalWsMessageProcessing make of the text
+Decoded generic(std::string_view text)
+{
+    try {
+        const auto json = crow::json::load(text.data(), text.size());
+        if (!json or not json.has("action") or json["action"].t() != crow::json::type::String or
+            not json.has("data") or json["data"].t() != crow::json::type::Object) {
+            return std::nullopt;
+        }
+        const std::string action = json["action"].s();
+        const auto& data = json["data"];
+        if (action == "confirm_chunk") {
+            return std::make_pair(ActionType::confirmChunk, data["index"].u());
+        }
+        if (action == "get_chunk") {
+            return std::make_pair(ActionType::getChunk, data["index"].u());
+        }
+        if (action == "ack" and data.has("id")) {
+            return std::make_pair(ActionType::ack, data["id"].u());
+        }
+    } catch (const std::exception&) {
+    }
+    return std::nullopt;
+}
+
+class MessageGenerator {
+public:
+    explicit MessageGenerator(uint32_t seed) : m_random(seed) {}
+
+    // A message of one of the three shapes, keys in any order, random whitespace
+    std::string message()
+    {
+        static const char* const actions[][2] = {
+            {"confirm_chunk", "index"}, {"get_chunk", "index"}, {"ack", "id"}
+        };
+        const auto& action = actions[pick(3)];
+        const std::string actionMember = space() + "\"action\"" + space() + ":" + space() +
+                                         "\"" + action[0] + "\"" + space();
+        const std::string dataMember = space() + "\"data\"" + space() + ":" + space() + "{" + space() +
+                                       "\"" + action[1] + "\"" + space() + ":" + space() +
+                                       std::to_string(value()) + space() + "}" + space();
+        return space() + "{" + (pick(2) ? actionMember + "," + dataMember : dataMember + "," + actionMember) +
+               "}" + space();
+    }
+
+    // One to three byte edits biased towards the characters that matter to JSON
+    std::string mutate(std::string text)
+    {
+        static const std::string alphabet = "{}[]:,\"\\ \t\r\n0123456789-+.eE_adinx\x01\x7f\xff";
+        for (size_t edits = 1 + pick(3); edits > 0; --edits) {
+            const char c = pick(4) == 0 ? static_cast<char>(pick(256)) : alphabet[pick(alphabet.size())];
+            const size_t pos = pick(text.size() + 1);
+            switch (pick(3)) {
+            case 0:
+                text.insert(pos, 1, c);
+                break;
+            case 1:
+                if (pos < text.size()) text[pos] = c;
+                break;
+            default:
+                if (pos < text.size()) text.erase(pos, 1);
+                break;
+            }
+        }
+        return text;
+    }
+
+private:
+    std::mt19937 m_random;
+
+    size_t pick(size_t n) { return std::uniform_int_distribution<size_t>(0, n - 1)(m_random); }
+
+    std::string space()
+    {
+        static const char whitespace[] = " \t\r\n";
+        std::string out;
+        for (size_t n = pick(4) == 0 ? pick(3) + 1 : 0; n > 0; --n) {
+            out.push_back(whitespace[pick(4)]);
+        }
+        return out;
+    }
+
+    // Up to 19 digits, small values being the common case
+    uint64_t value()
+    {
+        const size_t digits = pick(3) == 0 ? pick(19) + 1 : pick(4) + 1;
+        uint64_t limit = 1;
+        for (size_t i = 0; i < digits; ++i) limit *= 10;
+        return std::uniform_int_distribution<uint64_t>(0, limit - 1)(m_random);
+    }
+};
+
+} // namespace
+
+TEST(ActionScannerTest, HotActions) {
+    EXPECT_EQ(scanned(R"({"action":"confirm_chunk","data":{"index":12}})"),
+              std::make_pair(ActionType::confirmChunk, uint64_t(12)));
+    EXPECT_EQ(scanned(R"({"action":"get_chunk","data":{"index":0}})"),
+              std::make_pair(ActionType::getChunk, uint64_t(0)));
+    EXPECT_EQ(scanned(R"({"action":"ack","data":{"id":9999999999999999999}})"),
+              std::make_pair(ActionType::ack, uint64_t(9999999999999999999ull)));
+    EXPECT_EQ(scanned(" \r\n{ \"data\" : { \"index\" : 3 } ,\t\"action\" : \"get_chunk\" }\n"),
+              std::make_pair(ActionType::getChunk, uint64_t(3)));
+}
+
+TEST(ActionScannerTest, LeavesTheRestToTheGenericParser) {
+    for (const char* text : {
+             "",
+             "{}",
+             R"({"action":"new_name","data":{"name":"x"}})",
+             R"({"action":"ack","data":{}})",
+             R"({"action":"get_chunk","data":{"id":1}})",
+             R"({"action":"ack","data":{"index":1}})",
+             R"({"action":"get_chunk","data":{"index":"1"}})",
+             R"({"action":"get_chunk","data":{"index":-1}})",
+             R"({"action":"get_chunk","data":{"index":1.0}})",
+             R"({"action":"get_chunk","data":{"index":1e3}})",
+             R"({"action":"get_chunk","data":{"index":01}})",
+             R"({"action":"get_chunk","data":{"index":10000000000000000000}})",
+             R"({"action":"get_chunk","data":{"index":1,"index":2}})",
+             R"({"action":"get_chunk","data":{"index":1},"extra":0})",
+             R"({"action":"get_chunk","action":"ack","data":{"index":1}})",
+             R"({"action":"get\u005fchunk","data":{"index":1}})",
+             R"({"action":"get_chunk","data":{"index":1}} x)",
+             R"({"action":"get_chunk","data":{"index":1})",
+             R"([{"action":"get_chunk","data":{"index":1}}])",
+         }) {
+        EXPECT_FALSE(scanned(text)) << text;
+    }
+}
+
+TEST(ActionScannerTest, AcceptsGeneratedMessages) {
+    MessageGenerator generator(20260611);
+    for (int i = 0; i < 5000; ++i) {
+        const std::string text = generator.message();
+        const auto fast = scanned(text);
+        ASSERT_TRUE(fast) << text;
+        ASSERT_EQ(fast, generic(text)) << text;
+    }
+}
+
+// Fuzz: whatever the scanner accepts, the generic path decodes to the same action
+TEST(ActionScannerTest, MutationsMatchTheGenericPath) {
+    MessageGenerator generator(7);
+    size_t accepted = 0;
+    size_t rejected = 0;
+    for (int i = 0; i < 50000; ++i) {
+        const std::string text = generator.mutate(generator.message());
+        const auto fast = scanned(text);
+        if (fast) {
+            ++accepted;
+            ASSERT_EQ(fast, generic(text)) << text;
+        } else {
+            ++rejected;
+        }
+    }
+    // both outcomes are exercised
+    EXPECT_GT(accepted, 1000u);
+    EXPECT_GT(rejected, 1000u);
+}
@@ -0,0 +1,147 @@
+// Copyright (C) 2026  Roman Lyubimov
+// SPDX-License-Identifier: GPL-3.0-or-later
+// For full license text, see <https://www.gnu.org/licenses/gpl-3.0.txt>
+
+#include <gtest/gtest.h>
+
+#include "log.h"
+#include <plog/Appenders/ConsoleAppender.h>
+struct PlogInit {
+    PlogInit() {
+        static plog::ConsoleAppender<plog::TxtFormatter> appender;
+        static bool initialized = false;
+        if (!initialized) {
+            plog::init(plog::none, &appender);
+            initialized = true;
+        }
+    }
+};
+static PlogInit plogInit;
+
+#include "binaryprotocol.h"
+#include "serializableevent.h"
+
+#include <limits>
+
+using namespace BinaryProtocol;
+
+namespace {
+
+std::string bytes(std::initializer_list<uint8_t> list)
+{
+    return std::string(list.begin(), list.end());
+}
+
+std::string varint(uint64_t value)
+{
+    std::string out;
+    appendVarint(out, value);
+    return out;
+}
+
+} // namespace
+
+TEST(BinaryProtocolTest, VarintEncoding) {
+    EXPECT_EQ(varint(0), bytes({0x00}));
+    EXPECT_EQ(varint(1), bytes({0x01}));
+    EXPECT_EQ(varint(127), bytes({0x7f}));
+    EXPECT_EQ(varint(128), bytes({0x80, 0x01}));
+    EXPECT_EQ(varint(300), bytes({0xac, 0x02}));
+    EXPECT_EQ(varint(std::numeric_limits<uint64_t>::max()).size(), 10u);
+}
+
+TEST(BinaryProtocolTest, VarintRoundTrip) {
+    for (uint64_t value : {uint64_t(0), uint64_t(127), uint64_t(128), uint64_t(16383), uint64_t(16384),
+                           uint64_t(1) << 32, (uint64_t(1) << 63) - 1, uint64_t(1) << 63,
+                           std::numeric_limits<uint64_t>::max()}) {
+        const std::string encoded = varint(value) + "tail";
+        std::string_view in = encoded;
+        uint64_t decoded = 0;
+        ASSERT_TRUE(readVarint(in, decoded)) << value;
+        EXPECT_EQ(decoded, value);
+        EXPECT_EQ(in, "tail");
+    }
+}
+
+TEST(BinaryProtocolTest, VarintRejectsTruncatedAndOverlong) {
+    uint64_t value = 0;
+
+    std::string_view empty;
+    EXPECT_FALSE(readVarint(empty, value));
+
+    const std::string truncated = bytes({0x80, 0x80});
+    std::string_view in = truncated;
+    EXPECT_FALSE(readVarint(in, value));
+    EXPECT_EQ(in.size(), 2u); // nothing consumed
+
+    // 11 bytes
+    const std::string overlong = std::string(10, '\x80') + '\x01';
+    in = overlong;
+    EXPECT_FALSE(readVarint(in, value));
+
+    // the 10th byte overflows 64 bits
+    const std::string overflow = std::string(9, '\xff') + '\x02';
+    in = overflow;
+    EXPECT_FALSE(readVarint(in, value));
+}
+
+TEST(BinaryProtocolTest, ParseIndexActions) {
+    Action action;
+
+    ASSERT_TRUE(parseAction(bytes({0x01}) + varint(42), action));
+    EXPECT_EQ(action.type, ActionType::confirmChunk);
+    EXPECT_EQ(action.value, 42u);
+
+    ASSERT_TRUE(parseAction(bytes({0x02}) + varint(300), action));
+    EXPECT_EQ(action.type, ActionType::getChunk);
+    EXPECT_EQ(action.value, 300u);
+
+    ASSERT_TRUE(parseAction(bytes({0x03}) + varint(7), action));
+    EXPECT_EQ(action.type, ActionType::ack);
+    EXPECT_EQ(action.value, 7u);
+    EXPECT_TRUE(action.payload.empty());
+}
+
+TEST(BinaryProtocolTest, ParsePayloadActions) {
+    Action action;
+
+    // the chunk itself follows in the next frame
+    ASSERT_TRUE(parseAction(bytes({0x00}), action));
+    EXPECT_EQ(action.type, ActionType::chunk);
+    EXPECT_TRUE(action.payload.empty());
+
+    const std::string json = bytes({0x7f}) + R"({"action":"new_name","data":{"name":"x"}})";
+    ASSERT_TRUE(parseAction(json, action));
+    EXPECT_EQ(action.type, ActionType::json);
+    EXPECT_EQ(action.payload, R"({"action":"new_name","data":{"name":"x"}})");
+}
+
+TEST(BinaryProtocolTest, ParseRejectsMalformed) {
+    Action action;
+    EXPECT_FALSE(parseAction("", action));
+    EXPECT_FALSE(parseAction(bytes({0x04, 0x01}), action));       // unknown type
+    EXPECT_FALSE(parseAction(bytes({0x01}), action));             // no index
+    EXPECT_FALSE(parseAction(bytes({0x02, 0x80}), action));       // truncated index
+    EXPECT_FALSE(parseAction(bytes({0x03, 0x01, 0x00}), action)); // trailing byte
+    EXPECT_FALSE(parseAction(bytes({0x00, 0x01}), action));       // chunk bytes after the type
+}
+
+TEST(BinaryProtocolTest, ChunkEventEncodings) {
+    using namespace SerializableEvent;
+
+    EXPECT_EQ(NewChunkAvailable({5, 1048576}).binary(),
+              bytes({0x01, 0x05}) + varint(1048576));
+    EXPECT_EQ(ChunkDownload({"ab", 300, true}).binary(),
+              bytes({0x02, 0x02, 'a', 'b', 0xac, 0x02, 0x01}));
+    EXPECT_EQ(ChunkDownload({"ab", 1, false}).binary(),
+              bytes({0x02, 0x02, 'a', 'b', 0x01, 0x00}));
+    EXPECT_EQ(TotalBytesCount({128, true}).binary(), bytes({0x03, 0x80, 0x01, 0x01}));
+    EXPECT_EQ(TotalBytesCount({0, false}).binary(), bytes({0x03, 0x00, 0x00}));
+    EXPECT_EQ(PersonalReceivedUpdated({1}).binary(), bytes({0x04, 0x01}));
+    EXPECT_EQ(ChunksRemoved({{1, 2, 200}}).binary(), bytes({0x05, 0x03, 0x01, 0x02, 0xc8, 0x01}));
+    EXPECT_EQ(ChunksRemoved({{}}).binary(), bytes({0x05, 0x00}));
+    EXPECT_EQ(NewChunkIsAllowed({true, false}).binary(), bytes({0x06, 0x01, 0x00}));
+    EXPECT_EQ(NewChunkIsAllowed({false, true}).binary(), bytes({0x06, 0x00, 0x01}));
+    // the reason only goes with a refusal, as in JSON
+    EXPECT_EQ(NewChunkIsAllowed({true, true}).binary(), bytes({0x06, 0x01, 0x00}));
+}
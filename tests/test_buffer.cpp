@@ -31,6 +31,7 @@ protected:
     void SetUp() override {
         Config::instance().setTransferSessionMaxChunkSize(1024 * 1024);
         Config::instance().setTransferSessionChunkQueueMaxSize(10);
+        Config::instance().setTransferSessionChunkQueueMaxBytes(0);
         Config::instance().setTransferSessionMaxConsumerCount(5);
     }
 
@@ -156,7 +157,7 @@ TEST_F(BufferTest, SetChunkAsReceivedTriggersCleanup) {
     EXPECT_EQ(buffer.chunkCount(), 1u);
 
     // Mark chunk as received by the only consumer
-    bool result = buffer.setChunkAsReceived(index, removedChunks);
+    bool result = buffer.setChunkAsReceived(index, "consumer1", removedChunks);
     EXPECT_TRUE(result);
 
     // Chunk should have been removed by sanitize
@@ -168,7 +169,7 @@ TEST_F(BufferTest, SetChunkAsReceivedTriggersCleanup) {
 // setChunkAsReceived returns false for invalid index
 TEST_F(BufferTest, SetChunkAsReceivedReturnsFalseForInvalid) {
     std::list<size_t> removedChunks;
-    EXPECT_FALSE(buffer.setChunkAsReceived(999, removedChunks));
+    EXPECT_FALSE(buffer.setChunkAsReceived(999, "consumer1", removedChunks));
     EXPECT_TRUE(removedChunks.empty());
 }
 
@@ -226,7 +227,7 @@ TEST_F(BufferTest, AddConsumerRejectsAfterChunksRemoved) {
     ASSERT_NE(index, 0u);
 
     std::list<size_t> removedChunks;
-    buffer.setChunkAsReceived(index, removedChunks);
+    buffer.setChunkAsReceived(index, "consumer1", removedChunks);
 
     // Verify some chunks were removed
     EXPECT_TRUE(buffer.someChunksWasRemoved());
@@ -248,7 +249,7 @@ TEST_F(BufferTest, InitialChunksFreezingPreventsRemoval) {
 
     // Mark as received, but freeze should prevent removal
     std::list<size_t> removedChunks;
-    buffer.setChunkAsReceived(index, removedChunks);
+    buffer.setChunkAsReceived(index, "consumer1", removedChunks);
 
     EXPECT_TRUE(removedChunks.empty());
     EXPECT_EQ(buffer.chunkCount(), 1u);
@@ -295,6 +296,98 @@ TEST_F(BufferTest, BytesOutTracking) {
     EXPECT_EQ(buffer.bytesOut(), 300u);
 }
 
+// Out-of-order confirmations free each chunk as it completes and the window head catches up
+TEST_F(BufferTest, OutOfOrderConfirmationsFreeChunksIndividually) {
+    EXPECT_TRUE(buffer.addNewToExpectedConsumers("consumer1"));
+    std::list<size_t> removedChunks;
+    buffer.setInitialChunksFreezingDropped(removedChunks);
+
+    for (int i = 0; i < 3; ++i) {
+        std::string data(10, 'A');
+        ASSERT_NE(buffer.addChunk(data), 0u);
+    }
+
+    EXPECT_TRUE(buffer.setChunkAsReceived(3, "consumer1", removedChunks));
+    EXPECT_EQ(removedChunks, (std::list<size_t>{3}));
+    EXPECT_TRUE(buffer.setChunkAsReceived(2, "consumer1", removedChunks));
+    EXPECT_EQ(removedChunks, (std::list<size_t>{3, 2}));
+    EXPECT_EQ(buffer.chunksIndex(), (std::list<size_t>{1}));
+
+    EXPECT_TRUE(buffer.setChunkAsReceived(1, "consumer1", removedChunks));
+    EXPECT_EQ(removedChunks, (std::list<size_t>{3, 2, 1}));
+    EXPECT_EQ(buffer.chunkCount(), 0u);
+
+    // The emptied window keeps working for new chunks
+    std::string data(10, 'B');
+    EXPECT_EQ(buffer.addChunk(data), 4u);
+    EXPECT_EQ(buffer.chunksIndex(), (std::list<size_t>{4}));
+}
+
+// Chunks confirmed during the freeze are all freed when it drops
+TEST_F(BufferTest, FreezeDropFreesChunksConfirmedDuringFreeze) {
+    EXPECT_TRUE(buffer.addNewToExpectedConsumers("consumer1"));
+
+    std::list<size_t> removedChunks;
+    for (size_t i = 1; i <= 4; ++i) {
+        std::string data(10, 'A');
+        ASSERT_EQ(buffer.addChunk(data), i);
+    }
+    EXPECT_TRUE(buffer.setChunkAsReceived(1, "consumer1", removedChunks));
+    EXPECT_TRUE(buffer.setChunkAsReceived(3, "consumer1", removedChunks));
+    EXPECT_TRUE(removedChunks.empty());
+
+    buffer.setInitialChunksFreezingDropped(removedChunks);
+    EXPECT_EQ(removedChunks, (std::list<size_t>{1, 3}));
+    EXPECT_EQ(buffer.chunksIndex(), (std::list<size_t>{2, 4}));
+}
+
+// A consumer confirming the same chunk twice is counted once
+TEST_F(BufferTest, RepeatedConfirmationIsNotCounted) {
+    EXPECT_TRUE(buffer.addNewToExpectedConsumers("consumer1"));
+    EXPECT_TRUE(buffer.addNewToExpectedConsumers("consumer2"));
+    std::list<size_t> removedChunks;
+    buffer.setInitialChunksFreezingDropped(removedChunks);
+
+    std::string data(100, 'A');
+    size_t idx = buffer.addChunk(data);
+    ASSERT_NE(idx, 0u);
+
+    EXPECT_TRUE(buffer.setChunkAsReceived(idx, "consumer1", removedChunks));
+    EXPECT_FALSE(buffer.setChunkAsReceived(idx, "consumer1", removedChunks));
+    EXPECT_TRUE(removedChunks.empty());
+    EXPECT_EQ(buffer.chunkCount(), 1u);
+
+    // Unknown consumers are ignored as well
+    EXPECT_FALSE(buffer.setChunkAsReceived(idx, "stranger", removedChunks));
+    EXPECT_EQ(buffer.chunkCount(), 1u);
+
+    EXPECT_TRUE(buffer.setChunkAsReceived(idx, "consumer2", removedChunks));
+    EXPECT_EQ(removedChunks.size(), 1u);
+}
+
+// A consumer that takes over the slot of a departed one starts with no confirmations
+TEST_F(BufferTest, ReusedConsumerSlotStartsClean) {
+    EXPECT_TRUE(buffer.addNewToExpectedConsumers("consumer1"));
+    EXPECT_TRUE(buffer.addNewToExpectedConsumers("consumer2"));
+
+    std::string data(100, 'A');
+    size_t idx = buffer.addChunk(data);
+    ASSERT_NE(idx, 0u);
+
+    std::list<size_t> removedChunks;
+    EXPECT_TRUE(buffer.setChunkAsReceived(idx, "consumer1", removedChunks));
+    buffer.removeOneFromExpectedConsumers("consumer1", removedChunks);
+    EXPECT_TRUE(buffer.addNewToExpectedConsumers("consumer3"));
+
+    buffer.setInitialChunksFreezingDropped(removedChunks);
+    EXPECT_TRUE(buffer.setChunkAsReceived(idx, "consumer2", removedChunks));
+    EXPECT_TRUE(removedChunks.empty());
+    EXPECT_EQ(buffer.chunkCount(), 1u);
+
+    EXPECT_TRUE(buffer.setChunkAsReceived(idx, "consumer3", removedChunks));
+    EXPECT_EQ(buffer.chunkCount(), 0u);
+}
+
 // removeOneFromExpectedConsumers decreases count and triggers sanitize
 TEST_F(BufferTest, RemoveConsumerTriggersCleanup) {
     EXPECT_TRUE(buffer.addNewToExpectedConsumers("consumer1"));
@@ -310,12 +403,12 @@ TEST_F(BufferTest, RemoveConsumerTriggersCleanup) {
 
     // Both consumers receive chunk
     std::list<size_t> removedChunks;
-    buffer.setChunkAsReceived(idx, removedChunks);
+    buffer.setChunkAsReceived(idx, "consumer1", removedChunks);
     // Not all consumers received yet, chunk should remain
     EXPECT_TRUE(removedChunks.empty());
     EXPECT_EQ(buffer.chunkCount(), 1u);
 
-    buffer.setChunkAsReceived(idx, removedChunks);
+    buffer.setChunkAsReceived(idx, "consumer2", removedChunks);
     // Now all consumers received, chunk should be removed
     EXPECT_FALSE(removedChunks.empty());
     EXPECT_EQ(buffer.chunkCount(), 0u);
@@ -334,7 +427,7 @@ TEST_F(BufferTest, RemoveConsumerCleanupMultipleChunks) {
 
     // Consumer receives chunk 1 only
     std::list<size_t> removedChunks;
-    buffer.setChunkAsReceived(idx1, removedChunks);
+    buffer.setChunkAsReceived(idx1, "consumer1", removedChunks);
     EXPECT_EQ(removedChunks.size(), 1u);
     EXPECT_EQ(buffer.chunkCount(), 1u);
 
@@ -401,3 +494,197 @@ TEST_F(BufferTest, AddEmptyChunk) {
     EXPECT_NE(index, 0u);
     EXPECT_EQ(buffer.bytesIn(), 0u);
 }
+
+// The ring keeps working after the window wraps around many times
+TEST_F(BufferTest, RingWrapsAroundWithSequentialConsumption) {
+    EXPECT_TRUE(buffer.addNewToExpectedConsumers("consumer1"));
+    std::list<size_t> removedChunks;
+    buffer.setInitialChunksFreezingDropped(removedChunks);
+
+    for (size_t i = 1; i <= 100; ++i) {
+        std::string data(i, static_cast<char>('a' + i % 26));
+        ASSERT_EQ(buffer.addChunk(data), i);
+
+        auto result = buffer[i];
+        ASSERT_NE(result, nullptr);
+        EXPECT_EQ(std::string(result->begin(), result->end()), data);
+
+        removedChunks.clear();
+        EXPECT_TRUE(buffer.setChunkAsReceived(i, "consumer1", removedChunks));
+        ASSERT_EQ(removedChunks.size(), 1u);
+        EXPECT_EQ(removedChunks.front(), i);
+        EXPECT_EQ(buffer[i], nullptr);
+    }
+    EXPECT_EQ(buffer.chunkCount(), 0u);
+    EXPECT_EQ(buffer.currentMaxChunkIndex(), 100u);
+}
+
+// A chunk stuck at the head of the window does not block the queue or corrupt lookups
+TEST_F(BufferTest, RingGrowsWhenHeadChunkIsStuck) {
+    EXPECT_TRUE(buffer.addNewToExpectedConsumers("consumer1"));
+    std::list<size_t> removedChunks;
+    buffer.setInitialChunksFreezingDropped(removedChunks);
+
+    std::string head = "head";
+    ASSERT_EQ(buffer.addChunk(head), 1u);
+
+    // Consume everything except chunk 1, so the window keeps widening
+    for (size_t i = 2; i <= 50; ++i) {
+        std::string data = std::to_string(i);
+        ASSERT_EQ(buffer.addChunk(data), i);
+        EXPECT_TRUE(buffer.setChunkAsReceived(i, "consumer1", removedChunks));
+    }
+
+    EXPECT_EQ(buffer.chunkCount(), 1u);
+    EXPECT_TRUE(buffer.newChunkIsAllowed());
+
+    auto result = buffer[1];
+    ASSERT_NE(result, nullptr);
+    EXPECT_EQ(std::string(result->begin(), result->end()), head);
+
+    std::string tail = "tail";
+    ASSERT_EQ(buffer.addChunk(tail), 51u);
+
+    auto indices = buffer.chunksIndex();
+    std::vector<size_t> indexVec(indices.begin(), indices.end());
+    EXPECT_EQ(indexVec, (std::vector<size_t>{1, 51}));
+}
+
+// A chunk stuck at the head stops the sender once the window spans maxWindow() chunks
+TEST_F(BufferTest, StuckHeadChunkBoundsTheWindow) {
+    EXPECT_TRUE(buffer.addNewToExpectedConsumers("consumer1"));
+    std::list<size_t> removedChunks;
+    buffer.setInitialChunksFreezingDropped(removedChunks);
+
+    const size_t maxWindow = TransferSessionDetails::Buffer::maxWindow();
+    std::string head = "head";
+    ASSERT_EQ(buffer.addChunk(head), 1u);
+    for (size_t i = 2; i <= maxWindow; ++i) {
+        std::string data = std::to_string(i);
+        ASSERT_EQ(buffer.addChunk(data), i);
+        ASSERT_TRUE(buffer.setChunkAsReceived(i, "consumer1", removedChunks));
+    }
+
+    EXPECT_EQ(buffer.chunkCount(), 1u);
+    EXPECT_FALSE(buffer.newChunkIsAllowed());
+    std::string refused = "refused";
+    EXPECT_EQ(buffer.addChunk(refused), 0u);
+    EXPECT_EQ(buffer.chunksIndex(), (std::list<size_t>{1}));
+
+    // Confirming the head reopens the window
+    removedChunks.clear();
+    TransferSessionDetails::Buffer::State state;
+    EXPECT_TRUE(buffer.setChunkAsReceived(1, "consumer1", removedChunks, state));
+    EXPECT_TRUE(state.newChunkIsAllowed);
+    EXPECT_TRUE(state.newChunkIsAllowedChanged);
+    std::string next = "next";
+    EXPECT_EQ(buffer.addChunk(next), maxWindow + 1);
+}
+
+// In byte mode small chunks are not limited by chunk_queue_max_size
+TEST_F(BufferTest, ByteWindowAcceptsManySmallChunks) {
+    Config::instance().setTransferSessionChunkQueueMaxBytes(1000);
+
+    for (int i = 0; i < 20; ++i) {
+        std::string data(50, 'A');
+        EXPECT_NE(buffer.addChunk(data), 0u);
+    }
+    EXPECT_EQ(buffer.chunkCount(), 20u);
+    EXPECT_EQ(buffer.queuedBytes(), 1000u);
+    EXPECT_FALSE(buffer.newChunkIsAllowed());
+
+    std::string data(50, 'A');
+    EXPECT_EQ(buffer.addChunk(data), 0u);
+}
+
+// A chunk is accepted while the window is not full, even if it overshoots it
+TEST_F(BufferTest, ByteWindowOvershootsByOneChunk) {
+    Config::instance().setTransferSessionChunkQueueMaxBytes(1000);
+
+    std::string first(900, 'A');
+    std::string second(900, 'B');
+    EXPECT_EQ(buffer.addChunk(first), 1u);
+    EXPECT_TRUE(buffer.newChunkIsAllowed());
+    EXPECT_EQ(buffer.addChunk(second), 2u);
+    EXPECT_FALSE(buffer.newChunkIsAllowed());
+
+    std::string third(1, 'C');
+    EXPECT_EQ(buffer.addChunk(third), 0u);
+    EXPECT_EQ(buffer.queuedBytes(), 1800u);
+}
+
+// Removed chunks give their bytes back to the window
+TEST_F(BufferTest, ByteWindowReopensWhenChunksRemoved) {
+    Config::instance().setTransferSessionChunkQueueMaxBytes(1000);
+    EXPECT_TRUE(buffer.addNewToExpectedConsumers("consumer1"));
+    std::list<size_t> removedChunks;
+    buffer.setInitialChunksFreezingDropped(removedChunks);
+
+    std::string big(1000, 'A');
+    std::string small(10, 'B');
+    ASSERT_EQ(buffer.addChunk(big), 1u);
+    EXPECT_FALSE(buffer.newChunkIsAllowed());
+
+    EXPECT_TRUE(buffer.setChunkAsReceived(1, "consumer1", removedChunks));
+    EXPECT_EQ(buffer.queuedBytes(), 0u);
+    EXPECT_TRUE(buffer.newChunkIsAllowed());
+    EXPECT_EQ(buffer.addChunk(small), 2u);
+    EXPECT_EQ(buffer.queuedBytes(), 10u);
+}
+
+// addChunk reports the buffer state from the same critical section
+TEST_F(BufferTest, AddChunkReportsState) {
+    Buffer::State state;
+    std::string data(100, 'A');
+    ASSERT_EQ(buffer.addChunk(data, state), 1u);
+
+    EXPECT_EQ(state.chunkCount, 1u);
+    EXPECT_EQ(state.bytesIn, 100u);
+    EXPECT_EQ(state.chunkSize, 100u);
+    EXPECT_FALSE(state.eof);
+    EXPECT_TRUE(state.newChunkIsAllowed);
+    EXPECT_FALSE(state.newChunkIsAllowedChanged);
+}
+
+// The allowance transition is reported once, by the operation that caused it
+TEST_F(BufferTest, NewChunkAllowanceTransitionIsReportedOnce) {
+    EXPECT_TRUE(buffer.addNewToExpectedConsumers("consumer1"));
+    std::list<size_t> removedChunks;
+    buffer.setInitialChunksFreezingDropped(removedChunks);
+
+    Buffer::State state;
+    for (int i = 0; i < 9; ++i) {
+        std::string data(10, 'A');
+        ASSERT_NE(buffer.addChunk(data, state), 0u);
+        EXPECT_FALSE(state.newChunkIsAllowedChanged);
+    }
+
+    std::string data(10, 'A');
+    ASSERT_EQ(buffer.addChunk(data, state), 10u);
+    EXPECT_FALSE(state.newChunkIsAllowed);
+    EXPECT_TRUE(state.newChunkIsAllowedChanged);
+
+    // A refused chunk does not report the same transition again
+    std::string refused(10, 'B');
+    EXPECT_EQ(buffer.addChunk(refused, state), 0u);
+    EXPECT_EQ(state.chunkSize, 0u);
+    EXPECT_FALSE(state.newChunkIsAllowedChanged);
+
+    EXPECT_TRUE(buffer.setChunkAsReceived(1, "consumer1", removedChunks, state));
+    EXPECT_EQ(state.chunkCount, 9u);
+    EXPECT_EQ(state.chunkSize, 10u);
+    EXPECT_TRUE(state.newChunkIsAllowed);
+    EXPECT_TRUE(state.newChunkIsAllowedChanged);
+
+    EXPECT_FALSE(buffer.snapshot().newChunkIsAllowedChanged);
+}
+
+// setEndOfFile reports whether it has changed anything
+TEST_F(BufferTest, SetEndOfFileReportsState) {
+    Buffer::State state;
+    EXPECT_TRUE(buffer.setEndOfFile(state));
+    EXPECT_TRUE(state.eof);
+    EXPECT_EQ(state.chunkCount, 0u);
+
+    EXPECT_FALSE(buffer.setEndOfFile(state));
+}
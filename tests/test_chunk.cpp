@@ -24,9 +24,8 @@ static PlogInit plogInit;
 #include <string>
 #include <vector>
 
-using TransferSessionDetails::AtomicSet;
-using TransferSessionDetails::AtomicSetSizeAccess;
 using TransferSessionDetails::Chunk;
+using TransferSessionDetails::ConsumerMask;
 
 class ChunkTest : public ::testing::Test {
 protected:
@@ -34,15 +33,10 @@ protected:
         Config::instance().setTransferSessionMaxChunkSize(1024 * 1024);
         Config::instance().setTransferSessionChunkQueueMaxSize(10);
         Config::instance().setTransferSessionMaxConsumerCount(5);
-
-        consumers = std::make_shared<AtomicSet<std::string>>();
     }
 
-    std::shared_ptr<AtomicSet<std::string>> consumers;
-
     Chunk makeChunk(const std::vector<uint8_t>& data) {
-        AtomicSetSizeAccess access(consumers);
-        return Chunk(access, data.data(), data.size());
+        return Chunk(std::string(data.begin(), data.end()));
     }
 };
 
@@ -53,10 +47,10 @@ TEST_F(ChunkTest, ConstructorStoresDataCorrectly) {
 
     auto result = chunk.data();
     ASSERT_NE(result, nullptr);
-    EXPECT_EQ(*result, input);
+    EXPECT_EQ(std::vector<uint8_t>(result->begin(), result->end()), input);
 }
 
-// data() returns shared_ptr to correct vector
+// data() returns shared_ptr to correct data
 TEST_F(ChunkTest, DataReturnsSharedPtrToCorrectVector) {
     std::string str = "Hello, Chunk!";
     std::vector<uint8_t> input(str.begin(), str.end());
@@ -94,106 +88,122 @@ TEST_F(ChunkTest, DataSizeWithEmptyData) {
 
 // howMuchIsLeft with 0 uses equals consumer count
 TEST_F(ChunkTest, HowMuchIsLeftWithZeroUsesEqualsConsumerCount) {
-    consumers->add("consumer1");
-    consumers->add("consumer2");
-    consumers->add("consumer3");
+    const ConsumerMask expected = 0b111;
 
     std::vector<uint8_t> input = {0xAA, 0xBB};
     Chunk chunk = makeChunk(input);
 
-    EXPECT_EQ(chunk.howMuchIsLeft(), 3u);
+    EXPECT_EQ(chunk.howMuchIsLeft(expected), 3u);
     EXPECT_EQ(chunk.usesCount(), 0u);
 }
 
 // howMuchIsLeft with zero consumers returns 0
 TEST_F(ChunkTest, HowMuchIsLeftWithZeroConsumersReturnsZero) {
-    // No consumers added
+    // No consumers expected
     std::vector<uint8_t> input = {0x01};
     Chunk chunk = makeChunk(input);
 
-    // uses (0) >= expected (0), so howMuchIsLeft returns 0
-    EXPECT_EQ(chunk.howMuchIsLeft(), 0u);
+    EXPECT_EQ(chunk.howMuchIsLeft(0), 0u);
 }
 
-// incrementUses decrements howMuchIsLeft
-TEST_F(ChunkTest, IncrementUsesDecrementsHowMuchIsLeft) {
-    consumers->add("consumer1");
-    consumers->add("consumer2");
+// confirm decrements howMuchIsLeft
+TEST_F(ChunkTest, ConfirmDecrementsHowMuchIsLeft) {
+    const ConsumerMask expected = 0b11;
 
     std::vector<uint8_t> input = {0x01};
     Chunk chunk = makeChunk(input);
 
-    EXPECT_EQ(chunk.howMuchIsLeft(), 2u);
+    EXPECT_EQ(chunk.howMuchIsLeft(expected), 2u);
 
-    chunk.incrementUses();
-    EXPECT_EQ(chunk.howMuchIsLeft(), 1u);
+    EXPECT_TRUE(chunk.confirm(0));
+    EXPECT_EQ(chunk.howMuchIsLeft(expected), 1u);
     EXPECT_EQ(chunk.usesCount(), 1u);
 
-    chunk.incrementUses();
-    EXPECT_EQ(chunk.howMuchIsLeft(), 0u);
+    EXPECT_TRUE(chunk.confirm(1));
+    EXPECT_EQ(chunk.howMuchIsLeft(expected), 0u);
     EXPECT_EQ(chunk.usesCount(), 2u);
 }
 
-// incrementUses stops at consumer count (doesn't go negative / overflow)
-TEST_F(ChunkTest, IncrementUsesStopsAtConsumerCount) {
-    consumers->add("consumer1");
+// confirm is idempotent per consumer
+TEST_F(ChunkTest, RepeatedConfirmIsCountedOnce) {
+    const ConsumerMask expected = 0b11;
 
     std::vector<uint8_t> input = {0x01};
     Chunk chunk = makeChunk(input);
 
-    EXPECT_EQ(chunk.howMuchIsLeft(), 1u);
-
-    chunk.incrementUses();
-    EXPECT_EQ(chunk.howMuchIsLeft(), 0u);
-    EXPECT_EQ(chunk.usesCount(), 1u);
-
-    // Calling incrementUses beyond consumer count should not increment further
-    chunk.incrementUses();
-    EXPECT_EQ(chunk.howMuchIsLeft(), 0u);
-    EXPECT_EQ(chunk.usesCount(), 1u);
-
-    // Call many more times
+    EXPECT_TRUE(chunk.confirm(0));
     for (int i = 0; i < 100; ++i) {
-        chunk.incrementUses();
+        EXPECT_FALSE(chunk.confirm(0));
     }
     EXPECT_EQ(chunk.usesCount(), 1u);
-    EXPECT_EQ(chunk.howMuchIsLeft(), 0u);
+    EXPECT_EQ(chunk.howMuchIsLeft(expected), 1u);
 }
 
-// howMuchIsLeft returns 0 when uses >= consumers
-TEST_F(ChunkTest, HowMuchIsLeftReturnsZeroWhenUsesEqualConsumers) {
-    consumers->add("consumer1");
-    consumers->add("consumer2");
+// Confirmations of consumers that are not expected do not count
+TEST_F(ChunkTest, UnexpectedConsumerDoesNotCount) {
+    const ConsumerMask expected = 0b01;
+
+    std::vector<uint8_t> input = {0x01};
+    Chunk chunk = makeChunk(input);
+
+    chunk.confirm(1);
+    EXPECT_EQ(chunk.howMuchIsLeft(expected), 1u);
 
+    chunk.confirm(0);
+    EXPECT_EQ(chunk.howMuchIsLeft(expected), 0u);
+}
+
+// howMuchIsLeft follows the expected mask when consumers are removed
+TEST_F(ChunkTest, HowMuchIsLeftFollowsExpectedMask) {
     std::vector<uint8_t> input = {0x01};
     Chunk chunk = makeChunk(input);
 
-    chunk.incrementUses();
-    chunk.incrementUses();
+    EXPECT_EQ(chunk.howMuchIsLeft(0b111), 3u);
+
+    chunk.confirm(0);
+    EXPECT_EQ(chunk.howMuchIsLeft(0b111), 2u);
 
-    EXPECT_EQ(chunk.howMuchIsLeft(), 0u);
+    // Consumer 2 is gone
+    EXPECT_EQ(chunk.howMuchIsLeft(0b011), 1u);
+
+    chunk.confirm(1);
+    EXPECT_EQ(chunk.howMuchIsLeft(0b011), 0u);
 }
 
-// howMuchIsLeft adjusts dynamically when consumers are removed
-TEST_F(ChunkTest, HowMuchIsLeftAdjustsDynamicallyOnConsumerRemoval) {
-    consumers->add("consumer1");
-    consumers->add("consumer2");
-    consumers->add("consumer3");
+// forget clears the confirmation of a departed consumer
+TEST_F(ChunkTest, ForgetClearsConfirmation) {
+    std::vector<uint8_t> input = {0x01};
+    Chunk chunk = makeChunk(input);
+
+    chunk.confirm(0);
+    chunk.forget(0);
+    EXPECT_EQ(chunk.usesCount(), 0u);
+    EXPECT_EQ(chunk.howMuchIsLeft(0b1), 1u);
+    EXPECT_TRUE(chunk.confirm(0));
+}
+
+// The highest consumer slot is usable
+TEST_F(ChunkTest, HighestConsumerSlot) {
+    const size_t last = Chunk::MAX_CONSUMERS - 1;
+    const ConsumerMask expected = ConsumerMask(1) << last;
 
     std::vector<uint8_t> input = {0x01};
     Chunk chunk = makeChunk(input);
 
-    EXPECT_EQ(chunk.howMuchIsLeft(), 3u);
+    EXPECT_EQ(chunk.howMuchIsLeft(expected), 1u);
+    EXPECT_TRUE(chunk.confirm(last));
+    EXPECT_EQ(chunk.howMuchIsLeft(expected), 0u);
+}
 
-    chunk.incrementUses();
-    EXPECT_EQ(chunk.howMuchIsLeft(), 2u);
+// Constructor takes over the string buffer without copying it
+TEST_F(ChunkTest, ConstructorTakesOverStringBuffer) {
+    std::string input(4096, 'Z');
+    const char* buffer = input.data();
 
-    // Remove a consumer from the shared set
-    consumers->remove("consumer3");
-    EXPECT_EQ(chunk.howMuchIsLeft(), 1u);
+    Chunk chunk(std::move(input));
 
-    chunk.incrementUses();
-    EXPECT_EQ(chunk.howMuchIsLeft(), 0u);
+    EXPECT_EQ(chunk.data()->data(), buffer);
+    EXPECT_EQ(chunk.dataSize(), 4096u);
 }
 
 // Large data chunk
@@ -205,6 +215,6 @@ TEST_F(ChunkTest, LargeDataChunk) {
     auto result = chunk.data();
     ASSERT_NE(result, nullptr);
     EXPECT_EQ(result->size(), 100000u);
-    EXPECT_EQ((*result)[0], 0xFF);
-    EXPECT_EQ((*result)[99999], 0xFF);
+    EXPECT_EQ(static_cast<uint8_t>((*result)[0]), 0xFF);
+    EXPECT_EQ(static_cast<uint8_t>((*result)[99999]), 0xFF);
 }
@@ -0,0 +1,232 @@
+// Tests for ChunkMemoryPool
+
+#include "log.h"
+#include <plog/Appenders/ConsoleAppender.h>
+
+struct PlogInit {
+    PlogInit() {
+        static plog::ConsoleAppender<plog::TxtFormatter> appender;
+        static bool initialized = false;
+        if (!initialized) {
+            plog::init(plog::none, &appender);
+            initialized = true;
+        }
+    }
+};
+static PlogInit plogInit;
+
+#include "chunkmemorypool.h"
+#include "config/config.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ChunkMemoryPoolTest : public ::testing::Test {
+protected:
+    static constexpr size_t SLAB = 4096;
+
+    void SetUp() override {
+        Config::instance().setTransferSessionMaxChunkSize(SLAB);
+        Config::instance().setTransferSessionChunkPoolSize(4);
+    }
+
+    ChunkMemoryPool& pool = ChunkMemoryPool::instance();
+
+    std::string fullSlab(char fill = 'x') {
+        std::string buffer = pool.acquire();
+        buffer.assign(SLAB, fill);
+        return buffer;
+    }
+};
+
+// acquire() hands out an empty buffer with a slab of capacity
+TEST_F(ChunkMemoryPoolTest, AcquireReturnsEmptySlab) {
+    std::string buffer = pool.acquire();
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_GE(buffer.capacity(), SLAB);
+}
+
+// share() takes the buffer over and counts it as in use until released
+TEST_F(ChunkMemoryPoolTest, SharedDataIsCountedInUse) {
+    const auto before = pool.statistics();
+
+    std::string buffer = fullSlab();
+    const char* raw = buffer.data();
+    auto shared = pool.share(std::move(buffer));
+
+    EXPECT_EQ(shared->data(), raw);
+    EXPECT_EQ(shared->size(), SLAB);
+    EXPECT_EQ(pool.statistics().inUse, before.inUse + 1);
+
+    shared.reset();
+    EXPECT_EQ(pool.statistics().inUse, before.inUse);
+}
+
+// A released slab is handed out again by the next acquire()
+TEST_F(ChunkMemoryPoolTest, ReleasedSlabIsReused) {
+    // Drain the free list so the next acquire() has only our slab to return
+    std::vector<std::string> drained;
+    while (pool.statistics().free > 0) {
+        drained.push_back(pool.acquire());
+    }
+
+    std::string buffer = fullSlab();
+    const char* raw = buffer.data();
+    auto shared = pool.share(std::move(buffer));
+    shared.reset();
+
+    EXPECT_EQ(pool.statistics().free, 1u);
+    std::string again = pool.acquire();
+    EXPECT_EQ(again.data(), raw);
+    EXPECT_TRUE(again.empty());
+}
+
+// A small chunk is copied out so it does not pin a whole slab
+TEST_F(ChunkMemoryPoolTest, SmallDataDoesNotPinSlab) {
+    std::vector<std::string> drained;
+    while (pool.statistics().free > 0) {
+        drained.push_back(pool.acquire());
+    }
+
+    std::string buffer = pool.acquire();
+    buffer.assign("tiny");
+    auto shared = pool.share(std::move(buffer));
+
+    EXPECT_EQ(*shared, "tiny");
+    EXPECT_LT(shared->capacity(), SLAB);
+    EXPECT_EQ(pool.statistics().free, 1u);
+}
+
+// A chunk over an eighth of a slab keeps the slab, it is not copied
+TEST_F(ChunkMemoryPoolTest, MidSizeDataKeepsSlab) {
+    std::string buffer = pool.acquire();
+    buffer.assign(SLAB / 4, 'm');
+    const char* raw = buffer.data();
+    auto shared = pool.share(std::move(buffer));
+
+    EXPECT_EQ(shared->data(), raw);
+    EXPECT_GE(shared->capacity(), SLAB);
+}
+
+// The string and its control block come back to the pool and are handed out again
+TEST_F(ChunkMemoryPoolTest, HolderBlockIsReused) {
+    auto first = pool.share(fullSlab());
+    first.reset();
+    const size_t freeHolders = pool.statistics().freeHolders;
+    ASSERT_GT(freeHolders, 0u);
+
+    auto second = pool.share(fullSlab());
+    EXPECT_EQ(pool.statistics().freeHolders, freeHolders - 1);
+    second.reset();
+    EXPECT_EQ(pool.statistics().freeHolders, freeHolders);
+}
+
+// Buffers that are not slabs are freed, not pooled
+TEST_F(ChunkMemoryPoolTest, NonSlabBufferIsNotPooled) {
+    const auto before = pool.statistics();
+
+    auto shared = pool.share(std::string(100, 'a'));
+    shared.reset();
+
+    EXPECT_EQ(pool.statistics().free, before.free);
+    EXPECT_EQ(pool.statistics().inUse, before.inUse);
+}
+
+// The free list never grows beyond chunk_pool_size
+TEST_F(ChunkMemoryPoolTest, FreeListIsBounded) {
+    std::vector<std::shared_ptr<const std::string>> chunks;
+    for (int i = 0; i < 10; ++i) {
+        chunks.push_back(pool.share(fullSlab()));
+    }
+    chunks.clear();
+
+    EXPECT_EQ(pool.statistics().free, 4u);
+}
+
+// The high-water mark keeps the peak number of live chunks
+TEST_F(ChunkMemoryPoolTest, HighWaterKeepsPeak) {
+    const auto before = pool.statistics();
+
+    std::vector<std::shared_ptr<const std::string>> chunks;
+    for (size_t i = 0; i < before.highWater + 3; ++i) {
+        chunks.push_back(pool.share(fullSlab()));
+    }
+    const size_t peak = pool.statistics().inUse;
+    chunks.clear();
+
+    const auto after = pool.statistics();
+    EXPECT_EQ(after.highWater, peak);
+    EXPECT_EQ(after.inUse, before.inUse);
+    EXPECT_EQ(after.slabSize, SLAB);
+}
+
+// Slabs from a different max_chunk_size are not handed out
+TEST_F(ChunkMemoryPoolTest, SlabSizeChangeDropsOldSlabs) {
+    pool.share(fullSlab()).reset();
+    ASSERT_GT(pool.statistics().free, 0u);
+
+    Config::instance().setTransferSessionMaxChunkSize(SLAB * 4);
+    std::string buffer = pool.acquire();
+    EXPECT_GE(buffer.capacity(), SLAB * 4);
+}
+
+class BudgetEvents : public Subscriber<Event::ChunkMemoryPool> {
+public:
+    void update(Event::ChunkMemoryPool event, const std::monostate&) override {
+        events.push_back(event);
+    }
+    std::vector<Event::ChunkMemoryPool> events;
+
+protected:
+    BudgetEvents() = default;
+};
+
+// admit() refuses data the budget cannot take and leaves it with the caller
+TEST_F(ChunkMemoryPoolTest, AdmitRefusesOverBudget) {
+    Config::instance().setTransferSessionMemoryBudget(pool.statistics().bytesInUse + 2 * SLAB);
+
+    std::string first(SLAB, 'a');
+    std::string second(SLAB, 'b');
+    std::string third(SLAB, 'c');
+    auto a = pool.admit(first);
+    auto b = pool.admit(second);
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+
+    EXPECT_EQ(pool.admit(third), nullptr);
+    EXPECT_EQ(third, std::string(SLAB, 'c'));
+    EXPECT_FALSE(pool.budgetAvailable());
+
+    Config::instance().setTransferSessionMemoryBudget(0);
+}
+
+// Exhausted is published when less than one slab fits, available when two fit again
+TEST_F(ChunkMemoryPoolTest, BudgetStateIsPublishedWithHysteresis) {
+    auto subscriber = createSubscriber<BudgetEvents>();
+    pool.addSubscriber(subscriber);
+    Config::instance().setTransferSessionMemoryBudget(pool.statistics().bytesInUse + 3 * SLAB);
+
+    auto a = pool.share(std::string(SLAB, 'a'));
+    auto b = pool.share(std::string(SLAB, 'b'));
+    EXPECT_TRUE(pool.budgetAvailable());
+    EXPECT_TRUE(subscriber->events.empty());
+
+    auto c = pool.share(std::string(SLAB, 'c'));
+    EXPECT_FALSE(pool.budgetAvailable());
+    ASSERT_EQ(subscriber->events.size(), 1u);
+    EXPECT_EQ(subscriber->events.back(), Event::ChunkMemoryPool::budgetExhausted);
+
+    c.reset();
+    EXPECT_FALSE(pool.budgetAvailable());
+    EXPECT_EQ(subscriber->events.size(), 1u);
+
+    b.reset();
+    EXPECT_TRUE(pool.budgetAvailable());
+    ASSERT_EQ(subscriber->events.size(), 2u);
+    EXPECT_EQ(subscriber->events.back(), Event::ChunkMemoryPool::budgetAvailable);
+
+    pool.removeSubscriber(subscriber);
+    Config::instance().setTransferSessionMemoryBudget(0);
+}
@@ -56,20 +56,30 @@ TEST_F(ConfigTest, LoadValidFullConfig) {
         "[server]\n"
         "bind_address = 192.168.1.100\n"
         "bind_port = 8080\n"
+        "worker_threads = 6\n"
+        "executor_threads = 2\n"
+        "cpu_affinity = 0-3,8\n"
+        "pin_threads = true\n"
+        "session_strand = true\n"
         "\n"
         "[client]\n"
         "max_count = 1000\n"
         "without_captcha_threshold = 200\n"
         "captcha_lifetime = 300\n"
+        "captcha_pool_size = 8\n"
         "timeout = 120\n"
         "\n"
         "[session]\n"
         "count_limit = 50\n"
         "max_chunk_size = 1048576\n"
         "chunk_queue_max_size = 20\n"
+        "chunk_queue_max_bytes = 16777216\n"
         "max_lifetime = 3600\n"
         "max_consumer_count = 10\n"
         "max_initial_freeze_duration = 240\n"
+        "chunk_pool_size = 4\n"
+        "memory_budget = 8589934592\n"
+        "progress_interval_ms = 1000\n"
     );
 
     auto& cfg = Config::instance();
@@ -77,9 +87,15 @@ TEST_F(ConfigTest, LoadValidFullConfig) {
 
     EXPECT_EQ(cfg.bindAddress(), "192.168.1.100");
     EXPECT_EQ(cfg.bindPort(), 8080);
+    EXPECT_EQ(cfg.workerThreads(), 6u);
+    EXPECT_EQ(cfg.executorThreads(), 2u);
+    EXPECT_EQ(cfg.cpuAffinity(), "0-3,8");
+    EXPECT_TRUE(cfg.pinThreads());
+    EXPECT_TRUE(cfg.sessionStrand());
     EXPECT_EQ(cfg.apiMaxClientCount(), 1000u);
     EXPECT_EQ(cfg.apiWithoutCaptchaThreshold(), 200u);
     EXPECT_EQ(cfg.apiCaptchaLifetime(), 300u);
+    EXPECT_EQ(cfg.apiCaptchaPoolSize(), 8u);
     EXPECT_EQ(cfg.clientTimeout(), 120u);
     EXPECT_EQ(cfg.transferSessionCountLimit(), 50u);
     EXPECT_EQ(cfg.transferSessionMaxChunkSize(), 1048576u);
@@ -87,6 +103,10 @@ TEST_F(ConfigTest, LoadValidFullConfig) {
     EXPECT_EQ(cfg.transferSessionMaxLifetime(), 3600u);
     EXPECT_EQ(cfg.transferSessionMaxConsumerCount(), 10u);
     EXPECT_EQ(cfg.transferSessionMaxInitialFreezeDuration(), 240u);
+    EXPECT_EQ(cfg.transferSessionChunkPoolSize(), 4u);
+    EXPECT_EQ(cfg.transferSessionMemoryBudget(), 8589934592u);
+    EXPECT_EQ(cfg.transferSessionProgressInterval(), 1000u);
+    EXPECT_EQ(cfg.transferSessionChunkQueueMaxBytes(), 16777216u);
 }
 
 // 2. Load an empty INI file and verify all fields get their defaults.
@@ -98,9 +118,15 @@ TEST_F(ConfigTest, LoadDefaultValues) {
 
     EXPECT_EQ(cfg.bindAddress(), "0.0.0.0");
     EXPECT_EQ(cfg.bindPort(), 2233);
+    EXPECT_EQ(cfg.workerThreads(), 0u);
+    EXPECT_EQ(cfg.executorThreads(), 1u);
+    EXPECT_EQ(cfg.cpuAffinity(), "");
+    EXPECT_FALSE(cfg.pinThreads());
+    EXPECT_FALSE(cfg.sessionStrand());
     EXPECT_EQ(cfg.apiMaxClientCount(), 500u);
     EXPECT_EQ(cfg.apiWithoutCaptchaThreshold(), 500u);
     EXPECT_EQ(cfg.apiCaptchaLifetime(), 180u);
+    EXPECT_EQ(cfg.apiCaptchaPoolSize(), 32u);
     EXPECT_EQ(cfg.clientTimeout(), 60u);
     EXPECT_EQ(cfg.transferSessionCountLimit(), 100u);
     EXPECT_EQ(cfg.transferSessionMaxChunkSize(), 5242880u);
@@ -108,6 +134,10 @@ TEST_F(ConfigTest, LoadDefaultValues) {
     EXPECT_EQ(cfg.transferSessionMaxLifetime(), 7200u);
     EXPECT_EQ(cfg.transferSessionMaxConsumerCount(), 5u);
     EXPECT_EQ(cfg.transferSessionMaxInitialFreezeDuration(), 120u);
+    EXPECT_EQ(cfg.transferSessionChunkPoolSize(), 10u);
+    EXPECT_EQ(cfg.transferSessionMemoryBudget(), 0u);
+    EXPECT_EQ(cfg.transferSessionProgressInterval(), 250u);
+    EXPECT_EQ(cfg.transferSessionChunkQueueMaxBytes(), 0u);
 }
 
 // 3. Load INI with only [server] section; server fields are custom, all others are defaults.
@@ -129,6 +159,7 @@ TEST_F(ConfigTest, LoadPartialConfig) {
     EXPECT_EQ(cfg.apiMaxClientCount(), 500u);
     EXPECT_EQ(cfg.apiWithoutCaptchaThreshold(), 500u);
     EXPECT_EQ(cfg.apiCaptchaLifetime(), 180u);
+    EXPECT_EQ(cfg.apiCaptchaPoolSize(), 32u);
     EXPECT_EQ(cfg.clientTimeout(), 60u);
 
     // Session fields should be defaults
@@ -175,6 +206,7 @@ TEST_F(ConfigTest, OverridesSingleField) {
     EXPECT_EQ(cfg.apiMaxClientCount(), 500u);
     EXPECT_EQ(cfg.apiWithoutCaptchaThreshold(), 500u);
     EXPECT_EQ(cfg.apiCaptchaLifetime(), 180u);
+    EXPECT_EQ(cfg.apiCaptchaPoolSize(), 32u);
     EXPECT_EQ(cfg.clientTimeout(), 60u);
 
     // Remaining session defaults
@@ -0,0 +1,250 @@
+// Cross-checks of the accelerated SHA-256 and ChaCha20 code against the portable one,
+// and the ChaCha20 random generator
+
+#include "captcha/sha256_backend/sha256.h"
+#include "captcha/chacha20_backend/chacha20_simd.h"
+#include "captcha/chacha20_backend/portable8439.h"
+#include "captcha/chacha20_backend/chacha20_drbg.h"
+#include "captcha/skaptcha_tools.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using tools::SHA256;
+
+namespace {
+
+const SHA256::Implementation ALL_IMPLEMENTATIONS[] = {
+    SHA256::Implementation::portable,
+    SHA256::Implementation::shaNi,
+    SHA256::Implementation::armv8
+};
+
+std::string hexDigest(SHA256::Implementation implementation, const std::string& data)
+{
+    SHA256 sha(implementation);
+    sha.update(data);
+    return SHA256::toString(sha.digest());
+}
+
+// RFC 8439, 2.3: the straightforward scalar block function
+void referenceBlock(const uint32_t state[16], uint8_t out[64])
+{
+    auto rotl = [](uint32_t x, int n) { return (x << n) | (x >> (32 - n)); };
+    auto quarter = [&](uint32_t* x, int a, int b, int c, int d) {
+        x[a] += x[b]; x[d] ^= x[a]; x[d] = rotl(x[d], 16);
+        x[c] += x[d]; x[b] ^= x[c]; x[b] = rotl(x[b], 12);
+        x[a] += x[b]; x[d] ^= x[a]; x[d] = rotl(x[d], 8);
+        x[c] += x[d]; x[b] ^= x[c]; x[b] = rotl(x[b], 7);
+    };
+
+    uint32_t x[16];
+    std::memcpy(x, state, sizeof(x));
+    for (int i = 0; i < 10; ++i) {
+        quarter(x, 0, 4, 8, 12);
+        quarter(x, 1, 5, 9, 13);
+        quarter(x, 2, 6, 10, 14);
+        quarter(x, 3, 7, 11, 15);
+        quarter(x, 0, 5, 10, 15);
+        quarter(x, 1, 6, 11, 12);
+        quarter(x, 2, 7, 8, 13);
+        quarter(x, 3, 4, 9, 14);
+    }
+    for (int i = 0; i < 16; ++i) {
+        const uint32_t word = x[i] + state[i];
+        for (int b = 0; b < 4; ++b) {
+            out[i * 4 + b] = static_cast<uint8_t>(word >> (8 * b));
+        }
+    }
+}
+
+// Key 00:01:..:1f, nonce 00:00:00:09:00:00:00:4a:00:00:00:00 (RFC 8439, 2.3.2)
+std::array<uint32_t, 16> rfcState(uint32_t counter)
+{
+    return { 0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+             0x03020100, 0x07060504, 0x0b0a0908, 0x0f0e0d0c,
+             0x13121110, 0x17161514, 0x1b1a1918, 0x1f1e1d1c,
+             counter, 0x09000000, 0x4a000000, 0x00000000 };
+}
+
+} // namespace
+
+// Test vectors from FIPS 180-2
+TEST(Sha256Test, KnownDigests) {
+    for (auto implementation : ALL_IMPLEMENTATIONS) {
+        SCOPED_TRACE(SHA256::implementationName(implementation));
+        EXPECT_EQ(hexDigest(implementation, ""),
+                  "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+        EXPECT_EQ(hexDigest(implementation, "abc"),
+                  "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+        EXPECT_EQ(hexDigest(implementation, "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+                  "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+        EXPECT_EQ(hexDigest(implementation, std::string(1000000, 'a')),
+                  "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+    }
+}
+
+// Every implementation agrees with the portable one, whatever the update() split
+TEST(Sha256Test, ImplementationsAgreeWithPortable) {
+    std::mt19937 random(42);
+    for (size_t length = 0; length < 600; ++length) {
+        std::string data(length, '\0');
+        for (auto& ch : data) {
+            ch = static_cast<char>(random());
+        }
+        const std::string expected = hexDigest(SHA256::Implementation::portable, data);
+        const size_t split = length ? random() % length : 0;
+
+        for (auto implementation : ALL_IMPLEMENTATIONS) {
+            SHA256 sha(implementation);
+            sha.update(reinterpret_cast<const uint8_t*>(data.data()), split);
+            sha.update(reinterpret_cast<const uint8_t*>(data.data()) + split, length - split);
+            ASSERT_EQ(SHA256::toString(sha.digest()), expected)
+                << SHA256::implementationName(implementation) << ", length " << length;
+        }
+    }
+}
+
+// The default instance uses the best supported implementation
+TEST(Sha256Test, BestImplementationIsSupported) {
+    EXPECT_TRUE(SHA256::isSupported(SHA256::bestImplementation()));
+    EXPECT_TRUE(SHA256::isSupported(SHA256::Implementation::portable));
+}
+
+// The scalar reference itself matches the RFC
+TEST(ChaCha20Test, ReferenceBlockMatchesRfc) {
+    const uint8_t expected[64] = {
+        0x10, 0xf1, 0xe7, 0xe4, 0xd1, 0x3b, 0x59, 0x15, 0x50, 0x0f, 0xdd, 0x1f, 0xa3, 0x20, 0x71, 0xc4,
+        0xc7, 0xd1, 0xf4, 0xc7, 0x33, 0xc0, 0x68, 0x03, 0x04, 0x22, 0xaa, 0x9a, 0xc3, 0xd4, 0x6c, 0x4e,
+        0xd2, 0x82, 0x64, 0x46, 0x07, 0x9f, 0xaa, 0x09, 0x14, 0xc2, 0xd7, 0x05, 0xd9, 0x8b, 0x02, 0xa2,
+        0xb5, 0x12, 0x9c, 0xd1, 0xde, 0x16, 0x4e, 0xb9, 0xcb, 0xd0, 0x83, 0xe8, 0xa2, 0x50, 0x3c, 0x4e
+    };
+    uint8_t block[64];
+    referenceBlock(rfcState(1).data(), block);
+    EXPECT_EQ(std::memcmp(block, expected, sizeof(block)), 0);
+}
+
+// The vector keystream equals the scalar one for any batch size, including counter wrap-around
+TEST(ChaCha20Test, SimdKeystreamMatchesReference) {
+    const size_t maxBlocks = 20;
+    for (uint32_t firstCounter : {0u, 1u, 0xfffffffcu}) {
+        const auto state = rfcState(firstCounter);
+        for (size_t blocks = 1; blocks <= maxBlocks; ++blocks) {
+            std::vector<uint8_t> simd(blocks * 64 + 1, 0xee);
+            const size_t written = chacha20_simd_keystream(state.data(), simd.data(), blocks);
+            if (written == 0) {
+                GTEST_SKIP() << "no vector code for this target";
+            }
+            ASSERT_EQ(written, blocks);
+            EXPECT_EQ(simd.back(), 0xee) << "wrote past the requested blocks";
+
+            for (size_t b = 0; b < blocks; ++b) {
+                auto blockState = state;
+                blockState[12] += static_cast<uint32_t>(b);
+                uint8_t expected[64];
+                referenceBlock(blockState.data(), expected);
+                ASSERT_EQ(std::memcmp(simd.data() + b * 64, expected, 64), 0)
+                    << chacha20_simd_name() << ", counter " << firstCounter << ", block " << b << " of " << blocks;
+            }
+        }
+    }
+}
+
+// Encryption round-trips and a changed byte is rejected, across the batch boundaries
+TEST(ChaCha20Test, AeadRoundTrip) {
+    std::mt19937 random(7);
+    uint8_t key[RFC_8439_KEY_SIZE];
+    uint8_t nonce[RFC_8439_NONCE_SIZE];
+    for (auto& byte : key) byte = static_cast<uint8_t>(random());
+    for (auto& byte : nonce) byte = static_cast<uint8_t>(random());
+
+    for (size_t length : {0, 1, 47, 64, 65, 128, 191, 192, 193, 448, 449, 511, 512, 513, 1500}) {
+        std::vector<uint8_t> plain(length);
+        for (auto& byte : plain) byte = static_cast<uint8_t>(random());
+        std::vector<uint8_t> cipher(length + RFC_8439_TAG_SIZE);
+        std::vector<uint8_t> decrypted(length);
+
+        ASSERT_EQ(portable_chacha20_poly1305_encrypt(cipher.data(), key, nonce, nullptr, 0, plain.data(), length),
+                  length + RFC_8439_TAG_SIZE);
+        ASSERT_EQ(portable_chacha20_poly1305_decrypt(decrypted.data(), key, nonce, nullptr, 0, cipher.data(), cipher.size()),
+                  length);
+        EXPECT_EQ(decrypted, plain) << "length " << length;
+
+        cipher[length / 2] ^= 1;
+        EXPECT_EQ(portable_chacha20_poly1305_decrypt(decrypted.data(), key, nonce, nullptr, 0, cipher.data(), cipher.size()),
+                  static_cast<size_t>(-1)) << "length " << length;
+    }
+}
+
+// Consecutive calls, other threads and a reseeded thread all get different bytes
+TEST(ChaCha20DrbgTest, OutputIsNotRepeated) {
+    std::array<uint8_t, 32> first {}, second {}, reseeded {}, otherThread {};
+    chacha20_drbg_fill(first.data(), first.size());
+    chacha20_drbg_fill(second.data(), second.size());
+    chacha20_drbg_reseed();
+    chacha20_drbg_fill(reseeded.data(), reseeded.size());
+    std::thread([&]() { chacha20_drbg_fill(otherThread.data(), otherThread.size()); }).join();
+
+    EXPECT_NE(first, second);
+    EXPECT_NE(first, reseeded);
+    EXPECT_NE(second, reseeded);
+    EXPECT_NE(first, otherThread);
+    EXPECT_NE(reseeded, otherThread);
+}
+
+// Long output crosses many batches and the reseed threshold without wiped (zero) blocks
+TEST(ChaCha20DrbgTest, LongOutputLooksUniform) {
+    std::vector<uint8_t> data(3 * CHACHA20_DRBG_RESEED_BYTES + 123);
+    // odd sizes, so the reads do not line up with the batches
+    for (size_t done = 0; done < data.size(); ) {
+        const size_t size = std::min<size_t>(data.size() - done, 1 + done % 1000);
+        chacha20_drbg_fill(data.data() + done, size);
+        done += size;
+    }
+
+    std::array<size_t, 256> histogram {};
+    for (auto byte : data) {
+        ++histogram[byte];
+    }
+    const double expected = data.size() / 256.0;
+    for (size_t value = 0; value < histogram.size(); ++value) {
+        EXPECT_NEAR(histogram[value], expected, expected * 0.05) << "byte " << value;
+    }
+
+    const std::vector<uint8_t> zeros(16, 0);
+    for (size_t i = 0; i + zeros.size() <= data.size(); i += zeros.size()) {
+        ASSERT_FALSE(std::equal(zeros.begin(), zeros.end(), data.begin() + i)) << "at " << i;
+    }
+}
+
+TEST(ChaCha20DrbgTest, UniformCoversTheRange) {
+    for (uint32_t bound : {1u, 2u, 7u, 33u}) {
+        std::vector<size_t> counts(bound);
+        const size_t draws = 2000 * bound;
+        for (size_t i = 0; i < draws; ++i) {
+            const uint32_t value = chacha20_drbg_uniform(bound);
+            ASSERT_LT(value, bound);
+            ++counts[value];
+        }
+        for (uint32_t value = 0; value < bound; ++value) {
+            EXPECT_NEAR(counts[value], 2000, 300) << "bound " << bound << ", value " << value;
+        }
+    }
+}
+
+// Lengths past 127 used to be cut short by an int8_t loop counter
+TEST(ChaCha20DrbgTest, SimpleRandomHasTheRequestedLength) {
+    for (size_t length : {0, 1, 12, 32, 200, 5000}) {
+        const std::string random = skaptcha_tools::string::simpleRandom(length);
+        ASSERT_EQ(random.size(), length);
+        if (length >= 32) {
+            EXPECT_NE(random.substr(length - 16), std::string(16, '\0'));
+        }
+    }
+}
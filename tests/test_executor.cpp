@@ -0,0 +1,100 @@
+// Tests for Executor
+
+#include "log.h"
+#include <plog/Appenders/ConsoleAppender.h>
+
+struct PlogInit {
+    PlogInit() {
+        static plog::ConsoleAppender<plog::TxtFormatter> appender;
+        static bool initialized = false;
+        if (!initialized) {
+            plog::init(plog::none, &appender);
+            initialized = true;
+        }
+    }
+};
+static PlogInit plogInit;
+
+#include "executor.h"
+#include "config/config.h"
+#include "clientlist.h"
+#include "client.h"
+
+#include <gtest/gtest.h>
+#include <asio.hpp>
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <set>
+#include <thread>
+#include <vector>
+
+using CpuList = std::vector<unsigned>;
+
+TEST(ExecutorTest, ParsesCpuLists) {
+    CpuList cpus;
+    ASSERT_TRUE(Executor::parseCpuList("0", cpus));
+    EXPECT_EQ(cpus, CpuList({0}));
+    ASSERT_TRUE(Executor::parseCpuList("0-3,8", cpus));
+    EXPECT_EQ(cpus, CpuList({0, 1, 2, 3, 8}));
+    ASSERT_TRUE(Executor::parseCpuList("2,4-5", cpus));
+    EXPECT_EQ(cpus, CpuList({2, 4, 5}));
+    ASSERT_TRUE(Executor::parseCpuList("7-7", cpus));
+    EXPECT_EQ(cpus, CpuList({7}));
+}
+
+TEST(ExecutorTest, RejectsMalformedCpuLists) {
+    CpuList cpus;
+    for (const char* text : {"", ",", "a", "1,", "3-1", "1-", "-1", "0-3x", "1;2", "5000"}) {
+        EXPECT_FALSE(Executor::parseCpuList(text, cpus)) << '"' << text << '"';
+    }
+}
+
+TEST(ExecutorTest, CpuOutsideTheSetIsRefused) {
+    EXPECT_FALSE(Executor::restrictProcessTo({100000}));
+}
+
+TEST(ExecutorTest, AvailableCpuCountIsPositive) {
+    EXPECT_GE(Executor::availableCpuCount(), 1u);
+}
+
+// With an empty cpu_affinity the threads are pinned over these
+TEST(ExecutorTest, AllowedCpusMatchTheMask) {
+    const auto cpus = Executor::allowedCpus();
+#ifdef __linux__
+    EXPECT_EQ(cpus.size(), Executor::availableCpuCount());
+#endif
+    EXPECT_TRUE(std::is_sorted(cpus.begin(), cpus.end()));
+}
+
+// The threads start on first use and run posted work off the calling thread
+TEST(ExecutorTest, RunsPostedWork) {
+    Config::instance().setExecutorThreads(2);
+    auto& executor = Executor::instance();
+
+    std::promise<std::thread::id> ranOn;
+    asio::post(executor.ioContext(), [&]() { ranOn.set_value(std::this_thread::get_id()); });
+    auto future = ranOn.get_future();
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_NE(future.get(), std::this_thread::get_id());
+    EXPECT_EQ(executor.threadCount(), 2u);
+
+    // Later starts change nothing
+    Config::instance().setExecutorThreads(5);
+    executor.start();
+    EXPECT_EQ(executor.threadCount(), 2u);
+}
+
+// The client registry has no thread of its own any more, its timeouts run on the executor
+TEST(ExecutorTest, ClientTimeoutsStillFire) {
+    Config::instance().setClientTimeout(1);
+    const std::string id = ClientList::generateIdCondidate();
+    ASSERT_NE(ClientList::instanse().create(id), nullptr);
+
+    // the client is removed by its timeout, on an executor thread
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (ClientList::instanse().get(id) and std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    EXPECT_EQ(ClientList::instanse().get(id), nullptr);
+}
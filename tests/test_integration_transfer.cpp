@@ -21,12 +21,16 @@ static PlogInit plogInit;
 #include "transfersession.h"
 #include "client.h"
 #include "buffer.h"
+#include "serializableevent.h"
 
 #include <gtest/gtest.h>
 #include <string>
 #include <vector>
 #include <thread>
 #include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <future>
 
 class TransferIntegrationTest : public ::testing::Test {
 protected:
@@ -34,12 +38,14 @@ protected:
         auto& cfg = Config::instance();
         cfg.setTransferSessionMaxChunkSize(1024 * 1024);      // 1 MB
         cfg.setTransferSessionChunkQueueMaxSize(10);           // max 10 chunks in buffer
+        cfg.setTransferSessionChunkQueueMaxBytes(0);           // chunk-count mode
         cfg.setTransferSessionMaxConsumerCount(5);             // max 5 receivers
         cfg.setClientTimeout(60);                              // 60 seconds
         cfg.setTransferSessionMaxLifetime(3600);               // 1 hour
         cfg.setTransferSessionMaxInitialFreezeDuration(120);   // 2 minutes
         cfg.setTransferSessionCountLimit(100);                 // max 100 sessions
         cfg.setApiMaxClientCount(500);                         // max 500 clients
+        cfg.setTransferSessionMemoryBudget(0);                 // unlimited
     }
 
     void TearDown() override {
@@ -133,7 +139,7 @@ TEST_F(TransferIntegrationTest, FullTransferFlow) {
     EXPECT_EQ(downloaded->size(), 512u);
     // Verify contents byte by byte
     for (size_t i = 0; i < downloaded->size(); ++i) {
-        EXPECT_EQ((*downloaded)[i], 0xAB) << "Mismatch at byte " << i;
+        EXPECT_EQ(static_cast<uint8_t>((*downloaded)[i]), 0xAB) << "Mismatch at byte " << i;
     }
 
     // 11. Set EOF (must be set before final confirmation so the auto-removal
@@ -197,6 +203,109 @@ TEST_F(TransferIntegrationTest, BufferOverflowPrevention) {
     EXPECT_TRUE(session->addChunk(smallChunk));
 }
 
+// ---------------------------------------------------------------------------
+// ByteWindowNotifiesSenderOnThreshold
+// In byte mode the sender is paused and resumed by the buffered byte count,
+// not by the number of chunks.
+// ---------------------------------------------------------------------------
+class ChunkAllowanceRecorder : public Subscriber<Event::TransferSessionForSender> {
+public:
+    void update(Event::TransferSessionForSender, const Event::Data::NewChunkAllowance& data) override {
+        allowed.push_back(data.allowed);
+    }
+    std::vector<bool> allowed;
+
+protected:
+    ChunkAllowanceRecorder() = default;
+};
+
+TEST_F(TransferIntegrationTest, ByteWindowNotifiesSenderOnThreshold) {
+    Config::instance().setTransferSessionChunkQueueMaxBytes(1000);
+
+    auto sender = createClient("sender_bytes_1");
+    auto receiver = createClient("receiver_bytes_1");
+    ASSERT_NE(sender, nullptr);
+    ASSERT_NE(receiver, nullptr);
+
+    auto [session, timeout] = createSession(sender);
+    ASSERT_NE(session, nullptr);
+    EXPECT_TRUE(sender->joinSession(session->id()));
+    EXPECT_TRUE(receiver->joinSession(session->id()));
+    EXPECT_TRUE(session->addReceiver(receiver));
+    EXPECT_TRUE(session->setFileInfo({"bytes.bin", 4000}));
+    session->dropInitialChunksFreeze();
+
+    auto recorder = createSubscriber<ChunkAllowanceRecorder>();
+    session->Publisher<Event::TransferSessionForSender>::addSubscriber(recorder);
+
+    // 19 small chunks stay below the window, more than chunk_queue_max_size
+    std::string smallChunk(50, '\x01');
+    for (int i = 0; i < 19; ++i) {
+        EXPECT_TRUE(session->addChunk(smallChunk)) << "Chunk " << i << " should succeed";
+    }
+    EXPECT_TRUE(recorder->allowed.empty());
+
+    // The 20th reaches 1000 bytes: the sender is paused once
+    EXPECT_TRUE(session->addChunk(smallChunk));
+    EXPECT_EQ(recorder->allowed, (std::vector<bool>{false}));
+    EXPECT_FALSE(session->addChunk(smallChunk));
+
+    // Freeing 50 bytes reopens the window
+    session->setChunkAsReceived(1, receiver);
+    EXPECT_EQ(recorder->allowed, (std::vector<bool>{false, true}));
+    EXPECT_TRUE(session->addChunk(smallChunk));
+
+    Config::instance().setTransferSessionChunkQueueMaxBytes(0);
+}
+
+// ---------------------------------------------------------------------------
+// MemoryBudgetPausesAllSenders
+// Once the server-wide memory budget cannot take another max-sized chunk,
+// every session stops accepting chunks. Freeing the chunks of one session
+// resumes the others.
+// ---------------------------------------------------------------------------
+TEST_F(TransferIntegrationTest, MemoryBudgetPausesAllSenders) {
+    const size_t chunkSize = Config::instance().transferSessionMaxChunkSize();
+    Config::instance().setTransferSessionMemoryBudget(3 * chunkSize);
+
+    auto senderA = createClient("sender_budget_a");
+    auto senderB = createClient("sender_budget_b");
+    auto receiverA = createClient("receiver_budget_a");
+    ASSERT_NE(senderA, nullptr);
+    ASSERT_NE(senderB, nullptr);
+    ASSERT_NE(receiverA, nullptr);
+
+    auto [sessionA, timeoutA] = createSession(senderA);
+    auto [sessionB, timeoutB] = createSession(senderB);
+    ASSERT_NE(sessionA, nullptr);
+    ASSERT_NE(sessionB, nullptr);
+    EXPECT_TRUE(senderA->joinSession(sessionA->id()));
+    EXPECT_TRUE(senderB->joinSession(sessionB->id()));
+    EXPECT_TRUE(receiverA->joinSession(sessionA->id()));
+    EXPECT_TRUE(sessionA->addReceiver(receiverA));
+    EXPECT_TRUE(sessionA->setFileInfo({"budget.bin", 3 * chunkSize}));
+    sessionA->dropInitialChunksFreeze();
+
+    EXPECT_TRUE(sessionA->addChunk(std::string(chunkSize, 'a')));
+    EXPECT_TRUE(sessionA->addChunk(std::string(chunkSize, 'b')));
+    EXPECT_TRUE(sessionB->newChunkIsAllowed());
+
+    // The third chunk fills the budget: both senders are paused
+    EXPECT_TRUE(sessionA->addChunk(std::string(chunkSize, 'c')));
+    EXPECT_FALSE(sessionA->newChunkIsAllowed());
+    EXPECT_FALSE(sessionB->newChunkIsAllowed());
+    EXPECT_FALSE(sessionB->addChunk(std::string(100, 'x')));
+
+    // One freed chunk is not enough to resume (hysteresis), two are
+    sessionA->setChunkAsReceived(1, receiverA);
+    EXPECT_FALSE(sessionB->newChunkIsAllowed());
+    sessionA->setChunkAsReceived(2, receiverA);
+    EXPECT_TRUE(sessionB->newChunkIsAllowed());
+    EXPECT_TRUE(sessionB->addChunk(std::string(100, 'x')));
+
+    Config::instance().setTransferSessionMemoryBudget(0);
+}
+
 // ---------------------------------------------------------------------------
 // ReceiverDisconnect
 // One receiver is removed mid-transfer; session continues with the other.
@@ -573,3 +682,174 @@ TEST_F(TransferIntegrationTest, InitialFreezePreservesChunks) {
     EXPECT_EQ(session->getChunk(1, receiver), nullptr);
     EXPECT_EQ(session->getChunk(2, receiver), nullptr);
 }
+
+// ---------------------------------------------------------------------------
+// SessionStrandSerializesWork
+// With session_strand the work handed to a session from many threads runs
+// one at a time, off the calling threads.
+// Without it the work runs right away on the caller.
+// ---------------------------------------------------------------------------
+TEST_F(TransferIntegrationTest, SessionStrandSerializesWork) {
+    auto inlineSender = createClient("sender_strand_0");
+    ASSERT_NE(inlineSender, nullptr);
+    auto [inlineSession, inlineTimeout] = createSession(inlineSender);
+    ASSERT_NE(inlineSession, nullptr);
+    EXPECT_FALSE(inlineSession->serialized());
+    std::thread::id ranOn;
+    inlineSession->execute([&]() { ranOn = std::this_thread::get_id(); });
+    EXPECT_EQ(ranOn, std::this_thread::get_id());
+
+    Config::instance().setSessionStrand(true);
+    auto sender = createClient("sender_strand_1");
+    ASSERT_NE(sender, nullptr);
+    auto [session, timeout] = createSession(sender);
+    Config::instance().setSessionStrand(false);
+    ASSERT_NE(session, nullptr);
+    EXPECT_TRUE(session->serialized());
+    EXPECT_TRUE(sender->joinSession(session->id()));
+
+    const int numThreads = 4;
+    const int chunksPerThread = 2;
+    std::atomic<int> inFlight {0};
+    std::atomic<int> maxInFlight {0};
+    std::atomic<int> done {0};
+    std::atomic<int> ranOnCaller {0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            const auto caller = std::this_thread::get_id();
+            for (int i = 0; i < chunksPerThread; ++i) {
+                session->execute([&, caller, t]() {
+                    maxInFlight = std::max(maxInFlight.load(), ++inFlight);
+                    if (std::this_thread::get_id() == caller) {
+                        ranOnCaller.fetch_add(1);
+                    }
+                    EXPECT_TRUE(session->addChunk(std::string(100, char('a' + t))));
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                    --inFlight;
+                    done.fetch_add(1);
+                });
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (done.load() < numThreads * chunksPerThread and std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(done.load(), numThreads * chunksPerThread);
+    EXPECT_EQ(maxInFlight.load(), 1);
+    EXPECT_EQ(ranOnCaller.load(), 0);
+
+    std::promise<size_t> maxIndex;
+    session->execute([&]() { maxIndex.set_value(session->currentMaxChunkIndex()); });
+    EXPECT_EQ(maxIndex.get_future().get(), size_t(numThreads * chunksPerThread));
+}
+
+// ---------------------------------------------------------------------------
+// SessionStrandRemovesDestroyedMembers
+// With session_strand a member destroyed on another thread (meLeave, client
+// timeout) reaches the session through its strand.
+// ---------------------------------------------------------------------------
+TEST_F(TransferIntegrationTest, SessionStrandRemovesDestroyedMembers) {
+    Config::instance().setSessionStrand(true);
+    auto sender = createClient("sender_strand_2");
+    ASSERT_NE(sender, nullptr);
+    auto [session, timeout] = createSession(sender);
+    Config::instance().setSessionStrand(false);
+    ASSERT_NE(session, nullptr);
+    EXPECT_TRUE(sender->joinSession(session->id()));
+
+    auto receiver = createClient("receiver_strand_2");
+    ASSERT_NE(receiver, nullptr);
+    const std::string receiverToken = receiver->id();
+    std::promise<bool> added;
+    session->execute([&]() { added.set_value(session->addReceiver(receiver)); });
+    ASSERT_TRUE(added.get_future().get());
+    ASSERT_TRUE(receiver->joinSession(session->id()));
+
+    receiver.reset();
+    ClientList::instanse().remove(receiverToken);
+
+    size_t receiverCount = 1;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (receiverCount > 0 and std::chrono::steady_clock::now() < deadline) {
+        std::promise<size_t> count;
+        session->execute([&]() { count.set_value(session->receivers().size()); });
+        receiverCount = count.get_future().get();
+        if (receiverCount > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    EXPECT_EQ(receiverCount, 0u);
+}
+
+// ---------------------------------------------------------------------------
+// EventsAreSerializedOncePerPublish
+// Every member of a session gets the very same frame for an event,
+// serialized by the session once.
+// ---------------------------------------------------------------------------
+class FrameRecorder : public Subscriber<Event::TransferSession> {
+public:
+    void update(Event::TransferSession event, const Payload& data) override {
+        if (event == Event::TransferSession::newChunkIsAvailable) {
+            frames.push_back(std::get<SerializableEvent::Frames>(data).json);
+            binaryFrames.push_back(std::get<SerializableEvent::Frames>(data).binary);
+        }
+    }
+    std::vector<SerializableEvent::Frame> frames;
+    std::vector<SerializableEvent::Frame> binaryFrames;
+
+protected:
+    FrameRecorder() = default;
+};
+
+TEST_F(TransferIntegrationTest, EventsAreSerializedOncePerPublish) {
+    auto sender = createClient("sender_frame_1");
+    ASSERT_NE(sender, nullptr);
+    auto [session, timeout] = createSession(sender);
+    ASSERT_NE(session, nullptr);
+
+    std::vector<std::shared_ptr<FrameRecorder>> recorders;
+    for (int i = 0; i < 3; ++i) {
+        recorders.push_back(createSubscriber<FrameRecorder>());
+        session->Publisher<Event::TransferSession>::addSubscriber(recorders.back());
+    }
+
+    EXPECT_TRUE(session->addChunk(std::string(100, '\x01')));
+
+    for (const auto& recorder : recorders) {
+        ASSERT_EQ(recorder->frames.size(), 1u);
+        EXPECT_EQ(recorder->frames[0], recorders[0]->frames[0]);
+    }
+    EXPECT_EQ(*recorders[0]->frames[0], (SerializableEvent::NewChunkAvailable{1, 100}.json()));
+}
+
+// ---------------------------------------------------------------------------
+// BinaryFrameOnlyWithBinaryMembers
+// The binary form of an event is serialized only while some member is
+// connected over the binary subprotocol.
+// ---------------------------------------------------------------------------
+TEST_F(TransferIntegrationTest, BinaryFrameOnlyWithBinaryMembers) {
+    auto sender = createClient("sender_frame_2");
+    ASSERT_NE(sender, nullptr);
+    auto [session, timeout] = createSession(sender);
+    ASSERT_NE(session, nullptr);
+    auto recorder = createSubscriber<FrameRecorder>();
+    session->Publisher<Event::TransferSession>::addSubscriber(recorder);
+
+    EXPECT_TRUE(session->addChunk(std::string(100, '\x01')));
+    session->binaryMemberConnected();
+    EXPECT_TRUE(session->addChunk(std::string(100, '\x02')));
+    session->binaryMemberDisconnected();
+    EXPECT_TRUE(session->addChunk(std::string(100, '\x03')));
+
+    ASSERT_EQ(recorder->binaryFrames.size(), 3u);
+    EXPECT_EQ(recorder->binaryFrames[0], nullptr);
+    ASSERT_NE(recorder->binaryFrames[1], nullptr);
+    EXPECT_EQ(*recorder->binaryFrames[1], (SerializableEvent::NewChunkAvailable{2, 100}.binary()));
+    EXPECT_EQ(recorder->binaryFrames[2], nullptr);
+}
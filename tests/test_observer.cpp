@@ -20,18 +20,22 @@ static PlogInit plogInit;
 
 #include "observerpattern.h"
 
+#include <atomic>
+#include <thread>
+
 enum class TestEvent { eventA, eventB };
+template<> struct EventPayload<TestEvent> { using Type = std::variant<std::monostate, int, std::string>; };
 
 class TestSubscriber : public Subscriber<TestEvent> {
 public:
-    void update(TestEvent event, std::any data) override {
+    void update(TestEvent event, const Payload& data) override {
         lastEvent = event;
         callCount++;
         lastData = data;
     }
     TestEvent lastEvent = TestEvent::eventA;
     int callCount = 0;
-    std::any lastData;
+    Payload lastData;
 
 protected:
     TestSubscriber() = default;
@@ -87,11 +91,11 @@ TEST(ObserverTest, NotifySubscribersCallsUpdateWithCorrectEventAndData) {
 
     EXPECT_EQ(sub1->lastEvent, TestEvent::eventB);
     EXPECT_EQ(sub1->callCount, 1);
-    EXPECT_EQ(std::any_cast<std::string>(sub1->lastData), "hello");
+    EXPECT_EQ(std::get<std::string>(sub1->lastData), "hello");
 
     EXPECT_EQ(sub2->lastEvent, TestEvent::eventB);
     EXPECT_EQ(sub2->callCount, 1);
-    EXPECT_EQ(std::any_cast<std::string>(sub2->lastData), "hello");
+    EXPECT_EQ(std::get<std::string>(sub2->lastData), "hello");
 }
 
 TEST(ObserverTest, ExpiredWeakPtrSubscribersCleanedUpDuringNotify) {
@@ -106,7 +110,7 @@ TEST(ObserverTest, ExpiredWeakPtrSubscribersCleanedUpDuringNotify) {
     }
     // sub2 is now destroyed, its weak_ptr is expired
 
-    publisher.notifySubscribers(TestEvent::eventA, std::any{});
+    publisher.notifySubscribers(TestEvent::eventA, std::monostate{});
 
     // After notify, expired subscribers are cleaned up
     EXPECT_EQ(publisher.countSubscribers(), 1u);
@@ -120,7 +124,7 @@ TEST(ObserverTest, SubscriberNotNotifiedAfterRemoval) {
     publisher.addSubscriber(sub);
     publisher.removeSubscriber(sub);
 
-    publisher.notifySubscribers(TestEvent::eventB, std::any{});
+    publisher.notifySubscribers(TestEvent::eventB, std::monostate{});
     EXPECT_EQ(sub->callCount, 0);
 }
 
@@ -134,6 +138,82 @@ TEST(ObserverTest, DuplicateSubscriberNotAddedTwice) {
     EXPECT_EQ(publisher.countSubscribers(), 1u);
 
     // Verify it only gets notified once
-    publisher.notifySubscribers(TestEvent::eventA, std::any{});
+    publisher.notifySubscribers(TestEvent::eventA, std::monostate{});
+    EXPECT_EQ(sub->callCount, 1);
+}
+
+// A subscriber may change the subscriptions from its own update(); the running notification keeps its snapshot
+TEST(ObserverTest, SubscribersMayChangeDuringNotify) {
+    class Resubscriber : public Subscriber<TestEvent> {
+    public:
+        void update(TestEvent, const Payload&) override {
+            callCount++;
+            publisher->removeSubscriber(self.lock());
+            publisher->addSubscriber(other);
+        }
+        Publisher<TestEvent>* publisher = nullptr;
+        std::weak_ptr<Subscriber<TestEvent>> self;
+        std::shared_ptr<Subscriber<TestEvent>> other;
+        int callCount = 0;
+    protected:
+        Resubscriber() = default;
+    };
+
+    TestPublisher publisher;
+    auto sub = createSubscriber<Resubscriber>();
+    auto other = createSubscriber<TestSubscriber>();
+    sub->publisher = &publisher;
+    sub->self = sub;
+    sub->other = other;
+    publisher.addSubscriber(sub);
+
+    publisher.notifySubscribers(TestEvent::eventA, std::monostate{});
+    EXPECT_EQ(sub->callCount, 1);
+    EXPECT_EQ(other->callCount, 0);
+
+    publisher.notifySubscribers(TestEvent::eventB, std::monostate{});
     EXPECT_EQ(sub->callCount, 1);
+    EXPECT_EQ(other->callCount, 1);
+    EXPECT_EQ(publisher.countSubscribers(), 1u);
+}
+
+// Notifications run concurrently with subscribers joining and leaving
+TEST(ObserverTest, ConcurrentNotifyAndChurn) {
+    class CountingSubscriber : public Subscriber<TestEvent> {
+    public:
+        void update(TestEvent, const Payload&) override { calls.fetch_add(1); }
+        std::atomic<int> calls {0};
+    protected:
+        CountingSubscriber() = default;
+    };
+
+    TestPublisher publisher;
+    auto stable = createSubscriber<CountingSubscriber>();
+    publisher.addSubscriber(stable);
+
+    const int notifications = 20000;
+    std::atomic<bool> done {false};
+    std::thread churn([&]() {
+        bool remove = false;
+        while (not done) {
+            // half of them are removed, the others just expire
+            auto transient = createSubscriber<CountingSubscriber>();
+            publisher.addSubscriber(transient);
+            if ((remove = not remove)) {
+                publisher.removeSubscriber(transient);
+            }
+        }
+    });
+    std::thread notifier([&]() {
+        for (int i = 0; i < notifications; ++i) {
+            publisher.notifySubscribers(TestEvent::eventA, i);
+        }
+    });
+    notifier.join();
+    done = true;
+    churn.join();
+
+    EXPECT_EQ(stable->calls.load(), notifications);
+    publisher.notifySubscribers(TestEvent::eventA, std::monostate{});
+    EXPECT_EQ(publisher.countSubscribers(), 1u);
 }
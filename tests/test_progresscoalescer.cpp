@@ -0,0 +1,125 @@
+// Tests for ProgressCoalescer
+
+#include "log.h"
+#include <plog/Appenders/ConsoleAppender.h>
+
+struct PlogInit {
+    PlogInit() {
+        static plog::ConsoleAppender<plog::TxtFormatter> appender;
+        static bool initialized = false;
+        if (!initialized) {
+            plog::init(plog::none, &appender);
+            initialized = true;
+        }
+    }
+};
+static PlogInit plogInit;
+
+#include "progresscoalescer.h"
+
+#include <gtest/gtest.h>
+#include <asio.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+class ProgressCoalescerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        workGuard = std::make_unique<asio::executor_work_guard<asio::io_context::executor_type>>(
+            ioContext.get_executor()
+        );
+        ioThread = std::thread([this]() {
+            ioContext.run();
+        });
+    }
+
+    void TearDown() override {
+        workGuard.reset();
+        ioContext.stop();
+        if (ioThread.joinable()) {
+            ioThread.join();
+        }
+    }
+
+    asio::io_context ioContext;
+    std::unique_ptr<asio::executor_work_guard<asio::io_context::executor_type>> workGuard;
+    std::thread ioThread;
+    std::atomic<int> emits {0};
+};
+
+// The first change goes out at once, the ones within the interval are merged into one trailing emit
+TEST_F(ProgressCoalescerTest, LeadingThenOneTrailingEmit) {
+    ProgressCoalescer coalescer(ioContext, 300ms, [this]() { emits.fetch_add(1); });
+
+    coalescer.touch();
+    EXPECT_EQ(emits.load(), 1);
+    for (int i = 0; i < 50; ++i) {
+        coalescer.touch();
+    }
+    EXPECT_EQ(emits.load(), 1);
+
+    std::this_thread::sleep_for(300ms + 3 * TimerWheel::TICK);
+    EXPECT_EQ(emits.load(), 2);
+
+    // Nothing changed during the second interval, so it ends quietly
+    std::this_thread::sleep_for(300ms + 3 * TimerWheel::TICK);
+    EXPECT_EQ(emits.load(), 2);
+
+    // After a quiet interval the next change is a leading one again
+    coalescer.touch();
+    EXPECT_EQ(emits.load(), 3);
+}
+
+// A steady stream of changes is emitted about once per interval
+TEST_F(ProgressCoalescerTest, SteadyStreamIsRateLimited) {
+    ProgressCoalescer coalescer(ioContext, 200ms, [this]() { emits.fetch_add(1); });
+
+    const auto until = std::chrono::steady_clock::now() + 1s;
+    int touches = 0;
+    while (std::chrono::steady_clock::now() < until) {
+        coalescer.touch();
+        ++touches;
+        std::this_thread::sleep_for(5ms);
+    }
+    EXPECT_GT(touches, 100);
+    EXPECT_GE(emits.load(), 3);
+    EXPECT_LE(emits.load(), 7);
+}
+
+TEST_F(ProgressCoalescerTest, ZeroIntervalEmitsEveryChange) {
+    ProgressCoalescer coalescer(ioContext, 0ms, [this]() { emits.fetch_add(1); });
+    for (int i = 0; i < 10; ++i) {
+        coalescer.touch();
+    }
+    EXPECT_EQ(emits.load(), 10);
+}
+
+// flush() sends a waiting change right away, and only once
+TEST_F(ProgressCoalescerTest, FlushEmitsPendingChange) {
+    ProgressCoalescer coalescer(ioContext, 10s, [this]() { emits.fetch_add(1); });
+
+    coalescer.flush();
+    EXPECT_EQ(emits.load(), 0);
+
+    coalescer.touch();
+    coalescer.touch();
+    EXPECT_EQ(emits.load(), 1);
+    coalescer.flush();
+    EXPECT_EQ(emits.load(), 2);
+    coalescer.flush();
+    EXPECT_EQ(emits.load(), 2);
+}
+
+// A coalescer destroyed within its interval never emits again
+TEST_F(ProgressCoalescerTest, DestroyedCoalescerStaysQuiet) {
+    {
+        ProgressCoalescer coalescer(ioContext, 200ms, [this]() { emits.fetch_add(1); });
+        coalescer.touch();
+        coalescer.touch();
+    }
+    std::this_thread::sleep_for(200ms + 3 * TimerWheel::TICK);
+    EXPECT_EQ(emits.load(), 1);
+}
@@ -174,6 +174,13 @@ TEST(SerializableEventTest, NewChunkIsAllowedEvent) {
     auto jsonFalse = crow::json::load(evtFalse.json());
     ASSERT_TRUE(jsonFalse);
     EXPECT_EQ(jsonFalse["data"]["status"].b(), false);
+    EXPECT_FALSE(jsonFalse["data"].has("reason"));
+
+    SerializableEvent::NewChunkIsAllowed evtBudget{false, true};
+    auto jsonBudget = crow::json::load(evtBudget.json());
+    ASSERT_TRUE(jsonBudget);
+    EXPECT_EQ(jsonBudget["data"]["status"].b(), false);
+    EXPECT_EQ(jsonBudget["data"]["reason"].s(), "memory_budget");
 }
 
 TEST(SerializableEventTest, ChunksAreUnfrozenEvent) {
@@ -219,3 +226,227 @@ TEST(SerializableEventTest, UnknownActionEvent) {
     EXPECT_EQ(json["event"].s(), "unknown_action");
     EXPECT_EQ(json["data"]["name"].s(), "do_something");
 }
+
+// ---------------------------------------------------------------------------
+// Golden tests: the events used to be dumped from a crow::json::wvalue tree.
+// The writer must produce the same bytes: the values are compared with what
+// wvalue dumps for them, the events with the old code below. wvalue keeps the
+// keys in an unordered_map, so for whole events only the key order may differ.
+// ---------------------------------------------------------------------------
+
+#include "jsonwriter.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+namespace Reference {
+
+std::string chunkDownload(const SerializableEvent::ChunkDownload& e)
+{
+    crow::json::wvalue root = {
+        {"event", "chunk_download"},
+        {"data", {{"id", e.publicId}, {"index", e.chunkId}, {"action", e.started ? "started" : "finished"}}}
+    };
+    return root.dump();
+}
+
+std::string newChunkAvailable(const SerializableEvent::NewChunkAvailable& e)
+{
+    crow::json::wvalue root = {
+        {"event", "new_chunk"},
+        {"data", {{"index", e.chunkId}, {"size", e.size}}}
+    };
+    return root.dump();
+}
+
+std::string totalBytesCount(const SerializableEvent::TotalBytesCount& e)
+{
+    crow::json::wvalue root = {
+        {"event", "bytes_count"},
+        {"data", {{"value", e.value}, {"direction", e.in ? "from_sender" : "to_receivers"}}}
+    };
+    return root.dump();
+}
+
+std::string nameChanged(const SerializableEvent::NameChanged& e)
+{
+    crow::json::wvalue root = {
+        {"event", "name_changed"},
+        {"data", {{"id", e.publicId}, {"name", e.name}}}
+    };
+    return root.dump();
+}
+
+std::string chunksRemoved(const SerializableEvent::ChunksRemoved& e)
+{
+    crow::json::wvalue idxs;
+    size_t index = 0;
+    for (const auto& id: e.list) {
+        idxs[index++] = id;
+    }
+    crow::json::wvalue root = {
+        {"event", "chunk_removed"},
+        {"data", {{"id", std::move(idxs)}}}
+    };
+    return root.dump();
+}
+
+std::string getChunkFailure(const SerializableEvent::GetChunkFailure& e)
+{
+    crow::json::wvalue infoJson;
+    size_t counter = 0;
+    for (const auto& info: e.list) {
+        infoJson[counter]["index"] = info.index;
+        infoJson[counter]["size"] = info.size;
+        ++counter;
+    }
+    crow::json::wvalue root = {
+        {"event", "requested_chunk_not_found"},
+        {"data", {{"available", std::move(infoJson)}}}
+    };
+    return root.dump();
+}
+
+std::string newChunkIsAllowed(const SerializableEvent::NewChunkIsAllowed& e)
+{
+    crow::json::wvalue root = {
+        {"event", "new_chunk_allowed"},
+        {"data", {{"status", e.status}}}
+    };
+    if (not e.status and e.memoryBudgetExhausted) {
+        root["data"]["reason"] = "memory_budget";
+    }
+    return root.dump();
+}
+
+std::string emptyEvent(const char* name)
+{
+    crow::json::wvalue root = {
+        {"event", name},
+        {"data", crow::json::wvalue::empty_object()}
+    };
+    return root.dump();
+}
+
+} // namespace Reference
+
+// Compact JSON with the object keys sorted, the values dumped by wvalue
+std::string sortedKeys(const crow::json::rvalue& value)
+{
+    if (value.t() == crow::json::type::Object) {
+        std::vector<std::pair<std::string, std::string>> members;
+        for (const auto& member : value) {
+            members.emplace_back(crow::json::wvalue(member.key()).dump(), sortedKeys(member));
+        }
+        std::sort(members.begin(), members.end());
+        std::string out = "{";
+        for (const auto& [key, dumped] : members) {
+            out += (out.size() > 1 ? "," : "") + key + ":" + dumped;
+        }
+        return out + "}";
+    }
+    if (value.t() == crow::json::type::List) {
+        std::string out = "[";
+        for (const auto& item : value) {
+            out += (out.size() > 1 ? "," : "") + sortedKeys(item);
+        }
+        return out + "]";
+    }
+    return crow::json::wvalue(value).dump();
+}
+
+std::string sortedKeys(const std::string& json)
+{
+    const auto value = crow::json::load(json);
+    EXPECT_TRUE(value) << json;
+    return value ? sortedKeys(value) : std::string();
+}
+
+std::string writtenString(const std::string& text)
+{
+    std::string out;
+    JsonWriter(out).string(text);
+    return out;
+}
+
+std::string writtenNumber(uint64_t number)
+{
+    std::string out;
+    JsonWriter(out).number(number);
+    return out;
+}
+
+} // namespace
+
+TEST(SerializableEventGoldenTest, StringsAreEscapedAsByCrow) {
+    std::string everyByte;
+    for (int c = 0; c < 256; ++c) {
+        everyByte.push_back(static_cast<char>(c));
+    }
+    for (const std::string& text : {std::string(), std::string("plain"), std::string("q\"uo\\te"),
+                                    std::string("tab\there\r\n"), std::string("\x01\x1f\x7f", 3),
+                                    std::string("Имя файла.txt"), std::string("\"") , everyByte}) {
+        EXPECT_EQ(writtenString(text), crow::json::wvalue(text).dump());
+    }
+}
+
+TEST(SerializableEventGoldenTest, NumbersAreWrittenAsByCrow) {
+    for (uint64_t number : {uint64_t(0), uint64_t(7), uint64_t(1) << 32, std::numeric_limits<uint64_t>::max()}) {
+        EXPECT_EQ(writtenNumber(number), crow::json::wvalue(number).dump());
+    }
+}
+
+TEST(SerializableEventGoldenTest, PerChunkEventsByteForByte) {
+    EXPECT_EQ(SerializableEvent::NewChunkAvailable({3, 524288}).json(),
+              R"({"event":"new_chunk","data":{"index":3,"size":524288}})");
+    EXPECT_EQ(SerializableEvent::ChunkDownload({"pub\"id", 12, true}).json(),
+              R"({"event":"chunk_download","data":{"id":"pub\"id","index":12,"action":"started"}})");
+    EXPECT_EQ(SerializableEvent::ChunkDownload({"pub", 12, false}).json(),
+              R"({"event":"chunk_download","data":{"id":"pub","index":12,"action":"finished"}})");
+    EXPECT_EQ(SerializableEvent::TotalBytesCount({18446744073709551615ull, true}).json(),
+              R"({"event":"bytes_count","data":{"value":18446744073709551615,"direction":"from_sender"}})");
+    EXPECT_EQ(SerializableEvent::PersonalReceivedUpdated({0}).json(),
+              R"({"event":"personal_received","data":{"bytes":0}})");
+    EXPECT_EQ(SerializableEvent::ChunksRemoved({{1, 3, 7}}).json(),
+              R"({"event":"chunk_removed","data":{"id":[1,3,7]}})");
+    EXPECT_EQ(SerializableEvent::NewChunkIsAllowed({false, true}).json(),
+              R"({"event":"new_chunk_allowed","data":{"status":false,"reason":"memory_budget"}})");
+    EXPECT_EQ(SerializableEvent::UploadFinished().json(),
+              R"({"event":"upload_finished","data":{}})");
+}
+
+TEST(SerializableEventGoldenTest, EventsMatchTheWvalueDump) {
+    using namespace SerializableEvent;
+
+    for (bool started : {true, false}) {
+        const ChunkDownload e {"Zx-_9\\\n", 42, started};
+        EXPECT_EQ(sortedKeys(e.json()), sortedKeys(Reference::chunkDownload(e)));
+    }
+    for (const NewChunkAvailable& e : {NewChunkAvailable{0, 0}, NewChunkAvailable{1, 1048576}}) {
+        EXPECT_EQ(sortedKeys(e.json()), sortedKeys(Reference::newChunkAvailable(e)));
+    }
+    for (const TotalBytesCount& e : {TotalBytesCount{0, true}, TotalBytesCount{123456789012, false}}) {
+        EXPECT_EQ(sortedKeys(e.json()), sortedKeys(Reference::totalBytesCount(e)));
+    }
+    const NameChanged name {"id", "\xd0\x91o\x01b \"x\""};
+    EXPECT_EQ(sortedKeys(name.json()), sortedKeys(Reference::nameChanged(name)));
+
+    // An empty list was dumped as null
+    for (const ChunksRemoved& e : {ChunksRemoved{{}}, ChunksRemoved{{5}}, ChunksRemoved{{1, 2, 3}}}) {
+        EXPECT_EQ(sortedKeys(e.json()), sortedKeys(Reference::chunksRemoved(e)));
+    }
+    for (const GetChunkFailure& e : {GetChunkFailure{{}}, GetChunkFailure{{{1, 10}, {2, 20}}}}) {
+        EXPECT_EQ(sortedKeys(e.json()), sortedKeys(Reference::getChunkFailure(e)));
+    }
+    for (const NewChunkIsAllowed& e : {NewChunkIsAllowed{true, false}, NewChunkIsAllowed{true, true},
+                                       NewChunkIsAllowed{false, false}, NewChunkIsAllowed{false, true}}) {
+        EXPECT_EQ(sortedKeys(e.json()), sortedKeys(Reference::newChunkIsAllowed(e)));
+    }
+    EXPECT_EQ(sortedKeys(UploadFinished().json()), sortedKeys(Reference::emptyEvent("upload_finished")));
+    EXPECT_EQ(sortedKeys(Kicked().json()), sortedKeys(Reference::emptyEvent("kicked")));
+    EXPECT_EQ(sortedKeys(ChunksAreUnfrozen().json()), sortedKeys(Reference::emptyEvent("chunks_unfrozen")));
+}
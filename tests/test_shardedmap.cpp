@@ -0,0 +1,124 @@
+// Tests for ShardedMap<Key, Value, SHARDS>
+
+#include "log.h"
+#include <plog/Appenders/ConsoleAppender.h>
+
+struct PlogInit {
+    PlogInit() {
+        static plog::ConsoleAppender<plog::TxtFormatter> appender;
+        static bool initialized = false;
+        if (!initialized) {
+            plog::init(plog::none, &appender);
+            initialized = true;
+        }
+    }
+};
+static PlogInit plogInit;
+
+#include "shardedmap.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+class ShardedMapTest : public ::testing::Test {
+protected:
+    ShardedMap<std::string, std::shared_ptr<int>, 4> map;
+
+    std::shared_ptr<int> get(const std::string& key) {
+        std::shared_ptr<int> result;
+        map.visit(key, [&](const std::shared_ptr<int>& value) { result = value; });
+        return result;
+    }
+};
+
+// tryEmplace inserts once, make() is not called for a present key
+TEST_F(ShardedMapTest, TryEmplaceInsertsOnce) {
+    int makes = 0;
+    auto make = [&]() { ++makes; return std::make_shared<int>(makes); };
+
+    EXPECT_TRUE(map.tryEmplace("alpha", make));
+    EXPECT_FALSE(map.tryEmplace("alpha", make));
+    EXPECT_EQ(makes, 1);
+    EXPECT_EQ(map.size(), 1u);
+    ASSERT_NE(get("alpha"), nullptr);
+    EXPECT_EQ(*get("alpha"), 1);
+}
+
+// The inserted callback sees the value in the map, before anyone else can
+TEST_F(ShardedMapTest, InsertedCallbackGetsTheStoredValue) {
+    int* seen = nullptr;
+    EXPECT_TRUE(map.tryEmplace("alpha",
+                               []() { return std::make_shared<int>(7); },
+                               [&](std::shared_ptr<int>& value) { seen = value.get(); *value = 8; }));
+    EXPECT_EQ(seen, get("alpha").get());
+    EXPECT_EQ(*get("alpha"), 8);
+}
+
+TEST_F(ShardedMapTest, VisitMissingKeyReturnsFalse) {
+    bool called = false;
+    EXPECT_FALSE(map.visit("missing", [&](const std::shared_ptr<int>&) { called = true; }));
+    EXPECT_FALSE(called);
+}
+
+// erase hands the value out before removing it
+TEST_F(ShardedMapTest, EraseTakesTheValue) {
+    map.tryEmplace("alpha", []() { return std::make_shared<int>(1); });
+    map.tryEmplace("beta", []() { return std::make_shared<int>(2); });
+
+    std::shared_ptr<int> taken;
+    EXPECT_TRUE(map.erase("alpha", [&](std::shared_ptr<int>& value) { taken = std::move(value); }));
+    ASSERT_NE(taken, nullptr);
+    EXPECT_EQ(*taken, 1);
+    EXPECT_EQ(get("alpha"), nullptr);
+    EXPECT_EQ(map.size(), 1u);
+
+    EXPECT_FALSE(map.erase("alpha", [](std::shared_ptr<int>&) { FAIL(); }));
+    EXPECT_EQ(map.size(), 1u);
+}
+
+// forEach reaches the keys of every shard
+TEST_F(ShardedMapTest, ForEachVisitsAll) {
+    std::set<std::string> keys;
+    for (int i = 0; i < 100; ++i) {
+        keys.insert("key" + std::to_string(i));
+        map.tryEmplace("key" + std::to_string(i), [i]() { return std::make_shared<int>(i); });
+    }
+
+    std::set<std::string> visited;
+    map.forEach([&](const std::string& key, const std::shared_ptr<int>&) { visited.insert(key); });
+    EXPECT_EQ(visited, keys);
+    EXPECT_EQ(map.size(), 100u);
+}
+
+// Mixed concurrent create/get/remove leave the count equal to the contents
+TEST_F(ShardedMapTest, ConcurrentMixedOperationsKeepCountConsistent) {
+    const int numThreads = 8;
+    const int opsPerThread = 5000;
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([this, t]() {
+            for (int i = 0; i < opsPerThread; ++i) {
+                // the threads share keys, so they race on the same entries
+                const std::string key = "key" + std::to_string((i * 7 + t) % 64);
+                switch (i % 3) {
+                case 0: map.tryEmplace(key, [i]() { return std::make_shared<int>(i); }); break;
+                case 1: get(key); break;
+                case 2: map.erase(key, [](std::shared_ptr<int>&) {}); break;
+                }
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    size_t counted = 0;
+    map.forEach([&](const std::string&, const std::shared_ptr<int>&) { ++counted; });
+    EXPECT_EQ(map.size(), counted);
+}
@@ -0,0 +1,170 @@
+// Tests for Skaptcha
+
+#include "log.h"
+#include <plog/Appenders/ConsoleAppender.h>
+
+struct PlogInit {
+    PlogInit() {
+        static plog::ConsoleAppender<plog::TxtFormatter> appender;
+        static bool initialized = false;
+        if (!initialized) {
+            plog::init(plog::none, &appender);
+            initialized = true;
+        }
+    }
+};
+static PlogInit plogInit;
+
+#include "captcha/skaptcha.h"
+#include "captcha/skaptcha_backend/captcha.h"
+#include "captcha/skaptcha_backend/captcha_png.h"
+#include "captcha/skaptcha_tools.h"
+#include "captcha/token.h"
+#include "config/config.h"
+
+extern "C" {
+#include "captcha/skaptcha_backend/lodepng.h"
+}
+
+#include <gtest/gtest.h>
+#include <cctype>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// The answer is the first part of the token payload
+std::string answerFromToken(const std::string& token)
+{
+    auto parsed = skaptcha_tools::ExpiringToken::fromString(token);
+    if (parsed == nullptr) {
+        return {};
+    }
+    return skaptcha_tools::string::split(parsed->payload(), '|').at(0);
+}
+
+} // namespace
+
+// The specialized encoder writes PNGs that decode to the same pixels
+TEST(SkaptchaTest, PngEncoderRoundTrips) {
+    struct Case { unsigned width, height; unsigned seed; };
+    // the last two are wider than the 32 KB deflate window: rows and repeats beyond it are not matched
+    const Case cases[] = { {110, 90, 0}, {110, 90, 1}, {1, 1, 2}, {300, 7, 3}, {7, 300, 4},
+                           {300, 300, 5}, {40000, 3, 6} };
+
+    for (const auto& c : cases) {
+        // seed 0 is a blank image, the others are noise with long runs
+        std::vector<unsigned char> grey(c.width * c.height, 0);
+        unsigned state = c.seed;
+        for (size_t i = 0; c.seed != 0 and i < grey.size(); ++i) {
+            state = state * 1103515245u + 12345u;
+            grey[i] = (state >> 16) % 4 == 0 ? static_cast<unsigned char>(state >> 8) : grey[i ? i - 1 : 0];
+        }
+
+        size_t size = 0;
+        unsigned char* png = captcha_png_encode(grey.data(), c.width, c.height, &size);
+        ASSERT_NE(png, nullptr);
+
+        unsigned char* pixels = nullptr;
+        unsigned width = 0, height = 0;
+        EXPECT_EQ(lodepng_decode_memory(&pixels, &width, &height, png, size, LCT_GREY, 8), 0u);
+        free(png);
+        ASSERT_NE(pixels, nullptr);
+        EXPECT_EQ(width, c.width);
+        EXPECT_EQ(height, c.height);
+        EXPECT_EQ(std::vector<unsigned char>(pixels, pixels + grey.size()), grey);
+        free(pixels);
+    }
+}
+
+// The first init may come from several rendering threads at once, they all see one decoding
+TEST(SkaptchaTest, InitFromManyThreads) {
+    std::vector<int> results(8, -1);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back([&results, i] { results[i] = captcha_init(); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(results, std::vector<int>(results.size(), 0));
+}
+
+// The glyph atlas is built once, repeated init is a no-op
+TEST(SkaptchaTest, InitIsIdempotent) {
+    EXPECT_EQ(captcha_init(), 0);
+    EXPECT_EQ(captcha_init(), 0);
+}
+
+// Every captcha is a decodable grey PNG of five letters
+TEST(SkaptchaTest, GeneratesDecodablePng) {
+    for (int i = 0; i < 20; ++i) {
+        auto view = Skaptcha::instance().generate("context");
+        ASSERT_NE(view, nullptr);
+        ASSERT_FALSE(view->png.empty());
+
+        unsigned char* pixels = nullptr;
+        unsigned width = 0, height = 0;
+        ASSERT_EQ(lodepng_decode_memory(&pixels, &width, &height,
+                                        view->png.data(), view->png.size(), LCT_GREY, 8), 0u);
+        free(pixels);
+        EXPECT_EQ(width, 22u * CAPTCHA_STRING_LENGTH);
+        EXPECT_EQ(height, 90u);
+    }
+}
+
+// The answer from the token is accepted in any case, a wrong one or a foreign context is not
+TEST(SkaptchaTest, ValidatesAnswer) {
+    auto view = Skaptcha::instance().generate("context");
+    ASSERT_NE(view, nullptr);
+
+    const std::string answer = answerFromToken(view->token);
+    ASSERT_EQ(answer.size(), Skaptcha::answerLength());
+
+    std::string lower;
+    for (char ch : answer) {
+        lower.push_back(std::tolower(ch));
+    }
+
+    std::string wrong = answer;
+    wrong[0] = wrong[0] == 'A' ? 'B' : 'A';
+
+    EXPECT_TRUE(Skaptcha::instance().validate("context", view->token, answer));
+    EXPECT_TRUE(Skaptcha::instance().validate("context", view->token, lower));
+    EXPECT_FALSE(Skaptcha::instance().validate("context", view->token, wrong));
+    EXPECT_FALSE(Skaptcha::instance().validate("other", view->token, answer));
+}
+
+// The background worker fills the pool up to captcha_pool_size and refills it after use
+TEST(SkaptchaTest, PoolIsRefilled) {
+    Config::instance().setApiCaptchaPoolSize(4);
+    auto waitForPool = [](size_t count) {
+        for (int i = 0; i < 500 and Skaptcha::instance().pooledCount() < count; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return Skaptcha::instance().pooledCount();
+    };
+
+    ASSERT_NE(Skaptcha::instance().generate("context"), nullptr);
+    EXPECT_EQ(waitForPool(4), 4u);
+
+    auto view = Skaptcha::instance().generate("context");
+    ASSERT_NE(view, nullptr);
+    EXPECT_TRUE(Skaptcha::instance().validate("context", view->token, answerFromToken(view->token)));
+    EXPECT_EQ(waitForPool(4), 4u);
+}
+
+// A burst larger than the pool is served by rendering in place
+TEST(SkaptchaTest, BurstBeyondPoolIsServed) {
+    Config::instance().setApiCaptchaPoolSize(2);
+    for (int i = 0; i < 10; ++i) {
+        auto view = Skaptcha::instance().generate("burst");
+        ASSERT_NE(view, nullptr);
+        EXPECT_TRUE(Skaptcha::instance().validate("burst", view->token, answerFromToken(view->token)));
+    }
+
+    Config::instance().setApiCaptchaPoolSize(0);
+    EXPECT_NE(Skaptcha::instance().generate("burst"), nullptr);
+}
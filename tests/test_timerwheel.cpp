@@ -0,0 +1,206 @@
+// Tests for TimerWheel
+
+#include "log.h"
+#include <plog/Appenders/ConsoleAppender.h>
+
+struct PlogInit {
+    PlogInit() {
+        static plog::ConsoleAppender<plog::TxtFormatter> appender;
+        static bool initialized = false;
+        if (!initialized) {
+            plog::init(plog::none, &appender);
+            initialized = true;
+        }
+    }
+};
+static PlogInit plogInit;
+
+#include "timerwheel.h"
+#include "timercallback.h"
+
+#include <gtest/gtest.h>
+#include <asio.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+class TimerWheelTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        workGuard = std::make_unique<asio::executor_work_guard<asio::io_context::executor_type>>(
+            ioContext.get_executor()
+        );
+        ioThread = std::thread([this]() {
+            ioContext.run();
+        });
+        wheel = TimerWheel::of(ioContext);
+    }
+
+    void TearDown() override {
+        workGuard.reset();
+        ioContext.stop();
+        if (ioThread.joinable()) {
+            ioThread.join();
+        }
+    }
+
+    asio::io_context ioContext;
+    std::unique_ptr<asio::executor_work_guard<asio::io_context::executor_type>> workGuard;
+    std::thread ioThread;
+    std::shared_ptr<TimerWheel> wheel;
+};
+
+// One wheel per io_context
+TEST_F(TimerWheelTest, OfReturnsTheSameWheel) {
+    EXPECT_EQ(TimerWheel::of(ioContext), wheel);
+    asio::io_context another;
+    EXPECT_NE(TimerWheel::of(another), wheel);
+}
+
+// Fires once, never before the requested time, within a couple of ticks after it
+TEST_F(TimerWheelTest, FiresOnceNotEarly) {
+    std::atomic<int> calls {0};
+    std::atomic<int64_t> firedAfterMs {0};
+    const auto armedAt = TimerWheel::Clock::now();
+    auto entry = TimerWheel::makeEntry([&]() {
+        firedAfterMs = std::chrono::duration_cast<std::chrono::milliseconds>(TimerWheel::Clock::now() - armedAt).count();
+        calls.fetch_add(1);
+    });
+
+    wheel->arm(entry, 350ms);
+    EXPECT_TRUE(wheel->isArmed(entry));
+    EXPECT_EQ(wheel->armedCount(), 1u);
+
+    std::this_thread::sleep_for(350ms + 3 * TimerWheel::TICK);
+    EXPECT_EQ(calls.load(), 1);
+    EXPECT_GE(firedAfterMs.load(), 350);
+    EXPECT_FALSE(wheel->isArmed(entry));
+    EXPECT_EQ(wheel->armedCount(), 0u);
+}
+
+TEST_F(TimerWheelTest, CancelPreventsFiring) {
+    std::atomic<bool> called {false};
+    auto entry = TimerWheel::makeEntry([&]() { called = true; });
+
+    wheel->arm(entry, 200ms);
+    EXPECT_TRUE(wheel->cancel(entry));
+    EXPECT_FALSE(wheel->cancel(entry));
+    EXPECT_FALSE(wheel->isArmed(entry));
+
+    std::this_thread::sleep_for(500ms);
+    EXPECT_FALSE(called.load());
+}
+
+// arm() moves a pending expiry, armIfIdle() keeps it
+TEST_F(TimerWheelTest, ArmReplacesAndArmIfIdleKeeps) {
+    std::atomic<int> calls {0};
+    auto entry = TimerWheel::makeEntry([&]() { calls.fetch_add(1); });
+
+    wheel->arm(entry, 200ms);
+    EXPECT_FALSE(wheel->armIfIdle(entry, 100ms));
+    wheel->arm(entry, 800ms);
+    EXPECT_GT(wheel->remaining(entry), 600ms);
+
+    std::this_thread::sleep_for(500ms);
+    EXPECT_EQ(calls.load(), 0);
+    std::this_thread::sleep_for(600ms);
+    EXPECT_EQ(calls.load(), 1);
+}
+
+// An entry a full turn away shares its slot with a near one, but waits for its own turn
+TEST_F(TimerWheelTest, FarEntryWaitsForItsTurn) {
+    std::atomic<bool> nearCalled {false};
+    std::atomic<bool> farCalled {false};
+    auto nearEntry = TimerWheel::makeEntry([&]() { nearCalled = true; });
+    auto farEntry = TimerWheel::makeEntry([&]() { farCalled = true; });
+
+    wheel->arm(nearEntry, 200ms);
+    wheel->arm(farEntry, 200ms + TimerWheel::SLOTS * TimerWheel::TICK);
+
+    std::this_thread::sleep_for(600ms);
+    EXPECT_TRUE(nearCalled.load());
+    EXPECT_FALSE(farCalled.load());
+    EXPECT_TRUE(wheel->isArmed(farEntry));
+    EXPECT_GT(wheel->remaining(farEntry), std::chrono::seconds(50));
+    wheel->cancel(farEntry);
+}
+
+// The wheel keeps an armed entry alive after its owner has let it go
+TEST_F(TimerWheelTest, ReleasedEntryStillFires) {
+    std::atomic<bool> called {false};
+    {
+        auto entry = TimerWheel::makeEntry([&]() { called = true; });
+        wheel->arm(entry, 100ms);
+    }
+    std::this_thread::sleep_for(400ms);
+    EXPECT_TRUE(called.load());
+    EXPECT_EQ(wheel->armedCount(), 0u);
+}
+
+// A callback may arm its own entry again
+TEST_F(TimerWheelTest, CallbackCanRearm) {
+    std::atomic<int> calls {0};
+    std::shared_ptr<TimerWheel::Entry> entry;
+    entry = TimerWheel::makeEntry([&]() {
+        if (calls.fetch_add(1) < 2) {
+            wheel->arm(entry, 100ms);
+        }
+    });
+
+    wheel->arm(entry, 100ms);
+    std::this_thread::sleep_for(900ms);
+    EXPECT_EQ(calls.load(), 3);
+    EXPECT_FALSE(wheel->isArmed(entry));
+}
+
+// Reconnect storm: many threads arm and cancel at once, the armed ones all fire
+TEST_F(TimerWheelTest, ConcurrentChurn) {
+    const int numThreads = 4;
+    const int entriesPerThread = 2000;
+    std::atomic<int> calls {0};
+    std::vector<std::thread> threads;
+    std::vector<std::vector<std::shared_ptr<TimerWheel::Entry>>> kept(numThreads);
+
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < entriesPerThread; ++i) {
+                auto entry = TimerWheel::makeEntry([&]() { calls.fetch_add(1); });
+                wheel->arm(entry, std::chrono::milliseconds(100 + i % 300));
+                wheel->arm(entry, std::chrono::milliseconds(100 + i % 200));
+                if (i % 2) {
+                    wheel->cancel(entry);
+                } else {
+                    kept[t].push_back(entry);
+                }
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    EXPECT_EQ(wheel->armedCount(), size_t(numThreads * entriesPerThread / 2));
+
+    std::this_thread::sleep_for(700ms);
+    EXPECT_EQ(calls.load(), numThreads * entriesPerThread / 2);
+    EXPECT_EQ(wheel->armedCount(), 0u);
+}
+
+// A TimerCallback may outlive its io_context (the session list destroys its map last)
+TEST(TimerWheelShutdownTest, TimerOutlivesIoContext) {
+    std::atomic<bool> called {false};
+    std::unique_ptr<TimerCallback> timer;
+    {
+        asio::io_context ioContext;
+        timer = std::make_unique<TimerCallback>(ioContext, [&]() { called = true; }, std::chrono::seconds(1));
+        timer->start();
+        EXPECT_TRUE(timer->isRunning());
+    }
+    EXPECT_FALSE(timer->isRunning());
+    timer->start(); // ignored, the wheel is shut down
+    EXPECT_FALSE(timer->isRunning());
+    timer.reset();
+    EXPECT_FALSE(called.load());
+}